@@ -6,24 +6,111 @@ greaterThan(QT_MAJOR_VERSION, 6): QT += widgets
 
 CONFIG += c++17
 
+# C++ types carrying QML_ELEMENT join the Velobar QML module (res/qml), and
+# the module's QML is compiled ahead of time instead of parsed at startup
+CONFIG += qmltypes qtquickcompiler
+QML_IMPORT_NAME = Velobar
+QML_IMPORT_MAJOR_VERSION = 1
+
 SOURCES += \
     src/main.cpp \
+    src/foregroundwatcher.cpp \
+    src/barmanager.cpp \
+    src/clockprovider.cpp \
+    src/commandindex.cpp \
+    src/focustrace.cpp \
+    src/fontmanager.cpp \
     src/menuitemmodel.cpp \
     src/menucontroller.cpp \
+    src/menusnapshotcache.cpp \
+    src/menusnapshotworker.cpp \
+    src/menutree.cpp \
+    src/metrics.cpp \
+    src/networkmonitor.cpp \
+    src/noisebackground.cpp \
+    src/powermonitor.cpp \
+    src/processnamecache.cpp \
+    src/settings.cpp \
+    src/startuptrace.cpp \
+    src/systemprobe.cpp \
+    src/tickscheduler.cpp \
     src/topbarcontroller.cpp \
+    src/widgethost.cpp \
+    src/widgetregistry.cpp \
     src/windowsstructures.cpp \
+    src/windowsystem.cpp \
     src/windowsstructures.cpp
 
 HEADERS += \
+    src/barmanager.hpp \
+    src/clockprovider.hpp \
+    src/commandindex.hpp \
+    src/focustrace.hpp \
+    src/fontmanager.hpp \
+    src/foregroundwatcher.hpp \
     src/menuitemmodel.hpp \
     src/menucontroller.hpp \
+    src/menusnapshot.hpp \
+    src/menusnapshotcache.hpp \
+    src/menusnapshotworker.hpp \
+    src/menutree.hpp \
+    src/metrics.hpp \
+    src/networkmonitor.hpp \
+    src/noisebackground.hpp \
+    src/powermonitor.hpp \
+    src/processnamecache.hpp \
+    src/settings.hpp \
+    src/startuptrace.hpp \
+    src/systemprobe.hpp \
+    src/tickscheduler.hpp \
     src/topbarcontroller.hpp \
+    src/widgethost.hpp \
+    src/widgetregistry.hpp \
     src/windowsapi.hpp \
-    src/windowsstructures.hpp
+    src/windowsstructures.hpp \
+    src/windowsystem.hpp
+
+# CONFIG+=no_metrics compiles the hot-path metrics (src/metrics.hpp) out
+no_metrics: DEFINES += VELOBAR_NO_METRICS
+
+# Linux global menu: the active X11 window and its menu exported over
+# com.canonical.dbusmenu. CONFIG+=no_dbusmenu leaves Linux without a menu.
+linux:!no_dbusmenu {
+    QT += dbus
+    LIBS += -lxcb
+    DEFINES += VELOBAR_DBUSMENU
+
+    SOURCES += \
+        src/dbusmenuclient.cpp \
+        src/x11connection.cpp
+
+    HEADERS += \
+        src/dbusmenuclient.hpp \
+        src/x11connection.hpp
+}
 
 RESOURCES += \
     res/shared.qrc
 
+# Fonts ship next to the executable as fonts.rcc, a compressed resource
+# bundle FontManager maps on demand. Glyphs outside FONT_UNICODES are dropped
+# when fontTools is installed.
+FONT_UNICODES = U+0020-007E,U+00A0-00FF,U+2010-2027,U+2030-203A,U+20AC,U+2122
+FONT_FILES = $$files($$PWD/res/fonts/*.ttf)
+FONT_PYTHON = python3
+win32: FONT_PYTHON = python
+
+fontbundle.target = $$OUT_PWD/fonts.rcc
+fontbundle.depends = $$FONT_FILES $$PWD/tools/subset_fonts.py
+fontbundle.commands = $$FONT_PYTHON $$shell_path($$PWD/tools/subset_fonts.py) \
+    --unicodes $$FONT_UNICODES \
+    --rcc $$shell_path($$[QT_HOST_LIBEXECS]/rcc) \
+    --output $$shell_path($$OUT_PWD/fonts.rcc) \
+    $$shell_path($$FONT_FILES)
+QMAKE_EXTRA_TARGETS += fontbundle
+PRE_TARGETDEPS += $$OUT_PWD/fonts.rcc
+QMAKE_CLEAN += $$OUT_PWD/fonts.rcc
+
 # Windows specific
 
 
@@ -33,8 +120,12 @@ win32 {
         -lshell32 \
         -ladvapi32 \
         -lpsapi \
-        -lwbemuuid \
+        -lole32 \
         -ldwmapi \
+        -liphlpapi \
+        -lwlanapi \
+        -lpowrprof \
+        -lwtsapi32 \
         -lversion  # Add this line for version info functions
 
     DEFINES += WIN32_LEAN_AND_MEAN
@@ -0,0 +1,12 @@
+# bench.pro
+# Tools that run the menu code against FakeWindowSystem, off Windows too
+TEMPLATE = subdirs
+SUBDIRS = \
+    menubench \
+    focusreplay
+
+# Against a stub dbusmenu exporter on the session bus
+qtHaveModule(dbus): SUBDIRS += dbusmenubench
+
+# The sysfs power backend against fake power_supply trees
+linux: SUBDIRS += powercheck
@@ -0,0 +1,46 @@
+# dbusmenubench.pro
+# Cost of bringing a dbusmenu change to the bar's model: one property
+# change or one relayout against fetching the whole layout again. Needs a
+# session bus; see bench/bench.pro
+QT = core dbus
+LIBS += -lxcb
+DEFINES += VELOBAR_DBUSMENU
+CONFIG += console c++17
+CONFIG -= app_bundle
+TARGET = dbusmenubench
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    stubmenuexporter.cpp \
+    ../../src/commandindex.cpp \
+    ../../src/dbusmenuclient.cpp \
+    ../../src/focustrace.cpp \
+    ../../src/foregroundwatcher.cpp \
+    ../../src/menuitemmodel.cpp \
+    ../../src/menucontroller.cpp \
+    ../../src/menusnapshotcache.cpp \
+    ../../src/menusnapshotworker.cpp \
+    ../../src/menutree.cpp \
+    ../../src/metrics.cpp \
+    ../../src/processnamecache.cpp \
+    ../../src/windowsystem.cpp \
+    ../../src/x11connection.cpp
+
+HEADERS += \
+    stubmenuexporter.hpp \
+    ../../src/commandindex.hpp \
+    ../../src/dbusmenuclient.hpp \
+    ../../src/focustrace.hpp \
+    ../../src/foregroundwatcher.hpp \
+    ../../src/menuitemmodel.hpp \
+    ../../src/menucontroller.hpp \
+    ../../src/menusnapshot.hpp \
+    ../../src/menusnapshotcache.hpp \
+    ../../src/menusnapshotworker.hpp \
+    ../../src/menutree.hpp \
+    ../../src/metrics.hpp \
+    ../../src/processnamecache.hpp \
+    ../../src/windowsystem.hpp \
+    ../../src/x11connection.hpp
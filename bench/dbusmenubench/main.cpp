@@ -0,0 +1,272 @@
+// bench/dbusmenubench/main.cpp
+// Times how a change to an exported dbusmenu reaches the bar's model: one
+// property change, a relayout of one submenu and of the whole menu, each
+// through DBusMenuWindowSystem and MenuController, against DBusMenuClient
+// fetching the whole layout again. The menu comes from a stub exporter on
+// the session bus; run it on a private bus:
+//   dbus-run-session -- ./dbusmenubench --iterations 200
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include "dbusmenuclient.hpp"
+#include "foregroundwatcher.hpp"
+#include "menucontroller.hpp"
+#include "stubmenuexporter.hpp"
+#include "windowsystem.hpp"
+
+namespace {
+struct Scenario {
+    const char* name;
+    int width;
+    int depth;
+    int labelLength;
+};
+
+// Same menus as menubench
+const Scenario kScenarios[] = {
+    { "small", 6, 2, 10 },
+    { "medium", 10, 3, 16 },
+    { "pathological", 30, 3, 120 },
+};
+
+const uint kWindow = 1;
+const int kUpdateTimeoutMs = 5000;
+
+bool s_verbose = false;
+
+// The stub's window is not an X window, and the bench may run without a
+// display at all
+class StubWindowSystem : public DBusMenuWindowSystem {
+public:
+    bool isWindow(quintptr window) const override { return window == kWindow; }
+    QString windowTitle(quintptr) const override { return QStringLiteral("Stub"); }
+    quint32 processId(quintptr) const override { return 0; }
+};
+
+void messageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    if (type == QtDebugMsg && !s_verbose) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+qint64 percentile(QVector<qint64> values, double fraction)
+{
+    if (values.isEmpty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    int index = qBound(0, int(fraction * (values.size() - 1) + 0.5), int(values.size()) - 1);
+    return values.at(index);
+}
+
+void report(QTextStream& out, const char* scenario, const char* operation, const QVector<qint64>& nanoseconds)
+{
+    out << QString("%1 %2 %3 %4\n")
+               .arg(QString::fromLatin1(scenario), -13)
+               .arg(QString::fromLatin1(operation), -22)
+               .arg(percentile(nanoseconds, 0.5) / 1000.0, 10, 'f', 1)
+               .arg(percentile(nanoseconds, 0.95) / 1000.0, 10, 'f', 1);
+    out.flush();
+}
+
+// Runs trigger and waits until sender emits signal; -1 on timeout
+template <typename Sender, typename Signal>
+qint64 timeUntil(Sender& sender, Signal signal, const std::function<void()>& trigger)
+{
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&sender, signal, &loop, &QEventLoop::quit);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, [&loop]() { loop.exit(1); });
+
+    QElapsedTimer timer;
+    timer.start();
+    trigger();
+    timeout.start(kUpdateTimeoutMs);
+    if (loop.exec() != 0) {
+        return -1;
+    }
+    return timer.nsecsElapsed();
+}
+
+template <typename Sender, typename Signal>
+QVector<qint64> measureUpdates(int iterations, Sender& sender, Signal signal, const std::function<void()>& trigger)
+{
+    QVector<qint64> nanoseconds;
+    nanoseconds.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        qint64 elapsed = timeUntil(sender, signal, trigger);
+        if (elapsed < 0) {
+            qWarning("No update from the exporter within %d ms", kUpdateTimeoutMs);
+            break;
+        }
+        nanoseconds.append(elapsed);
+    }
+    return nanoseconds;
+}
+
+// Spins the event loop until done() holds; false on timeout
+bool waitUntil(const std::function<bool()>& done)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.elapsed() > kUpdateTimeoutMs) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+    }
+    return true;
+}
+
+bool fullyLoaded(const MenuTree& tree)
+{
+    for (qint32 i = 0; i < tree.size(); ++i) {
+        if (tree.item(i).needsChildren()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Focuses the stub's window through the whole controller and loads every
+// submenu, so the deep command the exporter changes is a shown row
+bool showMenu(MenuController& controller, FakeForegroundWatcher& watcher)
+{
+    if (timeUntil(controller, &MenuController::menuChanged, [&watcher]() {
+            watcher.setForegroundWindow(kWindow);
+        }) < 0) {
+        qWarning("The stub's menu was not shown within %d ms", kUpdateTimeoutMs);
+        return false;
+    }
+    controller.loadAllSubmenus();
+    if (!waitUntil([&controller]() { return fullyLoaded(controller.mainMenu()->tree()); })) {
+        qWarning("The stub's submenus were not loaded within %d ms", kUpdateTimeoutMs);
+        return false;
+    }
+    return true;
+}
+
+bool runScenario(QTextStream& out, const Scenario& scenario, int iterations)
+{
+    StubMenuExporter* exporter = new StubMenuExporter(scenario.width, scenario.depth, scenario.labelLength);
+    QThread exporterThread;
+    exporter->moveToThread(&exporterThread);
+    exporterThread.start();
+
+    bool started = false;
+    QMetaObject::invokeMethod(exporter, "start", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, started),
+                              Q_ARG(QString, QStringLiteral("stub-%1").arg(scenario.name)), Q_ARG(uint, kWindow));
+
+    bool ok = false;
+    if (started) {
+        AppMenuRegistrar registrar(QDBusConnection::sessionBus());
+        QString service;
+        QString path;
+        if (!registrar.menuForWindow(kWindow, service, path)) {
+            qWarning("The registrar does not know the stub's window");
+        } else {
+            DBusMenuClient client(QDBusConnection::sessionBus(), service, path);
+            ok = client.load();
+            if (ok) {
+                qDebug() << scenario.name << "menu has" << client.size() << "items";
+
+                // What a client without incremental updates pays per change
+                QVector<qint64> full;
+                QElapsedTimer timer;
+                for (int i = 0; i < iterations && ok; ++i) {
+                    timer.start();
+                    ok = client.load();
+                    full.append(timer.nsecsElapsed());
+                }
+                report(out, scenario.name, "full refetch", full);
+            }
+        }
+
+        // The rest is timed until the model has the change. Both backends
+        // are owned by the controller.
+        auto* watcher = new FakeForegroundWatcher;
+        MenuController controller(nullptr, watcher, new StubWindowSystem);
+        ok = ok && showMenu(controller, *watcher);
+        if (ok) {
+            // Only the row's state is re-read; the tree and its loaded
+            // submenus stay
+            const int command = exporter->deepCommand();
+            report(out, scenario.name, "property change",
+                   measureUpdates(iterations, *controller.mainMenu(), &QAbstractItemModel::dataChanged,
+                                  [exporter, command]() {
+                                      QMetaObject::invokeMethod(exporter, "toggleEnabled", Qt::QueuedConnection,
+                                                                Q_ARG(int, command));
+                                  }));
+
+            // A relayout takes a new capture of the menu bar
+            const int submenu = exporter->firstSubmenu();
+            if (submenu) {
+                report(out, scenario.name, "submenu relayout",
+                       measureUpdates(iterations, controller, &MenuController::menuChanged, [exporter, submenu]() {
+                           QMetaObject::invokeMethod(exporter, "relayout", Qt::QueuedConnection,
+                                                     Q_ARG(int, submenu));
+                       }));
+            }
+            report(out, scenario.name, "menu relayout",
+                   measureUpdates(iterations, controller, &MenuController::menuChanged, [exporter]() {
+                       QMetaObject::invokeMethod(exporter, "relayout", Qt::QueuedConnection, Q_ARG(int, 0));
+                   }));
+        }
+    }
+
+    QMetaObject::invokeMethod(exporter, "stop", Qt::BlockingQueuedConnection);
+    exporterThread.quit();
+    exporterThread.wait();
+    delete exporter;
+    return started && ok;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int iterations = 200;
+    const QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        if (arguments.at(i) == "--verbose") {
+            s_verbose = true;
+        } else if (arguments.at(i) == "--iterations" && i + 1 < arguments.size()) {
+            iterations = qMax(1, arguments.at(++i).toInt());
+        }
+    }
+    qInstallMessageHandler(messageHandler);
+
+    if (!QDBusConnection::sessionBus().isConnected()) {
+        std::fprintf(stderr, "No session bus; run under dbus-run-session\n");
+        return 1;
+    }
+    DBusMenuClient::registerTypes();
+
+    QTextStream out(stdout);
+    out << "Iterations per operation: " << iterations << "\n";
+    out << QString("%1 %2 %3 %4\n")
+               .arg("scenario", -13)
+               .arg("operation", -22)
+               .arg("median us", 10)
+               .arg("p95 us", 10);
+
+    for (const Scenario& scenario : kScenarios) {
+        if (!runScenario(out, scenario, iterations)) {
+            return 1;
+        }
+    }
+    return 0;
+}
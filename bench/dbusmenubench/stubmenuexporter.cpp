@@ -0,0 +1,186 @@
+// bench/dbusmenubench/stubmenuexporter.cpp
+#include "stubmenuexporter.hpp"
+#include <QDBusConnection>
+#include <QDebug>
+
+namespace {
+const char kMenuPath[] = "/MenuBar";
+const char kRegistrarService[] = "com.canonical.AppMenu.Registrar";
+const char kRegistrarPath[] = "/com/canonical/AppMenu/Registrar";
+}
+
+StubMenuExporter::StubMenuExporter(int width, int depth, int labelLength, quint32 seed)
+    : m_nextId(1)
+    , m_deepCommand(0)
+    , m_firstSubmenu(0)
+    , m_revision(1)
+    , m_registrar(nullptr)
+{
+    Item root;
+    root.properties.insert(QStringLiteral("children-display"), QStringLiteral("submenu"));
+    m_items.insert(0, root);
+    generateLevel(0, qMax(1, width), qMax(1, depth), qMax(1, labelLength), seed);
+}
+
+void StubMenuExporter::generateLevel(int parent, int width, int depth, int labelLength, quint32& seed)
+{
+    for (int i = 0; i < width; ++i) {
+        int id = m_nextId++;
+        Item item;
+        if (i % 8 == 7) {
+            item.properties.insert(QStringLiteral("type"), QStringLiteral("separator"));
+            m_items.insert(id, item);
+            m_items[parent].children.append(id);
+            continue;
+        }
+
+        // Same LCG labels as FakeWindowSystem, with a mnemonic in front
+        QString label(QLatin1Char('_'));
+        for (int c = 0; c < labelLength; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            label.append(QLatin1Char(char('a' + (seed >> 24) % 26)));
+        }
+        item.properties.insert(QStringLiteral("label"), label);
+        item.properties.insert(QStringLiteral("enabled"), true);
+        if (depth > 1) {
+            item.properties.insert(QStringLiteral("children-display"), QStringLiteral("submenu"));
+        }
+        m_items.insert(id, item);
+        m_items[parent].children.append(id);
+
+        if (depth > 1) {
+            if (parent == 0 && !m_firstSubmenu) {
+                m_firstSubmenu = id;
+            }
+            generateLevel(id, width, depth - 1, labelLength, seed);
+        } else {
+            m_deepCommand = id;
+        }
+    }
+}
+
+bool StubMenuExporter::start(const QString& connectionName, uint window)
+{
+    QDBusConnection connection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, connectionName);
+    if (!connection.isConnected()) {
+        qDebug() << "No session bus:" << connection.lastError().message();
+        return false;
+    }
+    m_connectionName = connectionName;
+
+    if (!connection.registerObject(kMenuPath, this, QDBusConnection::ExportScriptableContents)) {
+        qDebug() << "Could not export the menu";
+        return false;
+    }
+
+    m_registrar = new StubMenuRegistrar(window, connection.baseService(), kMenuPath, this);
+    if (!connection.registerObject(kRegistrarPath, m_registrar, QDBusConnection::ExportScriptableSlots)
+        || !connection.registerService(kRegistrarService)) {
+        qDebug() << "Could not register" << kRegistrarService << "- is another registrar running?";
+        return false;
+    }
+    return true;
+}
+
+void StubMenuExporter::stop()
+{
+    if (m_connectionName.isEmpty()) {
+        return;
+    }
+    {
+        QDBusConnection connection(m_connectionName);
+        connection.unregisterService(kRegistrarService);
+        connection.unregisterObject(kRegistrarPath);
+        connection.unregisterObject(kMenuPath);
+    }
+    QDBusConnection::disconnectFromBus(m_connectionName);
+    m_connectionName.clear();
+
+    delete m_registrar;
+    m_registrar = nullptr;
+}
+
+void StubMenuExporter::toggleEnabled(int id)
+{
+    auto it = m_items.find(id);
+    if (it == m_items.end()) {
+        return;
+    }
+
+    bool enabled = !it->properties.value(QStringLiteral("enabled"), true).toBool();
+    it->properties.insert(QStringLiteral("enabled"), enabled);
+
+    DBusMenuItemProperties changed;
+    changed.id = id;
+    changed.properties.insert(QStringLiteral("enabled"), enabled);
+    emit ItemsPropertiesUpdated({ changed }, {});
+}
+
+void StubMenuExporter::relayout(int parent)
+{
+    auto it = m_items.constFind(parent);
+    if (it == m_items.constEnd() || it->children.isEmpty()) {
+        return;
+    }
+
+    // Toggles a trailing marker on the label
+    int first = it->children.first();
+    QVariantMap& properties = m_items[first].properties;
+    QString label = properties.value(QStringLiteral("label")).toString();
+    label = label.endsWith(QLatin1Char('*')) ? label.chopped(1) : label + QLatin1Char('*');
+    properties.insert(QStringLiteral("label"), label);
+
+    emit LayoutUpdated(++m_revision, parent);
+}
+
+uint StubMenuExporter::GetLayout(int parentId, int recursionDepth, const QStringList&,
+                                 DBusMenuLayoutItem& layout)
+{
+    layout = this->layout(parentId, recursionDepth);
+    return m_revision;
+}
+
+DBusMenuLayoutItem StubMenuExporter::layout(int id, int depth) const
+{
+    DBusMenuLayoutItem item;
+    item.id = id;
+    auto it = m_items.constFind(id);
+    if (it == m_items.constEnd()) {
+        return item;
+    }
+    item.properties = it->properties;
+    if (depth != 0) {
+        for (int child : it->children) {
+            item.children.append(layout(child, depth - 1));
+        }
+    }
+    return item;
+}
+
+bool StubMenuExporter::AboutToShow(int)
+{
+    // Everything is exported up front
+    return false;
+}
+
+void StubMenuExporter::Event(int id, const QString& eventId, const QDBusVariant&, uint)
+{
+    qDebug() << "Menu event" << eventId << "on" << id;
+}
+
+StubMenuRegistrar::StubMenuRegistrar(uint window, const QString& service, const QString& path, QObject* parent)
+    : QObject(parent)
+    , m_window(window)
+    , m_service(service)
+    , m_path(path)
+{
+}
+
+QString StubMenuRegistrar::GetMenuForWindow(uint windowId, QDBusObjectPath& menuObjectPath)
+{
+    if (windowId != m_window) {
+        return QString();
+    }
+    menuObjectPath = QDBusObjectPath(m_path);
+    return m_service;
+}
@@ -0,0 +1,85 @@
+// bench/dbusmenubench/stubmenuexporter.hpp
+#pragma once
+
+#include <QDBusObjectPath>
+#include <QDBusVariant>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "dbusmenuclient.hpp"
+
+// A generated menu exported over com.canonical.dbusmenu, and a
+// com.canonical.AppMenu.Registrar that maps one window to it. Meant for
+// its own thread: it opens its own bus connection there, so a client's
+// calls go through the bus daemon like they would to an application.
+class StubMenuExporter : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.canonical.dbusmenu")
+
+public:
+    // Same shape as FakeWindowSystem::generateMenu()
+    StubMenuExporter(int width, int depth, int labelLength, quint32 seed = 1);
+
+    int itemCount() const { return m_items.size(); }
+    // A command on the deepest level, and the first top-level submenu
+    int deepCommand() const { return m_deepCommand; }
+    int firstSubmenu() const { return m_firstSubmenu; }
+
+public slots:
+    // Run on the exporter's thread
+    bool start(const QString& connectionName, uint window);
+    void stop();
+
+    // Greys out or re-enables one item, announced as a property change
+    void toggleEnabled(int id);
+    // Renames the first item under parent, announced as a layout change
+    // of parent; 0 is the whole menu
+    void relayout(int parent);
+
+    // com.canonical.dbusmenu
+    Q_SCRIPTABLE uint GetLayout(int parentId, int recursionDepth, const QStringList& propertyNames,
+                                DBusMenuLayoutItem& layout);
+    Q_SCRIPTABLE bool AboutToShow(int id);
+    Q_SCRIPTABLE void Event(int id, const QString& eventId, const QDBusVariant& data, uint timestamp);
+
+signals:
+    Q_SCRIPTABLE void LayoutUpdated(uint revision, int parent);
+    Q_SCRIPTABLE void ItemsPropertiesUpdated(const DBusMenuItemPropertiesList& updatedProps,
+                                             const DBusMenuItemPropertyNamesList& removedProps);
+
+private:
+    struct Item {
+        QVariantMap properties;
+        QVector<int> children;
+    };
+
+    void generateLevel(int parent, int width, int depth, int labelLength, quint32& seed);
+    DBusMenuLayoutItem layout(int id, int depth) const;
+
+private:
+    QHash<int, Item> m_items;
+    int m_nextId;
+    int m_deepCommand;
+    int m_firstSubmenu;
+    uint m_revision;
+    QString m_connectionName;
+    QObject* m_registrar;
+};
+
+// com.canonical.AppMenu.Registrar with a single window
+class StubMenuRegistrar : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.canonical.AppMenu.Registrar")
+
+public:
+    StubMenuRegistrar(uint window, const QString& service, const QString& path, QObject* parent = nullptr);
+
+public slots:
+    Q_SCRIPTABLE QString GetMenuForWindow(uint windowId, QDBusObjectPath& menuObjectPath);
+
+private:
+    uint m_window;
+    QString m_service;
+    QString m_path;
+};
@@ -0,0 +1,39 @@
+# focusreplay.pro
+# Replays a VELOBAR_RECORD_FOCUS trace through FakeWindowSystem under the
+# offscreen platform and reports focus-to-menu and focus-to-frame latency.
+QT = core gui qml quick
+CONFIG += console c++17
+CONFIG -= app_bundle
+TARGET = focusreplay
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    ../../src/commandindex.cpp \
+    ../../src/focustrace.cpp \
+    ../../src/foregroundwatcher.cpp \
+    ../../src/menuitemmodel.cpp \
+    ../../src/menucontroller.cpp \
+    ../../src/menusnapshotcache.cpp \
+    ../../src/menusnapshotworker.cpp \
+    ../../src/menutree.cpp \
+    ../../src/metrics.cpp \
+    ../../src/processnamecache.cpp \
+    ../../src/windowsystem.cpp
+
+HEADERS += \
+    ../../src/commandindex.hpp \
+    ../../src/focustrace.hpp \
+    ../../src/foregroundwatcher.hpp \
+    ../../src/menuitemmodel.hpp \
+    ../../src/menucontroller.hpp \
+    ../../src/menusnapshot.hpp \
+    ../../src/menusnapshotcache.hpp \
+    ../../src/menusnapshotworker.hpp \
+    ../../src/menutree.hpp \
+    ../../src/metrics.hpp \
+    ../../src/processnamecache.hpp \
+    ../../src/windowsystem.hpp
+
+win32: LIBS += -luser32 -lpsapi -lversion
@@ -0,0 +1,260 @@
+// bench/focusreplay/main.cpp
+// Feeds a recorded focus trace back through MenuController on a
+// FakeWindowSystem, with the menu bar drawn by a QML view on the offscreen
+// platform. Reports how long each focus change took to reach menuChanged
+// and the next rendered frame, and how many updates never made it there.
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQuickWindow>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include "focustrace.hpp"
+#include "foregroundwatcher.hpp"
+#include "menucontroller.hpp"
+#include "windowsystem.hpp"
+
+namespace {
+// Same shape as the menu row in Topbar.qml, without the rest of the bar
+const char kMenuBarQml[] = R"(
+import QtQuick
+import QtQuick.Window
+
+Window {
+    width: 1280
+    height: 32
+    visible: true
+    color: "#1e1e1e"
+
+    ListView {
+        anchors.fill: parent
+        orientation: ListView.Horizontal
+        spacing: 24
+        model: menuController.mainMenu
+        delegate: Text {
+            text: model.text
+            color: "white"
+            font.pixelSize: 13
+            height: ListView.view.height
+            verticalAlignment: Text.AlignVCenter
+            Component.onCompleted: menuController.mainMenu.delegateCreated()
+        }
+    }
+}
+)";
+
+const int kDefaultSettleMs = 1000;
+
+struct Sample {
+    qint64 focusNs = -1;
+    qint64 menuNs = -1;  // First menuChanged after the focus change
+    qint64 frameNs = -1; // First frame swapped after that
+};
+
+bool s_verbose = false;
+
+void messageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    if (type == QtDebugMsg && !s_verbose) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+// Rebuilds the recorded tree below parent as fake menus
+quint64 buildMenu(FakeWindowSystem& system, const MenuTree& tree, qint32 parent)
+{
+    quint64 menu = system.addMenu();
+    for (qint32 index = tree.firstChild(parent); index != MenuItemRecord::None;
+         index = tree.item(index).nextSibling) {
+        const MenuItemRecord& record = tree.item(index);
+        if (record.isSeparator()) {
+            system.addSeparator(menu);
+            continue;
+        }
+        // Submenus that were never opened come back empty
+        quint64 submenu = record.hasSubmenu() ? buildMenu(system, tree, index) : 0;
+        system.addItem(menu, tree.label(index), record.commandId, record.state, submenu);
+    }
+    return menu;
+}
+
+void reportLatency(QTextStream& out, const char* name, QVector<qint64> values)
+{
+    if (values.isEmpty()) {
+        out << name << ": no samples\n";
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&values](double fraction) {
+        return values.at(qBound(0, int(fraction * (values.size() - 1) + 0.5), int(values.size()) - 1))
+            / 1e6;
+    };
+    out << QString("%1: median %2 ms, p95 %3 ms, p99 %4 ms, max %5 ms (%6 samples)\n")
+               .arg(QString::fromLatin1(name))
+               .arg(at(0.5), 0, 'f', 2)
+               .arg(at(0.95), 0, 'f', 2)
+               .arg(at(0.99), 0, 'f', 2)
+               .arg(values.last() / 1e6, 0, 'f', 2)
+               .arg(values.size());
+}
+
+void usage(QTextStream& out)
+{
+    out << "Usage: focusreplay <trace> [--speed N] [--settle MS] [--verbose]\n"
+        << "  --speed N    replay N times faster than recorded; 0 sends every\n"
+        << "               focus change as soon as the event loop is free\n"
+        << "  --settle MS  time to wait after the last focus change (default "
+        << kDefaultSettleMs << ")\n";
+}
+}
+
+int main(int argc, char* argv[])
+{
+    // Headless, and frames on the GUI thread so frameSwapped needs no locking
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    qputenv("QSG_RENDER_LOOP", "basic");
+    QQuickWindow::setGraphicsApi(QSGRendererInterface::Software);
+
+    QGuiApplication app(argc, argv);
+    QStandardPaths::setTestModeEnabled(true);
+
+    QTextStream out(stdout);
+    QString tracePath;
+    double speed = 1.0;
+    int settleMs = kDefaultSettleMs;
+    const QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString& argument = arguments.at(i);
+        if (argument == "--verbose") {
+            s_verbose = true;
+        } else if (argument == "--speed" && i + 1 < arguments.size()) {
+            speed = qMax(0.0, arguments.at(++i).toDouble());
+        } else if (argument == "--settle" && i + 1 < arguments.size()) {
+            settleMs = qMax(0, arguments.at(++i).toInt());
+        } else if (tracePath.isEmpty() && !argument.startsWith("--")) {
+            tracePath = argument;
+        } else {
+            usage(out);
+            return 2;
+        }
+    }
+    qInstallMessageHandler(messageHandler);
+
+    FocusTrace trace;
+    if (tracePath.isEmpty()) {
+        usage(out);
+        return 2;
+    }
+    if (!trace.load(tracePath) || trace.events.isEmpty()) {
+        out << "No focus changes in " << tracePath << "\n";
+        return 1;
+    }
+
+    // Both are owned by the controller
+    auto* system = new FakeWindowSystem;
+    auto* watcher = new FakeForegroundWatcher;
+    QVector<quintptr> windows;
+    for (const FocusTrace::Window& window : trace.windows) {
+        quint64 menu = window.menu.isEmpty() ? 0 : buildMenu(*system, window.menu, MenuItemRecord::None);
+        windows.append(system->addWindow(QString(), window.processName, menu));
+    }
+    MenuController controller(nullptr, watcher, system);
+
+    QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("menuController", &controller);
+    engine.loadData(QByteArray(kMenuBarQml));
+    QQuickWindow* view = engine.rootObjects().isEmpty()
+        ? nullptr : qobject_cast<QQuickWindow*>(engine.rootObjects().first());
+    if (!view) {
+        out << "Failed to create the menu view\n";
+        return 1;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    QVector<Sample> samples(trace.events.size());
+    int current = -1;       // Last focus change sent
+    int awaitingFrame = -1; // Sample whose menu is not on screen yet
+    bool unrendered = false; // A menuChanged is waiting for a frame
+    int menuUpdates = 0;
+    int dropped = 0;
+    int frames = 0;
+
+    QObject::connect(&controller, &MenuController::menuChanged, &app, [&]() {
+        ++menuUpdates;
+        // The previous update was replaced before any frame showed it
+        if (unrendered) {
+            ++dropped;
+        }
+        unrendered = true;
+        if (current >= 0 && samples[current].menuNs < 0) {
+            samples[current].menuNs = clock.nsecsElapsed();
+            awaitingFrame = current;
+        }
+        // An unchanged model schedules no frame; the next one still counts
+        view->update();
+    });
+
+    QObject::connect(view, &QQuickWindow::frameSwapped, &app, [&]() {
+        ++frames;
+        unrendered = false;
+        if (awaitingFrame >= 0) {
+            samples[awaitingFrame].frameNs = clock.nsecsElapsed();
+            awaitingFrame = -1;
+        }
+    });
+
+    // Recorded times are relative to the first focus change
+    const qint64 originUs = trace.events.first().timeUs;
+    for (int i = 0; i < trace.events.size(); ++i) {
+        const FocusTrace::Event& event = trace.events.at(i);
+        int delayMs = speed > 0 ? int((event.timeUs - originUs) / 1000 / speed) : 0;
+        QTimer::singleShot(delayMs, Qt::PreciseTimer, &app, [&, i]() {
+            const FocusTrace::Event& event = trace.events.at(i);
+            quintptr window = windows.at(int(event.window));
+            system->setWindowTitle(window, event.title);
+            current = i;
+            samples[i].focusNs = clock.nsecsElapsed();
+            watcher->setForegroundWindow(window);
+
+            if (i == trace.events.size() - 1) {
+                QTimer::singleShot(settleMs, &app, &QCoreApplication::quit);
+            }
+        });
+    }
+
+    app.exec();
+
+    QVector<qint64> toMenu;
+    QVector<qint64> toFrame;
+    int coalesced = 0;
+    for (const Sample& sample : samples) {
+        if (sample.menuNs < 0) {
+            ++coalesced;
+            continue;
+        }
+        toMenu.append(sample.menuNs - sample.focusNs);
+        if (sample.frameNs >= 0) {
+            toFrame.append(sample.frameNs - sample.focusNs);
+        }
+    }
+
+    out << "Replayed " << samples.size() << " focus changes across " << trace.windows.size()
+        << " windows at " << (speed > 0 ? QString::number(speed) + "x" : QString("full speed")) << "\n";
+    reportLatency(out, "focus to menuChanged", toMenu);
+    reportLatency(out, "focus to frame", toFrame);
+    out << "Coalesced focus changes (superseded before their menu was shown): " << coalesced << "\n";
+    out << "Dropped menu updates (replaced before a frame showed them): " << dropped
+        << " of " << menuUpdates << "\n";
+    out << "Frames rendered: " << frames << "\n";
+    out << "Menu cache hit rate: " << QString::number(controller.cacheHitRate() * 100, 'f', 1) << "%\n";
+    return 0;
+}
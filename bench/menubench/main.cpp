@@ -0,0 +1,567 @@
+// bench/menubench/main.cpp
+// Times the menu paths a focus change goes through, on synthetic menus from
+// FakeWindowSystem, and counts heap allocations and peak heap use per
+// operation. Runs anywhere Qt Core does.
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "commandindex.hpp"
+#include "foregroundwatcher.hpp"
+#include "menucontroller.hpp"
+#include "menuitemmodel.hpp"
+#include "menusnapshotworker.hpp"
+#include "processnamecache.hpp"
+#include "windowsystem.hpp"
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+#include <sys/resource.h>
+#endif
+
+// Allocation accounting. Every block carries its size in a header so
+// delete can keep the live byte count without a lookup table.
+namespace {
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+std::atomic<quint64> s_allocations(0);
+std::atomic<qint64> s_liveBytes(0);
+std::atomic<qint64> s_peakBytes(0);
+
+void* countedAlloc(size_t size)
+{
+    void* block = std::malloc(size + kHeader);
+    if (!block) {
+        return nullptr;
+    }
+    std::memcpy(block, &size, sizeof(size));
+
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    qint64 live = s_liveBytes.fetch_add(qint64(size), std::memory_order_relaxed) + qint64(size);
+    qint64 peak = s_peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !s_peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return static_cast<char*>(block) + kHeader;
+}
+
+void countedFree(void* pointer)
+{
+    if (!pointer) {
+        return;
+    }
+    void* block = static_cast<char*>(pointer) - kHeader;
+    size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    s_liveBytes.fetch_sub(qint64(size), std::memory_order_relaxed);
+    std::free(block);
+}
+}
+
+void* operator new(size_t size)
+{
+    if (void* pointer = countedAlloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* pointer) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { countedFree(pointer); }
+
+namespace {
+struct Scenario {
+    const char* name;
+    int width;
+    int depth;
+    int labelLength;
+};
+
+// Small: a utility's menu bar. Medium: an office suite. Pathological: an
+// IDE with plugin submenus and very long labels.
+const Scenario kScenarios[] = {
+    { "small", 6, 2, 10 },
+    { "medium", 10, 3, 16 },
+    { "pathological", 30, 3, 120 },
+};
+
+// More windows than MenuSnapshotCache holds, so every focus change misses
+const int kColdWindows = 24;
+const int kWarmWindows = 4;
+const int kFocusTimeoutMs = 5000;
+// Executables already known to the process name cache
+const int kKnownExecutables = 200;
+
+struct Result {
+    QVector<qint64> nanoseconds;
+    quint64 allocations = 0;
+    qint64 peakBytes = 0; // Above the live bytes at the start
+};
+
+bool s_verbose = false;
+
+void messageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    if (type == QtDebugMsg && !s_verbose) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+qint64 percentile(QVector<qint64> values, double fraction)
+{
+    if (values.isEmpty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    int index = qBound(0, int(fraction * (values.size() - 1) + 0.5), int(values.size()) - 1);
+    return values.at(index);
+}
+
+// Runs operation iterations times; returns false from operation to stop
+template <typename Operation>
+Result measure(int iterations, Operation operation)
+{
+    Result result;
+    result.nanoseconds.reserve(iterations);
+
+    qint64 baseline = s_liveBytes.load();
+    s_peakBytes.store(baseline);
+    quint64 allocationsBefore = s_allocations.load();
+
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        timer.start();
+        if (!operation(i)) {
+            break;
+        }
+        result.nanoseconds.append(timer.nsecsElapsed());
+    }
+
+    quint64 runs = qMax<quint64>(1, quint64(result.nanoseconds.size()));
+    result.allocations = (s_allocations.load() - allocationsBefore) / runs;
+    result.peakBytes = s_peakBytes.load() - baseline;
+    return result;
+}
+
+void report(QTextStream& out, const char* scenario, const char* operation, const Result& result)
+{
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+               .arg(QString::fromLatin1(scenario), -13)
+               .arg(QString::fromLatin1(operation), -22)
+               .arg(percentile(result.nanoseconds, 0.5) / 1000.0, 10, 'f', 1)
+               .arg(percentile(result.nanoseconds, 0.95) / 1000.0, 10, 'f', 1)
+               .arg(result.allocations, 10)
+               .arg(result.peakBytes / 1024.0, 10, 'f', 1);
+    out.flush();
+}
+
+// Deepest key in the tree: the slowest path for resolveCommand
+QString deepestKey(const MenuTree& tree)
+{
+    qint32 deepest = MenuItemRecord::None;
+    for (qint32 i = 0; i < tree.size(); ++i) {
+        const MenuItemRecord& record = tree.item(i);
+        if (!record.isSeparator() && !record.hasSubmenu()
+            && (deepest == MenuItemRecord::None || record.level > tree.item(deepest).level)) {
+            deepest = i;
+        }
+    }
+    return deepest == MenuItemRecord::None ? QString() : tree.key(deepest);
+}
+
+// The deepest commands, spread over the tree: what palette queries look for
+QVector<qint32> queryTargets(const MenuTree& tree, int count)
+{
+    QVector<qint32> deepest;
+    int level = 0;
+    for (qint32 i = 0; i < tree.size(); ++i) {
+        const MenuItemRecord& record = tree.item(i);
+        if (record.isSeparator() || record.hasSubmenu() || record.level < level) {
+            continue;
+        }
+        if (record.level > level) {
+            level = record.level;
+            deepest.clear();
+        }
+        deepest.append(i);
+    }
+
+    QVector<qint32> targets;
+    for (int i = 0; i < count && !deepest.isEmpty(); ++i) {
+        targets.append(deepest.at(int(qint64(i) * deepest.size() / count)));
+    }
+    return targets;
+}
+
+// Times a batch of queries one by one, so each keystroke is a sample
+Result measureQueries(CommandIndex& index, const QStringList& queries, int iterations)
+{
+    Result result;
+    qint64 baseline = s_liveBytes.load();
+    s_peakBytes.store(baseline);
+    quint64 allocationsBefore = s_allocations.load();
+
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        for (const QString& query : queries) {
+            timer.start();
+            index.search(query, 50);
+            result.nanoseconds.append(timer.nsecsElapsed());
+        }
+    }
+
+    quint64 runs = qMax<quint64>(1, quint64(result.nanoseconds.size()));
+    result.allocations = (s_allocations.load() - allocationsBefore) / runs;
+    result.peakBytes = s_peakBytes.load() - baseline;
+    return result;
+}
+
+void runIndexBenchmarks(QTextStream& out, const Scenario& scenario, const FakeWindowSystem& fake,
+                        quint64 bar, const MenuTree& full, int iterations)
+{
+    report(out, scenario.name, "index build", measure(iterations, [&](int) {
+        CommandIndex index;
+        index.sync(full);
+        return index.size() == full.size();
+    }));
+
+    // The last submenu arriving after the rest of the tree was indexed
+    MenuTree partial;
+    MenuSnapshotWorker::enumerateMenu(fake, bar, partial, MenuItemRecord::None, 0, 1);
+    qint32 lastSubmenu = MenuItemRecord::None;
+    MenuTree lastChildren;
+    for (qint32 i = 0, roots = partial.size(); i < roots; ++i) {
+        const MenuItemRecord& record = partial.item(i);
+        if (!record.hasSubmenu()) {
+            continue;
+        }
+        if (lastSubmenu != MenuItemRecord::None) {
+            partial.graft(lastSubmenu, lastChildren);
+        }
+        lastChildren = MenuTree();
+        MenuSnapshotWorker::enumerateMenu(fake, record.submenu, lastChildren, MenuItemRecord::None, 1, -1);
+        lastSubmenu = i;
+    }
+
+    if (lastSubmenu != MenuItemRecord::None) {
+        Result grow;
+        quint64 allocations = 0;
+        QElapsedTimer timer;
+        for (int i = 0; i < iterations; ++i) {
+            CommandIndex index;
+            index.sync(partial);
+            MenuTree grown = partial;
+            grown.graft(lastSubmenu, lastChildren);
+
+            quint64 allocationsBefore = s_allocations.load();
+            timer.start();
+            index.sync(grown);
+            grow.nanoseconds.append(timer.nsecsElapsed());
+            allocations += s_allocations.load() - allocationsBefore;
+        }
+        grow.allocations = allocations / quint64(iterations);
+        report(out, scenario.name, "index one submenu", grow);
+    }
+
+    CommandIndex index;
+    index.sync(full);
+    const QVector<qint32> targets = queryTargets(full, 8);
+
+    // Every prefix of a command's label, as typed
+    QStringList keystrokes;
+    QStringList twoTerms;
+    QStringList typos;
+    for (qint32 target : targets) {
+        const QString label = CommandIndex::displayLabel(full.label(target)).toLower();
+        for (int length = 1; length <= qMin(8, int(label.size())); ++length) {
+            keystrokes.append(label.left(length));
+        }
+
+        qint32 parent = full.item(target).parent;
+        if (parent != MenuItemRecord::None) {
+            twoTerms.append(full.label(parent).left(3).toLower() + ' ' + label.left(4));
+        }
+
+        // Two letters swapped in the middle of a six letter prefix
+        if (label.size() >= 6) {
+            QString typo = label.left(6);
+            std::swap(typo[2], typo[3]);
+            typos.append(typo);
+        }
+    }
+
+    report(out, scenario.name, "search keystroke", measureQueries(index, keystrokes, iterations));
+    report(out, scenario.name, "search two terms", measureQueries(index, twoTerms, iterations));
+    report(out, scenario.name, "search with typo", measureQueries(index, typos, iterations));
+}
+
+// Switches focus and spins the event loop until menuChanged fired, and
+// with cached also until the worker confirmed the cached menu. Returns the
+// time to menuChanged in ns, or -1 on timeout.
+qint64 switchFocus(MenuController& controller, FakeForegroundWatcher& watcher,
+                   quintptr window, bool cached)
+{
+    QEventLoop loop;
+    QElapsedTimer timer;
+    qint64 shown = -1;
+    bool done = false;
+
+    QMetaObject::Connection menu = QObject::connect(&controller, &MenuController::menuChanged,
+        &loop, [&]() {
+            if (shown < 0) {
+                shown = timer.nsecsElapsed();
+            }
+            if (!cached) {
+                done = true;
+                loop.quit();
+            }
+        });
+    // Emitted when a snapshot is applied, after the instant cached menu
+    QMetaObject::Connection confirmed = QObject::connect(&controller, &MenuController::cacheStatsChanged,
+        &loop, [&]() {
+            if (cached && shown >= 0) {
+                done = true;
+                loop.quit();
+            }
+        });
+    QTimer::singleShot(kFocusTimeoutMs, &loop, &QEventLoop::quit);
+
+    timer.start();
+    watcher.setForegroundWindow(window);
+    if (!done) {
+        loop.exec();
+    }
+    QObject::disconnect(menu);
+    QObject::disconnect(confirmed);
+
+    return done ? shown : -1;
+}
+
+void runScenario(QTextStream& out, const Scenario& scenario, int iterations)
+{
+    FakeWindowSystem fake;
+    quint64 bar = fake.generateMenu(scenario.width, scenario.depth, scenario.labelLength);
+    quintptr window = fake.addWindow(QStringLiteral("Document"), QStringLiteral("app"), bar);
+
+    report(out, scenario.name, "enumerate full tree", measure(iterations, [&](int) {
+        MenuTree tree;
+        MenuSnapshotWorker::enumerateMenu(fake, bar, tree, MenuItemRecord::None, 0, -1);
+        return tree.size() > 0;
+    }));
+
+    report(out, scenario.name, "enumerate top level", measure(iterations, [&](int) {
+        return !MenuSnapshotWorker::getWindowMenuItems(fake, window).isEmpty();
+    }));
+
+    MenuTree full;
+    MenuSnapshotWorker::enumerateMenu(fake, bar, full, MenuItemRecord::None, 0, -1);
+    MenuTree other;
+    quint64 otherBar = fake.generateMenu(scenario.width, scenario.depth, scenario.labelLength, 7);
+    MenuSnapshotWorker::enumerateMenu(fake, otherBar, other, MenuItemRecord::None, 0, -1);
+
+    // Alternating trees so every update is a real diff
+    MenuItemModel model;
+    report(out, scenario.name, "model setTree", measure(iterations, [&](int i) {
+        model.setTree(i % 2 ? full : other);
+        return true;
+    }));
+
+    const QVector<MenuTree::KeySegment> path = MenuTree::splitKey(deepestKey(full));
+    report(out, scenario.name, "resolve command", measure(iterations, [&](int) {
+        quint32 commandId = 0;
+        return MenuController::resolveCommand(fake, bar, path, 0, commandId);
+    }));
+
+    // What hovering the bar and opening a submenu re-read, against the
+    // enumerations above
+    MenuStateProbe barProbe;
+    for (qint32 i = full.firstChild(MenuItemRecord::None); i != MenuItemRecord::None; i = full.item(i).nextSibling) {
+        barProbe.hashes.append(full.stateHash(i));
+    }
+    report(out, scenario.name, "read bar state", measure(iterations, [&](int) {
+        QVector<MenuStateChange> changes;
+        return MenuSnapshotWorker::readMenuState(fake, window, barProbe, changes);
+    }));
+
+    qint32 submenu = full.firstChild(MenuItemRecord::None);
+    while (submenu != MenuItemRecord::None && !full.item(submenu).hasSubmenu()) {
+        submenu = full.item(submenu).nextSibling;
+    }
+    if (submenu != MenuItemRecord::None) {
+        MenuStateProbe submenuProbe;
+        submenuProbe.key = full.key(submenu);
+        submenuProbe.menu = full.item(submenu).submenu;
+        for (qint32 i = full.firstChild(submenu); i != MenuItemRecord::None; i = full.item(i).nextSibling) {
+            submenuProbe.hashes.append(full.stateHash(i));
+        }
+        report(out, scenario.name, "read submenu state", measure(iterations, [&](int) {
+            QVector<MenuStateChange> changes;
+            return MenuSnapshotWorker::readMenuState(fake, window, submenuProbe, changes);
+        }));
+    }
+
+    runIndexBenchmarks(out, scenario, fake, bar, full, iterations);
+
+    // Focus changes through the whole controller: watcher, worker thread,
+    // cache and model. Both backends are owned by the controller.
+    auto* system = new FakeWindowSystem;
+    auto* watcher = new FakeForegroundWatcher;
+    QVector<quintptr> windows;
+    for (int i = 0; i < kColdWindows; ++i) {
+        quint64 menu = system->generateMenu(scenario.width, scenario.depth, scenario.labelLength, i + 1);
+        windows.append(system->addWindow(QString("Window %1").arg(i), QString("app%1").arg(i), menu));
+    }
+
+    MenuController controller(nullptr, watcher, system);
+
+    // Cycling through more windows than the cache holds: capture every time
+    report(out, scenario.name, "focus change, cold", measure(iterations, [&](int i) {
+        return switchFocus(controller, *watcher, windows.at(i % kColdWindows), false) >= 0;
+    }));
+
+    // Prime the cache, then time until the cached menu is shown. The
+    // worker's confirmation is waited for but not timed. Refocusing the
+    // current window is not a change, so it is skipped.
+    for (int i = 0; i < kWarmWindows; ++i) {
+        if (windows.at(i) != watcher->foregroundWindow()) {
+            switchFocus(controller, *watcher, windows.at(i), false);
+        }
+    }
+    QVector<qint64> warm;
+    warm.reserve(iterations);
+    Result warmResult = measure(iterations, [&](int i) {
+        qint64 elapsed = switchFocus(controller, *watcher, windows.at(i % kWarmWindows), true);
+        if (elapsed < 0) {
+            return false;
+        }
+        warm.append(elapsed);
+        return true;
+    });
+    warmResult.nanoseconds = warm;
+    report(out, scenario.name, "focus change, cached", warmResult);
+}
+
+// A process name cache hit against a miss, which asks the window system
+// to describe the executable and inserts the answer, and against the
+// file write a miss schedules. The fake describes an executable by its
+// file name; on Windows a miss also parses the version resource, so the
+// miss row is a lower bound there.
+void runProcessNameBenchmarks(QTextStream& out, int iterations)
+{
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        qWarning("No temporary directory for the process name cache");
+        return;
+    }
+
+    FakeWindowSystem fake;
+    ProcessNameCache cache(directory.filePath(QStringLiteral("process-names.cache")));
+    for (int i = 0; i < kKnownExecutables; ++i) {
+        QString path = QString("/fake/known%1.exe").arg(i);
+        cache.insert(path, 0, fake.describeExecutable(path));
+    }
+    cache.save();
+
+    report(out, "process", "name cache hit", measure(iterations, [&](int i) {
+        QString name;
+        return cache.lookup(QString("/fake/known%1.exe").arg(i % kKnownExecutables), 0, name);
+    }));
+
+    report(out, "process", "name cache miss", measure(iterations, [&](int i) {
+        QString path = QString("/fake/new%1.exe").arg(i);
+        QString name;
+        if (cache.lookup(path, 0, name)) {
+            return false;
+        }
+        cache.insert(path, 0, fake.describeExecutable(path));
+        return true;
+    }));
+
+    report(out, "process", "name cache save", measure(iterations, [&](int i) {
+        QString path = QString("/fake/saved%1.exe").arg(i);
+        cache.insert(path, 0, fake.describeExecutable(path));
+        return cache.save();
+    }));
+}
+
+qint64 maxResidentKb()
+{
+#if defined(Q_OS_LINUX)
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? qint64(usage.ru_maxrss) : 0;
+#elif defined(Q_OS_MACOS)
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? qint64(usage.ru_maxrss) / 1024 : 0;
+#else
+    return 0;
+#endif
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    // Keeps ProcessNameCache away from the real cache file
+    QStandardPaths::setTestModeEnabled(true);
+
+    int iterations = 200;
+    const QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        if (arguments.at(i) == "--verbose") {
+            s_verbose = true;
+        } else if (arguments.at(i) == "--iterations" && i + 1 < arguments.size()) {
+            iterations = qMax(1, arguments.at(++i).toInt());
+        }
+    }
+    qInstallMessageHandler(messageHandler);
+
+    QTextStream out(stdout);
+    out << "Iterations per operation: " << iterations << "\n";
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+               .arg("scenario", -13)
+               .arg("operation", -22)
+               .arg("median us", 10)
+               .arg("p95 us", 10)
+               .arg("allocs/op", 10)
+               .arg("peak KiB", 10);
+
+    for (const Scenario& scenario : kScenarios) {
+        runScenario(out, scenario, iterations);
+    }
+    runProcessNameBenchmarks(out, iterations);
+
+    if (qint64 rss = maxResidentKb()) {
+        out << "Max resident set: " << rss << " KiB\n";
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+# menubench.pro
+# Menu enumeration and model update benchmarks against FakeWindowSystem.
+# Builds on any platform; see bench/bench.pro
+QT = core
+CONFIG += console c++17
+CONFIG -= app_bundle
+TARGET = menubench
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    ../../src/commandindex.cpp \
+    ../../src/focustrace.cpp \
+    ../../src/foregroundwatcher.cpp \
+    ../../src/menuitemmodel.cpp \
+    ../../src/menucontroller.cpp \
+    ../../src/menusnapshotcache.cpp \
+    ../../src/menusnapshotworker.cpp \
+    ../../src/menutree.cpp \
+    ../../src/metrics.cpp \
+    ../../src/processnamecache.cpp \
+    ../../src/windowsystem.cpp
+
+HEADERS += \
+    ../../src/commandindex.hpp \
+    ../../src/focustrace.hpp \
+    ../../src/foregroundwatcher.hpp \
+    ../../src/menuitemmodel.hpp \
+    ../../src/menucontroller.hpp \
+    ../../src/menusnapshot.hpp \
+    ../../src/menusnapshotcache.hpp \
+    ../../src/menusnapshotworker.hpp \
+    ../../src/menutree.hpp \
+    ../../src/metrics.hpp \
+    ../../src/processnamecache.hpp \
+    ../../src/windowsystem.hpp
+
+win32: LIBS += -luser32 -lpsapi -lversion
@@ -0,0 +1,190 @@
+// bench/powercheck/main.cpp
+// Runs SysfsPowerMonitor over fake power_supply trees in a temporary
+// directory and checks the PowerState it reports: mains with a battery,
+// a battery alone, a peripheral battery beside the system one, and no
+// battery at all. Exits non-zero on the first mismatch.
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cstdio>
+#include "powermonitor.hpp"
+
+namespace {
+bool s_verbose = false;
+
+void messageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    if (type == QtDebugMsg && !s_verbose) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+// Rewrites in place: the monitor keeps the file open and re-reads it
+bool writeAttribute(const QDir& root, const QString& supply, const QString& name, const QByteArray& value)
+{
+    if (!root.mkpath(supply)) {
+        return false;
+    }
+    QFile file(root.filePath(supply + QLatin1Char('/') + name));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(value + '\n') == value.size() + 1;
+}
+
+bool addMains(const QDir& root, const QString& name, bool online)
+{
+    return writeAttribute(root, name, "type", "Mains")
+        && writeAttribute(root, name, "online", online ? "1" : "0");
+}
+
+bool addBattery(const QDir& root, const QString& name, int capacity, const QByteArray& status,
+                bool peripheral = false)
+{
+    return writeAttribute(root, name, "type", "Battery")
+        && writeAttribute(root, name, "capacity", QByteArray::number(capacity))
+        && writeAttribute(root, name, "status", status)
+        && (!peripheral || writeAttribute(root, name, "scope", "Device"));
+}
+
+class Checker {
+public:
+    explicit Checker(QTextStream& out)
+        : m_out(out)
+        , m_failures(0)
+    {
+    }
+
+    void expect(const char* scenario, const char* step, const PowerState& actual, bool onBattery, int level)
+    {
+        bool ok = actual.onBattery == onBattery && actual.level == level;
+        m_out << QString("%1 %2 %3\n")
+                     .arg(QString::fromLatin1(scenario), -13)
+                     .arg(QString::fromLatin1(step), -28)
+                     .arg(ok ? QStringLiteral("ok")
+                             : QString("FAIL: got onBattery=%1 level=%2, want onBattery=%3 level=%4")
+                                   .arg(int(actual.onBattery))
+                                   .arg(actual.level)
+                                   .arg(int(onBattery))
+                                   .arg(level));
+        m_out.flush();
+        if (!ok) {
+            ++m_failures;
+        }
+    }
+
+    int failures() const { return m_failures; }
+
+private:
+    QTextStream& m_out;
+    int m_failures;
+};
+
+// A fresh tree per scenario; false when it could not be written
+bool runMains(Checker& check)
+{
+    QTemporaryDir directory;
+    QDir root(directory.path());
+    if (!directory.isValid() || !addMains(root, "AC", true) || !addBattery(root, "BAT0", 80, "Charging")) {
+        return false;
+    }
+
+    SysfsPowerMonitor monitor(nullptr, root.path());
+    monitor.rescan();
+    check.expect("mains", "plugged in", monitor.state(), false, 80);
+
+    // Unplugging goes by the mains supply, whatever the battery says
+    if (!writeAttribute(root, "AC", "online", "0") || !writeAttribute(root, "BAT0", "capacity", "79")) {
+        return false;
+    }
+    monitor.evaluate();
+    check.expect("mains", "unplugged, re-read in place", monitor.state(), true, 79);
+    return true;
+}
+
+bool runBatteryOnly(Checker& check)
+{
+    QTemporaryDir directory;
+    QDir root(directory.path());
+    if (!directory.isValid() || !addBattery(root, "BAT0", 55, "Discharging")
+        || !addBattery(root, "BAT1", 45, "Unknown")) {
+        return false;
+    }
+
+    // Without a mains supply the battery status decides; levels average
+    SysfsPowerMonitor monitor(nullptr, root.path());
+    monitor.rescan();
+    check.expect("battery-only", "discharging", monitor.state(), true, 50);
+
+    if (!writeAttribute(root, "BAT0", "status", "Charging")) {
+        return false;
+    }
+    monitor.evaluate();
+    check.expect("battery-only", "charging", monitor.state(), false, 50);
+    return true;
+}
+
+bool runPeripheral(Checker& check)
+{
+    QTemporaryDir directory;
+    QDir root(directory.path());
+    if (!directory.isValid() || !addMains(root, "AC", true) || !addBattery(root, "BAT0", 90, "Full")
+        || !addBattery(root, "hidpp_battery_0", 10, "Discharging", true)) {
+        return false;
+    }
+
+    // The mouse's battery neither lowers the level nor counts as discharging
+    SysfsPowerMonitor monitor(nullptr, root.path());
+    monitor.rescan();
+    check.expect("peripheral", "system battery only", monitor.state(), false, 90);
+    return true;
+}
+
+bool runNoBattery(Checker& check)
+{
+    QTemporaryDir directory;
+    QDir root(directory.path());
+    if (!directory.isValid() || !addMains(root, "AC", true)
+        || !addBattery(root, "hidpp_battery_0", 30, "Discharging", true)) {
+        return false;
+    }
+
+    // A desktop: full and on mains, even unplugged
+    SysfsPowerMonitor monitor(nullptr, root.path());
+    monitor.rescan();
+    check.expect("no-battery", "mains online", monitor.state(), false, 100);
+
+    if (!writeAttribute(root, "AC", "online", "0")) {
+        return false;
+    }
+    monitor.evaluate();
+    check.expect("no-battery", "mains offline", monitor.state(), false, 100);
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        if (arguments.at(i) == "--verbose") {
+            s_verbose = true;
+        }
+    }
+    qInstallMessageHandler(messageHandler);
+
+    QTextStream out(stdout);
+    Checker check(out);
+    bool written = runMains(check) && runBatteryOnly(check) && runPeripheral(check) && runNoBattery(check);
+    if (!written) {
+        std::fprintf(stderr, "Could not write a fake power_supply tree\n");
+        return 2;
+    }
+    return check.failures() ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+# powercheck.pro
+# SysfsPowerMonitor against fake /sys/class/power_supply trees. Linux
+# only; see bench/bench.pro
+QT = core qml
+CONFIG += console c++17
+CONFIG -= app_bundle
+TARGET = powercheck
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    ../../src/metrics.cpp \
+    ../../src/powermonitor.cpp \
+    ../../src/systemprobe.cpp \
+    ../../src/tickscheduler.cpp
+
+HEADERS += \
+    ../../src/metrics.hpp \
+    ../../src/powermonitor.hpp \
+    ../../src/systemprobe.hpp \
+    ../../src/tickscheduler.hpp
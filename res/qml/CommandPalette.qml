@@ -0,0 +1,160 @@
+// CommandPalette.qml
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+import QtQuick.Window
+
+// Keyboard search over every command in the active application's menus,
+// submenus included. Enter runs the selected command the same way a click
+// on the bar does.
+Window {
+    id: palette
+    flags: Qt.Tool | Qt.FramelessWindowHint | Qt.WindowStaysOnTopHint
+    color: "transparent"
+    width: 560
+    height: frame.height
+    visible: false
+
+    property var results: []
+    readonly property string regularFamily: fontManager.family("Regular")
+
+    function open(barWindow) {
+        x = barWindow.x + (barWindow.width - width) / 2
+        y = barWindow.y + barWindow.height + 80
+        queryField.text = ""
+        results = []
+        // Indexed as the submenus arrive; results refresh on their own
+        menuController.loadAllSubmenus()
+        show()
+        raise()
+        requestActivate()
+        queryField.forceActiveFocus()
+    }
+
+    function search() {
+        results = menuController.searchCommands(queryField.text, 50)
+        resultList.currentIndex = 0
+    }
+
+    function runSelected() {
+        if (resultList.currentIndex < 0 || resultList.currentIndex >= results.length) {
+            return
+        }
+        var result = results[resultList.currentIndex]
+        if (!result.enabled) {
+            return
+        }
+        palette.hide()
+        menuController.triggerMenuItem(result.key)
+    }
+
+    onActiveChanged: {
+        if (!active && visible) {
+            hide()
+        }
+    }
+
+    Connections {
+        target: menuController
+        enabled: palette.visible
+        function onCommandsChanged() {
+            if (queryField.text.length > 0) {
+                palette.search()
+            }
+        }
+    }
+
+    Rectangle {
+        id: frame
+        width: parent.width
+        height: column.implicitHeight + 16
+        color: "#f01e1e1e"
+        radius: 8
+        border.color: "#28949494"
+        border.width: 1
+
+        ColumnLayout {
+            id: column
+            anchors.left: parent.left
+            anchors.right: parent.right
+            anchors.top: parent.top
+            anchors.margins: 8
+            spacing: 6
+
+            TextField {
+                id: queryField
+                Layout.fillWidth: true
+                placeholderText: "Search commands"
+                color: "white"
+                font.pixelSize: 14
+                font.family: palette.regularFamily
+                background: Rectangle {
+                    color: "#20ffffff"
+                    radius: 4
+                }
+
+                onTextChanged: palette.search()
+                Keys.onUpPressed: resultList.decrementCurrentIndex()
+                Keys.onDownPressed: resultList.incrementCurrentIndex()
+                Keys.onReturnPressed: palette.runSelected()
+                Keys.onEnterPressed: palette.runSelected()
+                Keys.onEscapePressed: palette.hide()
+            }
+
+            ListView {
+                id: resultList
+                Layout.fillWidth: true
+                Layout.preferredHeight: Math.min(contentHeight, 360)
+                visible: count > 0
+                clip: true
+                model: palette.results
+
+                delegate: Rectangle {
+                    width: ListView.view.width
+                    height: 32
+                    radius: 4
+                    color: ListView.isCurrentItem ? "#30ffffff" : "transparent"
+                    opacity: modelData.enabled ? 1.0 : 0.5
+
+                    RowLayout {
+                        anchors.fill: parent
+                        anchors.leftMargin: 8
+                        anchors.rightMargin: 8
+                        spacing: 8
+
+                        Label {
+                            text: modelData.label
+                            color: "white"
+                            font.pixelSize: 13
+                            font.family: palette.regularFamily
+                        }
+
+                        // Menus above the command
+                        Label {
+                            Layout.fillWidth: true
+                            text: modelData.path
+                            color: "#a0ffffff"
+                            font.pixelSize: 12
+                            font.family: palette.regularFamily
+                            elide: Text.ElideLeft
+                        }
+
+                        Label {
+                            text: modelData.shortcut
+                            color: "#a0ffffff"
+                            font.pixelSize: 12
+                            font.family: palette.regularFamily
+                        }
+                    }
+
+                    MouseArea {
+                        anchors.fill: parent
+                        hoverEnabled: true
+                        onEntered: resultList.currentIndex = index
+                        onClicked: palette.runSelected()
+                    }
+                }
+            }
+        }
+    }
+}
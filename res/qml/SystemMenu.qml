@@ -64,6 +64,7 @@ Window {
 
             Repeater {
                 model: [
+                    { text: "Search Commands", action: "commands" },
                     { text: "Settings", action: "settings" },
                     { text: "Task Manager", action: "taskmanager" },
                     { text: "", separator: true },
@@ -110,6 +111,9 @@ Window {
                                     mainWindow.visible = false
                                 }
                                 switch(modelData.action) {
+                                    case "commands":
+                                        topbarController.showCommandPalette()
+                                        break
                                     case "settings":
                                         topbarController.openSettings()
                                         break
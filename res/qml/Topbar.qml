@@ -0,0 +1,117 @@
+// qml/Topbar.qml
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+import QtQuick.Window
+import Velobar 1.0
+
+Window {
+    id: topbarWindow
+    visible: true
+    flags: Qt.FramelessWindowHint | Qt.WindowStaysOnTopHint
+    color: topbarController.settings.baseColor  // Transparent by default to show the background effect
+
+    property bool animateNoiseOnHover: false
+
+    MouseArea {
+        anchors.fill: parent
+        onClicked: topbarController.handleTopbarClick()
+    }
+
+    // Background with a static grain texture. It only animates while
+    // hovered, and only if animateNoiseOnHover is set, so an idle bar renders
+    // no frames.
+    NoiseBackground {
+        id: background
+        anchors.fill: parent
+        color: topbarController.blur_supported ? "#2f1e1e1e" : "#991e1e1e"
+        strength: 0.03
+
+        HoverHandler {
+            id: barHover
+            enabled: topbarWindow.animateNoiseOnHover
+        }
+
+        TickTimer {
+            scheduler: tickScheduler
+            name: "noise"
+            interval: 50
+            running: topbarWindow.animateNoiseOnHover && barHover.hovered
+            onTriggered: background.phase += 1
+        }
+    }
+
+    // Bottom border
+    Rectangle {
+        id: bottomBorder
+        height: topbarController.settings.borderWidth
+        color: topbarController.settings.borderColor
+        width: parent.width
+        anchors.bottom: parent.bottom
+    }
+
+    // Main content; the theme's widgets are created into it in the
+    // background, after the first frame
+    RowLayout {
+        id: content
+        anchors.fill: parent
+        anchors.leftMargin: 10
+        anchors.rightMargin: 10
+        anchors.bottomMargin: bottomBorder.height  // Account for bottom border
+        spacing: 8
+    }
+
+    WidgetHost {
+        container: content
+        registry: topbarController.widgets
+        widgets: topbarController.settings.widgets
+    }
+
+    CommandPalette {
+        id: commandPalette
+    }
+
+    // Handle window position changes; every screen's bar hears them all
+    Connections {
+        target: topbarController
+        function onWindowPosChanged(window, x, y, width, height) {
+            if (window !== topbarWindow) {
+                return
+            }
+            topbarWindow.x = x
+            topbarWindow.y = y
+            topbarWindow.width = width
+            topbarWindow.height = height
+        }
+    }
+
+    // Only the bar the palette was asked for opens it
+    Connections {
+        target: topbarController
+        function onCommandPaletteRequested(window) {
+            if (window === topbarWindow) {
+                commandPalette.open(topbarWindow)
+            }
+        }
+    }
+
+    // Handle menu updates
+    Connections {
+        target: menuController
+        function onMenuChanged(window, app, itemCount) {
+            console.log("Menu updated:", app, itemCount + " items")
+        }
+    }
+
+    // Drop shadow for bottom border
+    Rectangle {
+        id: bottomShadow
+        height: 4
+        width: parent.width
+        anchors.top: bottomBorder.bottom
+        gradient: Gradient {
+            GradientStop { position: 0.0; color: "#40000000" }
+            GradientStop { position: 1.0; color: "#00000000" }
+        }
+    }
+}
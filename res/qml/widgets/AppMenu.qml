@@ -0,0 +1,73 @@
+// qml/widgets/AppMenu.qml
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+
+// The active window's menu; takes the width the other widgets leave
+ScrollView {
+    id: appMenu
+    Layout.fillWidth: true
+    Layout.fillHeight: true
+    Layout.alignment: Qt.AlignVCenter
+    clip: true
+
+    readonly property string regularFamily: fontManager.family("Regular")
+
+    // The focused window may have greyed or checked items since its menu
+    // was read; hovering the bar re-reads just their states
+    HoverHandler {
+        onHoveredChanged: {
+            if (hovered) {
+                menuController.refreshMenuState()
+            }
+        }
+    }
+
+    ListView {
+        id: menuListView
+        orientation: ListView.Horizontal
+        spacing: 24
+        model: menuController.mainMenu
+
+        delegate: Label {
+            text: model.text
+            color: "white"
+            font.pixelSize: 13
+            font.family: appMenu.regularFamily
+            font.weight: Font.Normal
+            opacity: enabled ? (menuArea.containsMouse ? 1.0 : 0.9) : 0.5
+            enabled: (model.menuState & 0x3) === 0  // MFS_GRAYED / MFS_DISABLED
+            height: menuListView.height
+            verticalAlignment: Text.AlignVCenter
+
+            Component.onCompleted: menuController.mainMenu.delegateCreated()
+
+            MouseArea {
+                id: menuArea
+                anchors.fill: parent
+                hoverEnabled: true
+                cursorShape: enabled ? Qt.PointingHandCursor : Qt.ArrowCursor
+
+                // Load the submenu before it can be opened, or bring the
+                // states of an already loaded one up to date
+                onEntered: {
+                    menuController.prefetchSubmenu(model.key)
+                    menuController.refreshMenuState(model.key)
+                }
+
+                onClicked: {
+                    if (enabled) {
+                        menuController.triggerMenuItem(model.key)
+                    }
+                }
+
+                Rectangle {
+                    anchors.fill: parent
+                    color: "#ffffff"
+                    opacity: parent.containsMouse && parent.enabled ? 0.1 : 0
+                    radius: 3
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,22 @@
+// qml/widgets/AppName.qml
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+
+// Active process name
+Label {
+    text: menuController.activeApp
+    color: "white"
+    font.pixelSize: 13
+    font.family: fontManager.family("Bold")
+    font.weight: Font.Bold
+    Layout.leftMargin: 4
+    Layout.alignment: Qt.AlignVCenter
+
+    MouseArea {
+        anchors.fill: parent
+        hoverEnabled: true
+        onEntered: parent.opacity = 0.8
+        onExited: parent.opacity = 1.0
+    }
+}
@@ -0,0 +1,35 @@
+// qml/widgets/Battery.qml
+import QtQuick
+import QtQuick.Layouts
+
+// Only shown while running on battery
+Rectangle {
+    implicitWidth: 24
+    implicitHeight: 13
+    visible: topbarController.isOnBattery
+    color: "transparent"
+    border.color: "#ffffff"
+    border.width: 1
+    radius: 2
+    Layout.rightMargin: 8
+    Layout.alignment: Qt.AlignVCenter
+
+    Rectangle {
+        anchors.left: parent.left
+        anchors.leftMargin: 2
+        anchors.verticalCenter: parent.verticalCenter
+        width: (parent.width - 4) * (topbarController.batteryLevel / 100)
+        height: parent.height - 4
+        color: topbarController.batteryLevel > 20 ? "#4cd964" : "#ff3b30"
+        radius: 1
+    }
+
+    Rectangle {
+        anchors.left: parent.right
+        anchors.verticalCenter: parent.verticalCenter
+        width: 3
+        height: 6
+        color: "#ffffff"
+        radius: 1
+    }
+}
@@ -0,0 +1,12 @@
+// qml/widgets/Clock.qml
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+
+Label {
+    color: "white"
+    font.pixelSize: 12
+    font.family: fontManager.family("Regular")
+    Layout.alignment: Qt.AlignVCenter
+    text: topbarController.clock.time
+}
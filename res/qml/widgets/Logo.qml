@@ -0,0 +1,41 @@
+// qml/widgets/Logo.qml
+import QtQuick
+import QtQuick.Layouts
+import Velobar 1.0
+
+Item {
+    implicitWidth: 20
+    implicitHeight: 20
+    Layout.alignment: Qt.AlignVCenter
+
+    Image {
+        id: logoImage
+        width: 18
+        height: 18
+        source: "qrc:/vector/logo.svg"
+        anchors.fill: parent
+        mipmap: true
+        opacity: logoArea.containsMouse ? 0.8 : 1.0
+    }
+
+    MouseArea {
+        id: logoArea
+        anchors.fill: parent
+        hoverEnabled: true
+        cursorShape: Qt.PointingHandCursor
+
+        onClicked: {
+            if (logoMenu.visible) {
+                logoMenu.hide()
+            } else {
+                var globalPos = logoArea.mapToGlobal(0, 0)
+                logoMenu.show(globalPos.x, globalPos.y + height)
+            }
+        }
+    }
+
+    SystemMenu {
+        id: logoMenu
+        visible: false
+    }
+}
@@ -0,0 +1,30 @@
+// qml/widgets/Network.qml
+import QtQuick
+import QtQuick.Layouts
+
+Item {
+    implicitWidth: 16
+    implicitHeight: 16
+    Layout.alignment: Qt.AlignVCenter
+
+    Image {
+        id: networkIcon
+        anchors.fill: parent
+        fillMode: Image.PreserveAspectFit
+        source: {
+            if (topbarController.isEthernet) {
+                return "qrc:/vector/ethernet.svg"
+            } else {
+                switch(topbarController.wifiStrength) {
+                    case 1: return "qrc:/vector/wifi_lv1.svg"
+                    case 2: return "qrc:/vector/wifi_lv2.svg"
+                    case 3: return "qrc:/vector/wifi_lv3.svg"
+                    case 4: return "qrc:/vector/wifi_lv4.svg"
+                    default: return "qrc:/vector/wifi_lv1.svg"
+                }
+            }
+        }
+        mipmap: true
+        opacity: 0.9
+    }
+}
@@ -0,0 +1,13 @@
+// qml/widgets/Separator.qml
+import QtQuick
+import QtQuick.Layouts
+
+Rectangle {
+    Layout.leftMargin: 8
+    Layout.rightMargin: 8
+    Layout.preferredWidth: 1
+    Layout.preferredHeight: 14
+    Layout.alignment: Qt.AlignVCenter
+    color: "#ffffff"
+    opacity: 0.2
+}
@@ -0,0 +1,90 @@
+// src/barmanager.cpp
+#include "barmanager.hpp"
+#include "topbarcontroller.hpp"
+#include <QDebug>
+#include <QGuiApplication>
+#include <QQmlEngine>
+#include <QScreen>
+
+BarManager::BarManager(QQmlEngine* engine, TopbarController* controller, QObject* parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_controller(controller)
+    , m_component(engine, "Velobar", "Topbar")
+{
+}
+
+BarManager::~BarManager()
+{
+    const QList<QQuickWindow*> windows = m_bars.values();
+    m_bars.clear();
+    for (QQuickWindow* window : windows) {
+        m_controller->detachWindow(window);
+        delete window;
+    }
+}
+
+bool BarManager::start()
+{
+    if (m_component.isError()) {
+        qDebug() << "Failed to load the Topbar component:" << m_component.errorString();
+        return false;
+    }
+
+    const QList<QScreen*> screens = QGuiApplication::screens();
+    for (QScreen* screen : screens) {
+        addBar(screen);
+    }
+
+    connect(qGuiApp, &QGuiApplication::screenAdded, this, &BarManager::addBar);
+    connect(qGuiApp, &QGuiApplication::screenRemoved, this, &BarManager::removeBar);
+    return !m_bars.isEmpty();
+}
+
+void BarManager::addBar(QScreen* screen)
+{
+    if (m_bars.contains(screen)) {
+        return;
+    }
+
+    QObject* object = m_component.createWithInitialProperties(
+        { { "screen", QVariant::fromValue(screen) } });
+    QQuickWindow* window = qobject_cast<QQuickWindow*>(object);
+    if (!window) {
+        qDebug() << "Failed to create a bar for" << screen->name() << m_component.errorString();
+        delete object;
+        return;
+    }
+
+    // Deleted by removeBar(), never by the garbage collector
+    QQmlEngine::setObjectOwnership(window, QQmlEngine::CppOwnership);
+    window->setScreen(screen);
+    m_bars.insert(screen, window);
+
+    // Widgets are incubated in the time a bar has left between frames
+    if (!m_engine->incubationController()) {
+        m_engine->setIncubationController(window->incubationController());
+    }
+
+    m_controller->attachWindow(window);
+
+    qDebug() << "Bar added on" << screen->name() << screen->geometry()
+             << "scale" << screen->devicePixelRatio();
+}
+
+void BarManager::removeBar(QScreen* screen)
+{
+    QQuickWindow* window = m_bars.take(screen);
+    if (!window) {
+        return;
+    }
+
+    qDebug() << "Bar removed from" << screen->name();
+
+    // Hand widget incubation to a bar that stays
+    if (m_engine->incubationController() == window->incubationController()) {
+        m_engine->setIncubationController(m_bars.isEmpty() ? nullptr : m_bars.begin().value()->incubationController());
+    }
+    m_controller->detachWindow(window);
+    window->deleteLater();
+}
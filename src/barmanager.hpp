@@ -0,0 +1,39 @@
+// include/barmanager.hpp
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QQmlComponent>
+#include <QQuickWindow>
+
+class QQmlEngine;
+class QScreen;
+class TopbarController;
+
+// One Topbar window per screen, made and destroyed as screens come and go.
+// Every window is created in the engine's root context, so all of them bind
+// to the same controllers, models and samplers.
+class BarManager : public QObject {
+    Q_OBJECT
+
+public:
+    BarManager(QQmlEngine* engine, TopbarController* controller, QObject* parent = nullptr);
+    ~BarManager();
+
+    // Creates the bars for the screens present now; false if the Topbar
+    // component failed to load
+    bool start();
+
+    QQuickWindow* windowFor(QScreen* screen) const { return m_bars.value(screen); }
+    int count() const { return m_bars.size(); }
+
+private slots:
+    void addBar(QScreen* screen);
+    void removeBar(QScreen* screen);
+
+private:
+    QQmlEngine* m_engine;
+    TopbarController* m_controller;
+    QQmlComponent m_component;
+    QHash<QScreen*, QQuickWindow*> m_bars;
+};
@@ -0,0 +1,265 @@
+// src/clockprovider.cpp
+#include "clockprovider.hpp"
+#include "tickscheduler.hpp"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#endif
+
+namespace {
+const int kMinuteMs = 60000;
+const int kSecondMs = 1000;
+
+#ifdef Q_OS_LINUX
+const char kLocaltimePath[] = "/etc/localtime";
+#endif
+}
+
+ClockProvider::ClockProvider(TickScheduler* scheduler, QObject* parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_tick(0)
+    , m_locale(QLocale::system())
+    , m_timeFormat(QStringLiteral("h:mm AP"))
+    , m_dateFormat(QStringLiteral("dddd, MMMM d"))
+    , m_active(true)
+#ifdef Q_OS_LINUX
+    , m_stepFd(-1)
+    , m_stepNotifier(nullptr)
+    , m_zoneWatcher(new QFileSystemWatcher(this))
+#endif
+{
+#ifdef Q_OS_WIN
+    // WM_TIMECHANGE, resume and locale broadcasts reach the bar window
+    QCoreApplication::instance()->installNativeEventFilter(this);
+#endif
+
+#ifdef Q_OS_LINUX
+    if (!watchClockSteps()) {
+        qDebug() << "Clock step notifications unavailable";
+    }
+
+    // Zone changes replace the /etc/localtime link rather than writing it
+    m_zoneWatcher->addPath(QString::fromLatin1(kLocaltimePath));
+    connect(m_zoneWatcher, &QFileSystemWatcher::fileChanged, this, &ClockProvider::onZoneChanged);
+#endif
+
+    update();
+    reschedule();
+}
+
+ClockProvider::~ClockProvider()
+{
+#ifdef Q_OS_WIN
+    QCoreApplication::instance()->removeNativeEventFilter(this);
+#endif
+
+#ifdef Q_OS_LINUX
+    delete m_stepNotifier;
+    if (m_stepFd >= 0) {
+        close(m_stepFd);
+    }
+#endif
+}
+
+void ClockProvider::setTimeFormat(const QString& format)
+{
+    if (m_timeFormat == format) {
+        return;
+    }
+
+    bool hadSeconds = showsSeconds();
+    m_timeFormat = format;
+    emit timeFormatChanged();
+
+    update();
+    if (showsSeconds() != hadSeconds) {
+        reschedule();
+    }
+}
+
+void ClockProvider::setDateFormat(const QString& format)
+{
+    if (m_dateFormat == format) {
+        return;
+    }
+
+    m_dateFormat = format;
+    m_shownDate = QDate();
+    emit dateFormatChanged();
+    update();
+}
+
+void ClockProvider::setActive(bool active)
+{
+    if (m_active == active) {
+        return;
+    }
+
+    m_active = active;
+    emit activeChanged();
+
+    // Catch up on whatever changed while hidden
+    if (active) {
+        update();
+    }
+    reschedule();
+}
+
+void ClockProvider::refresh()
+{
+    m_locale = QLocale::system();
+    m_shownDate = QDate();
+    update();
+
+    // The old deadline was computed against the previous wall clock
+    reschedule();
+}
+
+void ClockProvider::update()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+
+    QString time = m_locale.toString(now.time(), m_timeFormat);
+    if (time != m_time) {
+        m_time = time;
+        emit timeChanged();
+    }
+
+    if (now.date() != m_shownDate) {
+        m_shownDate = now.date();
+        QString date = m_locale.toString(m_shownDate, m_dateFormat);
+        if (date != m_date) {
+            m_date = date;
+            emit dateChanged();
+        }
+    }
+}
+
+void ClockProvider::reschedule()
+{
+    if (m_tick) {
+        m_scheduler->remove(m_tick);
+        m_tick = 0;
+    }
+
+    if (!m_active) {
+        return;
+    }
+
+    // Minute boundaries are the same in every zone, so wall-clock aligned
+    // ticks land exactly on them; midnight is one of them
+    m_tick = m_scheduler->add("clock", showsSeconds() ? kSecondMs : kMinuteMs, this,
+                              [this]() { update(); },
+                              TickScheduler::PauseWhenLocked | TickScheduler::NoSlack);
+}
+
+bool ClockProvider::showsSeconds() const
+{
+    // Seconds are 's' outside of quoted literal text
+    bool quoted = false;
+    for (QChar c : m_timeFormat) {
+        if (c == QLatin1Char('\'')) {
+            quoted = !quoted;
+        } else if (!quoted && c == QLatin1Char('s')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ClockProvider::nativeEventFilter(const QByteArray& eventType, void* message, qintptr* result)
+{
+    Q_UNUSED(result);
+#ifdef Q_OS_WIN
+    if (eventType != "windows_generic_MSG") {
+        return false;
+    }
+
+    MSG* msg = static_cast<MSG*>(message);
+    switch (msg->message) {
+    case WM_TIMECHANGE:
+        // Also sent for time zone changes
+        refresh();
+        break;
+    case WM_POWERBROADCAST:
+        if (msg->wParam == PBT_APMRESUMEAUTOMATIC) {
+            refresh();
+        }
+        break;
+    case WM_SETTINGCHANGE:
+        if (msg->lParam && wcscmp(reinterpret_cast<const wchar_t*>(msg->lParam), L"intl") == 0) {
+            refresh();
+        }
+        break;
+    default:
+        break;
+    }
+#else
+    Q_UNUSED(eventType);
+    Q_UNUSED(message);
+#endif
+    return false;
+}
+
+#ifdef Q_OS_LINUX
+bool ClockProvider::watchClockSteps()
+{
+    if (m_stepFd < 0) {
+        m_stepFd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (m_stepFd < 0) {
+            qDebug() << "Failed to create clock step timer:" << strerror(errno);
+            return false;
+        }
+
+        m_stepNotifier = new QSocketNotifier(m_stepFd, QSocketNotifier::Read, this);
+        connect(m_stepNotifier, &QSocketNotifier::activated, this, &ClockProvider::onClockStep);
+    }
+
+    // Never expires; the kernel cancels it whenever CLOCK_REALTIME is set,
+    // which includes the step taken on resume from suspend
+    itimerspec spec = {};
+    spec.it_value.tv_sec = INT_MAX;
+    if (timerfd_settime(m_stepFd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) < 0) {
+        qDebug() << "Failed to arm clock step timer:" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void ClockProvider::onClockStep()
+{
+    quint64 expirations = 0;
+    if (read(m_stepFd, &expirations, sizeof(expirations)) < 0 && errno != ECANCELED) {
+        return;
+    }
+
+    // A cancelled timer stays cancelled until re-armed
+    watchClockSteps();
+    refresh();
+}
+
+void ClockProvider::onZoneChanged()
+{
+    // A replaced link drops out of the watch list
+    const QString path = QString::fromLatin1(kLocaltimePath);
+    if (!m_zoneWatcher->files().contains(path) && QFileInfo::exists(path)) {
+        m_zoneWatcher->addPath(path);
+    }
+    refresh();
+}
+#endif
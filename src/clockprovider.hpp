@@ -0,0 +1,83 @@
+// include/clockprovider.hpp
+#pragma once
+
+#include <QAbstractNativeEventFilter>
+#include <QDate>
+#include <QLocale>
+#include <QObject>
+#include <QString>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+class TickScheduler;
+
+// Formatted time and date for the bar. Ticks on exact minute boundaries,
+// or every second while the time format shows seconds and the clock is
+// active. The date string is only rebuilt when the day changes. Clock steps,
+// resume from sleep, time zone and locale changes trigger an immediate
+// refresh instead of waiting for the next tick.
+class ClockProvider : public QObject, public QAbstractNativeEventFilter {
+    Q_OBJECT
+    Q_PROPERTY(QString time READ time NOTIFY timeChanged)
+    Q_PROPERTY(QString date READ date NOTIFY dateChanged)
+    Q_PROPERTY(QString timeFormat READ timeFormat WRITE setTimeFormat NOTIFY timeFormatChanged)
+    Q_PROPERTY(QString dateFormat READ dateFormat WRITE setDateFormat NOTIFY dateFormatChanged)
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+
+public:
+    explicit ClockProvider(TickScheduler* scheduler, QObject* parent = nullptr);
+    ~ClockProvider();
+
+    QString time() const { return m_time; }
+    QString date() const { return m_date; }
+    // QLocale/QTime format strings, e.g. "h:mm AP" or "HH:mm:ss"
+    QString timeFormat() const { return m_timeFormat; }
+    void setTimeFormat(const QString& format);
+    QString dateFormat() const { return m_dateFormat; }
+    void setDateFormat(const QString& format);
+    // Stops ticking while nothing shows the clock
+    bool active() const { return m_active; }
+    void setActive(bool active);
+
+    bool nativeEventFilter(const QByteArray& eventType, void* message, qintptr* result) override;
+
+public slots:
+    // Re-reads locale, time zone and wall clock right away
+    void refresh();
+
+signals:
+    void timeChanged();
+    void dateChanged();
+    void timeFormatChanged();
+    void dateFormatChanged();
+    void activeChanged();
+
+private:
+    void update();
+    // Registers the tick for the current format and activity
+    void reschedule();
+    bool showsSeconds() const;
+
+#ifdef Q_OS_LINUX
+    bool watchClockSteps();
+    void onClockStep();
+    void onZoneChanged();
+#endif
+
+private:
+    TickScheduler* m_scheduler;
+    int m_tick;
+    QLocale m_locale;
+    QString m_timeFormat;
+    QString m_dateFormat;
+    QString m_time;
+    QString m_date;
+    QDate m_shownDate; // Day m_date was built for
+    bool m_active;
+
+#ifdef Q_OS_LINUX
+    int m_stepFd; // timerfd cancelled by the kernel on clock steps
+    QSocketNotifier* m_stepNotifier;
+    QFileSystemWatcher* m_zoneWatcher;
+#endif
+};
@@ -0,0 +1,382 @@
+// src/commandindex.cpp
+#include "commandindex.hpp"
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+// Where a term only matches a menu above the command
+const float kAncestorWeight = 0.6f;
+// Commands collected under the rarest term's matches before scoring; keeps
+// one-letter queries on huge menus bounded
+const int kCandidateBudget = 4096;
+const int kMaxTerms = 8;
+}
+
+CommandIndex::CommandIndex()
+    : m_signature(0)
+    , m_epoch(0)
+{
+}
+
+void CommandIndex::clear()
+{
+    m_nodes.clear();
+    m_postings.clear();
+    m_folded.clear();
+    m_foldedByString.clear();
+    m_signature = 0;
+    m_lastKey.clear();
+    m_counts.clear();
+    m_seen.clear();
+    m_epoch = 0;
+}
+
+void CommandIndex::sync(const MenuTree& tree)
+{
+    if (tree.isEmpty()) {
+        clear();
+        return;
+    }
+
+    // A grown tree keeps its signature and the records already indexed
+    const int indexed = m_nodes.size();
+    quint64 signature = tree.signature();
+    bool grown = indexed > 0 && tree.size() >= indexed && signature == m_signature
+        && tree.key(indexed - 1) == m_lastKey;
+    if (!grown) {
+        clear();
+        m_signature = signature;
+    }
+
+    m_nodes.reserve(tree.size());
+    for (qint32 record = m_nodes.size(); record < tree.size(); ++record) {
+        add(tree, record);
+    }
+    m_lastKey = tree.key(tree.size() - 1);
+
+    m_counts.resize(m_nodes.size());
+    m_seen.resize(m_nodes.size());
+}
+
+void CommandIndex::add(const MenuTree& tree, qint32 record)
+{
+    const MenuItemRecord& item = tree.item(record);
+
+    Node node;
+    node.parent = item.parent;
+    if (!item.isSeparator()) {
+        node.folded = foldedId(tree, item.label);
+        node.command = !item.hasSubmenu() && !m_folded.at(node.folded).isEmpty();
+    }
+    m_nodes.append(node);
+
+    if (node.parent != MenuItemRecord::None) {
+        Node& parent = m_nodes[node.parent];
+        if (parent.lastChild == MenuItemRecord::None) {
+            parent.firstChild = record;
+        } else {
+            m_nodes[parent.lastChild].nextSibling = record;
+        }
+        parent.lastChild = record;
+    }
+
+    if (node.folded >= 0) {
+        const QVector<quint64> grams = labelTrigrams(m_folded.at(node.folded));
+        for (quint64 gram : grams) {
+            m_postings[gram].append(record);
+        }
+    }
+}
+
+qint32 CommandIndex::foldedId(const MenuTree& tree, MenuStringId label)
+{
+    auto it = m_foldedByString.constFind(label);
+    if (it != m_foldedByString.constEnd()) {
+        return it.value();
+    }
+    qint32 id = m_folded.size();
+    m_folded.append(fold(displayLabel(tree.strings().string(label))));
+    m_foldedByString.insert(label, id);
+    return id;
+}
+
+QVector<CommandIndex::Match> CommandIndex::search(const QString& query, int limit) const
+{
+    QVector<Match> results;
+    QStringList terms = fold(query).split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    if (terms.isEmpty() || m_nodes.isEmpty() || limit <= 0) {
+        return results;
+    }
+    if (terms.size() > kMaxTerms) {
+        terms = terms.mid(0, kMaxTerms);
+    }
+
+    // Every term has to match somewhere on a command's path
+    QVector<QVector<TermMatch>> matches;
+    matches.reserve(terms.size());
+    int driver = 0;
+    for (const QString& term : std::as_const(terms)) {
+        matches.append(matchTerm(term));
+        if (matches.last().isEmpty()) {
+            return results;
+        }
+        if (matches.last().size() < matches.at(driver).size()) {
+            driver = matches.size() - 1;
+        }
+    }
+
+    // Commands at or below the rarest term's matches, best matches first
+    QVector<TermMatch> roots = matches.at(driver);
+    std::sort(roots.begin(), roots.end(), [](const TermMatch& a, const TermMatch& b) {
+        return a.score > b.score;
+    });
+
+    if (++m_epoch == 0) {
+        m_seen.fill(0);
+        m_epoch = 1;
+    }
+    // Direct label matches first, then what sits under matching menus
+    QVector<qint32> candidates;
+    for (const TermMatch& root : std::as_const(roots)) {
+        if (m_nodes.at(root.node).command && candidates.size() < kCandidateBudget) {
+            m_seen[root.node] = m_epoch;
+            candidates.append(root.node);
+        }
+    }
+    QVector<qint32> stack;
+    for (const TermMatch& root : std::as_const(roots)) {
+        if (candidates.size() >= kCandidateBudget) {
+            break;
+        }
+        for (qint32 child = m_nodes.at(root.node).firstChild; child != MenuItemRecord::None;
+             child = m_nodes.at(child).nextSibling) {
+            stack.append(child);
+        }
+        while (!stack.isEmpty() && candidates.size() < kCandidateBudget) {
+            qint32 node = stack.takeLast();
+            if (m_seen.at(node) == m_epoch) {
+                continue;
+            }
+            m_seen[node] = m_epoch;
+
+            const Node& entry = m_nodes.at(node);
+            if (entry.command) {
+                candidates.append(node);
+            }
+            for (qint32 child = entry.firstChild; child != MenuItemRecord::None;
+                 child = m_nodes.at(child).nextSibling) {
+                stack.append(child);
+            }
+        }
+        stack.clear();
+    }
+
+    for (qint32 candidate : std::as_const(candidates)) {
+        float total = 0;
+        bool matched = true;
+        for (const QVector<TermMatch>& termMatches : std::as_const(matches)) {
+            float best = termScore(termMatches, candidate);
+            for (qint32 node = m_nodes.at(candidate).parent; best == 0 && node != MenuItemRecord::None;
+                 node = m_nodes.at(node).parent) {
+                best = termScore(termMatches, node) * kAncestorWeight;
+            }
+            if (best == 0) {
+                matched = false;
+                break;
+            }
+            total += best;
+        }
+        if (matched) {
+            results.append({ candidate, total });
+        }
+    }
+
+    auto better = [](const Match& a, const Match& b) {
+        return a.score != b.score ? a.score > b.score : a.record < b.record;
+    };
+    if (results.size() > limit) {
+        std::partial_sort(results.begin(), results.begin() + limit, results.end(), better);
+        results.resize(limit);
+    } else {
+        std::sort(results.begin(), results.end(), better);
+    }
+    return results;
+}
+
+QVector<CommandIndex::TermMatch> CommandIndex::matchTerm(const QString& term) const
+{
+    QVector<TermMatch> matches;
+    const QVector<quint64> grams = termTrigrams(term);
+    if (grams.isEmpty()) {
+        return matches;
+    }
+
+    // Short terms are one word-start gram; longer ones may miss a third
+    const int required = grams.size() - grams.size() / 3;
+
+    if (++m_epoch == 0) {
+        m_seen.fill(0);
+        m_epoch = 1;
+    }
+    QVector<qint32> touched;
+    for (quint64 gram : grams) {
+        auto it = m_postings.constFind(gram);
+        if (it == m_postings.constEnd()) {
+            continue;
+        }
+        for (qint32 node : it.value()) {
+            if (m_seen.at(node) != m_epoch) {
+                m_seen[node] = m_epoch;
+                m_counts[node] = 0;
+                touched.append(node);
+            }
+            ++m_counts[node];
+        }
+    }
+
+    for (qint32 node : std::as_const(touched)) {
+        int count = m_counts.at(node);
+        if (count < required) {
+            continue;
+        }
+        float overlap = float(count) / float(grams.size());
+        float score = labelScore(m_folded.at(m_nodes.at(node).folded), term, overlap);
+        if (score > 0) {
+            matches.append({ node, score });
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const TermMatch& a, const TermMatch& b) {
+        return a.node < b.node;
+    });
+    return matches;
+}
+
+float CommandIndex::termScore(const QVector<TermMatch>& matches, qint32 node) const
+{
+    auto it = std::lower_bound(matches.constBegin(), matches.constEnd(), node,
+                               [](const TermMatch& match, qint32 value) { return match.node < value; });
+    return it != matches.constEnd() && it->node == node ? it->score : 0;
+}
+
+size_t CommandIndex::memoryUsage() const
+{
+    size_t bytes = size_t(m_nodes.capacity()) * sizeof(Node);
+    for (auto it = m_postings.constBegin(); it != m_postings.constEnd(); ++it) {
+        bytes += sizeof(quint64) + sizeof(QVector<qint32>) + size_t(it.value().capacity()) * sizeof(qint32);
+    }
+    for (const QString& folded : m_folded) {
+        bytes += sizeof(QString) + size_t(folded.capacity()) * sizeof(QChar);
+    }
+    bytes += size_t(m_foldedByString.size()) * (sizeof(MenuStringId) + sizeof(qint32));
+    bytes += size_t(m_counts.capacity()) * sizeof(quint16) + size_t(m_seen.capacity()) * sizeof(quint32);
+    return bytes;
+}
+
+QString CommandIndex::displayLabel(const QString& label)
+{
+    int tab = label.indexOf(QLatin1Char('\t'));
+    return tab < 0 ? label : label.left(tab);
+}
+
+QString CommandIndex::shortcut(const QString& label)
+{
+    int tab = label.indexOf(QLatin1Char('\t'));
+    return tab < 0 ? QString() : label.mid(tab + 1).trimmed();
+}
+
+QStringList CommandIndex::path(const MenuTree& tree, qint32 record)
+{
+    QStringList labels;
+    for (qint32 node = tree.item(record).parent; node != MenuItemRecord::None; node = tree.item(node).parent) {
+        labels.prepend(displayLabel(tree.label(node)));
+    }
+    return labels;
+}
+
+QString CommandIndex::fold(const QString& label)
+{
+    // Lower case words separated by single spaces; "Save &As..." -> "save as"
+    QString folded;
+    folded.reserve(label.size());
+    bool space = true;
+    for (QChar c : label) {
+        if (c.isLetterOrNumber()) {
+            folded.append(c.toLower());
+            space = false;
+        } else if (!space) {
+            folded.append(QLatin1Char(' '));
+            space = true;
+        }
+    }
+    if (folded.endsWith(QLatin1Char(' '))) {
+        folded.chop(1);
+    }
+    return folded;
+}
+
+quint64 CommandIndex::trigram(QChar a, QChar b, QChar c)
+{
+    return (quint64(a.unicode()) << 32) | (quint64(b.unicode()) << 16) | quint64(c.unicode());
+}
+
+QVector<quint64> CommandIndex::labelTrigrams(const QString& folded)
+{
+    QVector<quint64> grams;
+    if (folded.isEmpty()) {
+        return grams;
+    }
+
+    // Two spaces in front give the first word its one- and two-letter
+    // start grams; later words get the two-letter one from the separator
+    const QString padded = QStringLiteral("  ") + folded;
+    grams.reserve(padded.size());
+    for (int i = 0; i + 2 < padded.size(); ++i) {
+        grams.append(trigram(padded.at(i), padded.at(i + 1), padded.at(i + 2)));
+    }
+    for (int i = 1; i + 1 < folded.size(); ++i) {
+        if (folded.at(i) == QLatin1Char(' ')) {
+            grams.append(trigram(QLatin1Char(' '), QLatin1Char(' '), folded.at(i + 1)));
+        }
+    }
+
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+QVector<quint64> CommandIndex::termTrigrams(const QString& term)
+{
+    QVector<quint64> grams;
+    const QChar space(QLatin1Char(' '));
+    if (term.size() == 1) {
+        grams.append(trigram(space, space, term.at(0)));
+    } else if (term.size() == 2) {
+        grams.append(trigram(space, term.at(0), term.at(1)));
+    } else {
+        grams.reserve(term.size() - 2);
+        for (int i = 0; i + 2 < term.size(); ++i) {
+            grams.append(trigram(term.at(i), term.at(i + 1), term.at(i + 2)));
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    }
+    return grams;
+}
+
+float CommandIndex::labelScore(const QString& folded, const QString& term, float overlap)
+{
+    float score;
+    if (folded.startsWith(term)) {
+        score = 1.0f;
+    } else if (folded.contains(QLatin1Char(' ') + term)) {
+        score = 0.85f; // At a word start
+    } else if (folded.contains(term)) {
+        score = 0.6f;
+    } else {
+        score = 0.5f * overlap; // Near miss, e.g. a typo
+    }
+
+    // Among equal matches, shorter labels first
+    return qMax(0.01f, score - 0.002f * float(folded.size()));
+}
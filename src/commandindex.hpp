@@ -0,0 +1,88 @@
+// include/commandindex.hpp
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "menutree.hpp"
+
+// Search index over the commands of one MenuTree, for the command palette.
+// Node ids are the tree's record indices.
+//
+// Every label is indexed by its trigrams, with word starts padded so one-
+// and two-letter terms match the start of a word. A query term matches a
+// command when it matches the command's own label or the label of a menu
+// above it, so "edit paste" finds Edit > Paste. Terms of three letters or
+// more tolerate a typo by needing only two thirds of their trigrams.
+//
+// Submenus are grafted onto the end of a MenuTree, so sync() only indexes
+// the records added since the last call.
+class CommandIndex {
+public:
+    struct Match {
+        qint32 record;
+        float score;
+    };
+
+    CommandIndex();
+
+    // Indexes what tree gained since the last call, or starts over when
+    // tree is a different tree
+    void sync(const MenuTree& tree);
+    void clear();
+
+    int size() const { return m_nodes.size(); }
+    size_t memoryUsage() const;
+
+    // Best commands for query, highest score first
+    QVector<Match> search(const QString& query, int limit) const;
+
+    // Label without the accelerator text after a tab
+    static QString displayLabel(const QString& label);
+    // Text after the tab in a Win32 menu label, e.g. "Ctrl+S"
+    static QString shortcut(const QString& label);
+    // Labels of the menus above record, outermost first
+    static QStringList path(const MenuTree& tree, qint32 record);
+
+private:
+    struct Node {
+        qint32 parent = MenuItemRecord::None;
+        qint32 firstChild = MenuItemRecord::None;
+        qint32 lastChild = MenuItemRecord::None;
+        qint32 nextSibling = MenuItemRecord::None;
+        qint32 folded = -1; // Into m_folded; -1 for separators
+        bool command = false;
+    };
+
+    // Per-term candidates, sorted by node
+    struct TermMatch {
+        qint32 node;
+        float score;
+    };
+
+    void add(const MenuTree& tree, qint32 record);
+    qint32 foldedId(const MenuTree& tree, MenuStringId label);
+    QVector<TermMatch> matchTerm(const QString& term) const;
+    float termScore(const QVector<TermMatch>& matches, qint32 node) const;
+
+    static QString fold(const QString& label);
+    static quint64 trigram(QChar a, QChar b, QChar c);
+    static QVector<quint64> labelTrigrams(const QString& folded);
+    static QVector<quint64> termTrigrams(const QString& term);
+    static float labelScore(const QString& folded, const QString& term, float overlap);
+
+private:
+    QVector<Node> m_nodes;
+    QHash<quint64, QVector<qint32>> m_postings; // Trigram -> nodes, ascending
+    QVector<QString> m_folded;                  // Distinct folded labels
+    QHash<MenuStringId, qint32> m_foldedByString;
+
+    // What the last sync() saw, to tell a grown tree from a new one
+    quint64 m_signature;
+    QString m_lastKey;
+
+    // Query scratch space, sized to the node count
+    mutable QVector<quint16> m_counts;
+    mutable QVector<quint32> m_seen;
+    mutable quint32 m_epoch;
+};
@@ -0,0 +1,470 @@
+// src/dbusmenuclient.cpp
+#include "dbusmenuclient.hpp"
+#include "metrics.hpp"
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusReply>
+#include <QDBusVariant>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+namespace {
+const char kInterface[] = "com.canonical.dbusmenu";
+const char kRegistrarService[] = "com.canonical.AppMenu.Registrar";
+const char kRegistrarPath[] = "/com/canonical/AppMenu/Registrar";
+const char kRegistrarInterface[] = "com.canonical.AppMenu.Registrar";
+
+// A hung application stalls the snapshot thread no longer than this
+const int kCallTimeoutMs = 2000;
+
+bool isStateProperty(const QString& name)
+{
+    return name == QLatin1String("enabled") || name == QLatin1String("toggle-state");
+}
+}
+
+QDBusArgument& operator<<(QDBusArgument& argument, const DBusMenuLayoutItem& item)
+{
+    argument.beginStructure();
+    argument << item.id << item.properties;
+    argument.beginArray(qMetaTypeId<QDBusVariant>());
+    for (const DBusMenuLayoutItem& child : item.children) {
+        argument << QDBusVariant(QVariant::fromValue(child));
+    }
+    argument.endArray();
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& argument, DBusMenuLayoutItem& item)
+{
+    argument.beginStructure();
+    argument >> item.id >> item.properties;
+    item.children.clear();
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        QDBusVariant wrapped;
+        argument >> wrapped;
+        DBusMenuLayoutItem child;
+        qvariant_cast<QDBusArgument>(wrapped.variant()) >> child;
+        item.children.append(child);
+    }
+    argument.endArray();
+    argument.endStructure();
+    return argument;
+}
+
+QDBusArgument& operator<<(QDBusArgument& argument, const DBusMenuItemProperties& item)
+{
+    argument.beginStructure();
+    argument << item.id << item.properties;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& argument, DBusMenuItemProperties& item)
+{
+    argument.beginStructure();
+    argument >> item.id >> item.properties;
+    argument.endStructure();
+    return argument;
+}
+
+QDBusArgument& operator<<(QDBusArgument& argument, const DBusMenuItemPropertyNames& item)
+{
+    argument.beginStructure();
+    argument << item.id << item.names;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument& operator>>(const QDBusArgument& argument, DBusMenuItemPropertyNames& item)
+{
+    argument.beginStructure();
+    argument >> item.id >> item.names;
+    argument.endStructure();
+    return argument;
+}
+
+DBusMenuClient::DBusMenuClient(const QDBusConnection& connection, const QString& service,
+                               const QString& path, QObject* parent)
+    : QObject(parent)
+    , m_connection(connection)
+    , m_service(service)
+    , m_path(path)
+    , m_loadedRevision(0)
+    , m_loaded(false)
+{
+    registerTypes();
+
+    m_connection.connect(m_service, m_path, kInterface, "LayoutUpdated",
+                         this, SLOT(onLayoutUpdated(uint,int)));
+    m_connection.connect(m_service, m_path, kInterface, "ItemsPropertiesUpdated",
+                         this, SLOT(onItemsPropertiesUpdated(DBusMenuItemPropertiesList,DBusMenuItemPropertyNamesList)));
+}
+
+void DBusMenuClient::registerTypes()
+{
+    static const bool registered = []() {
+        qDBusRegisterMetaType<DBusMenuLayoutItem>();
+        qDBusRegisterMetaType<DBusMenuItemProperties>();
+        qDBusRegisterMetaType<DBusMenuItemPropertyNames>();
+        qDBusRegisterMetaType<DBusMenuItemPropertiesList>();
+        qDBusRegisterMetaType<DBusMenuItemPropertyNamesList>();
+        return true;
+    }();
+    Q_UNUSED(registered);
+}
+
+bool DBusMenuClient::load()
+{
+    QDBusMessage call = QDBusMessage::createMethodCall(m_service, m_path, kInterface, "GetLayout");
+    call << 0 << -1 << QStringList();
+    QDBusPendingReply<uint, DBusMenuLayoutItem> reply = m_connection.asyncCall(call, kCallTimeoutMs);
+    reply.waitForFinished();
+    if (reply.isError()) {
+        qDebug() << "Menu of" << m_service << "unavailable:" << reply.error().message();
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_items.clear();
+    m_shown.clear();
+    insertLayout(reply.argumentAt<1>(), -1);
+    m_loadedRevision = reply.argumentAt<0>();
+    m_loaded = true;
+    return true;
+}
+
+bool DBusMenuClient::isLoaded() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_loaded;
+}
+
+int DBusMenuClient::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_items.size();
+}
+
+int DBusMenuClient::childCount(int id) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_items.constFind(id);
+    return it != m_items.constEnd() ? it->children.size() : -1;
+}
+
+bool DBusMenuClient::child(int id, int position, int& childId, QVariantMap& properties) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_items.constFind(id);
+    if (it == m_items.constEnd() || position < 0 || position >= it->children.size()) {
+        return false;
+    }
+    childId = it->children.at(position);
+    properties = m_items.value(childId).properties;
+    return true;
+}
+
+bool DBusMenuClient::contains(int id) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_items.contains(id);
+}
+
+bool DBusMenuClient::properties(int id, QVariantMap& properties) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_items.constFind(id);
+    if (it == m_items.constEnd()) {
+        return false;
+    }
+    properties = it->properties;
+    return true;
+}
+
+void DBusMenuClient::aboutToShow(int id)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_shown.contains(id) || !m_items.contains(id)) {
+            return;
+        }
+        m_shown.insert(id);
+    }
+
+    QDBusMessage call = QDBusMessage::createMethodCall(m_service, m_path, kInterface, "AboutToShow");
+    call << id;
+    QDBusReply<bool> needsUpdate = m_connection.call(call, QDBus::Block, kCallTimeoutMs);
+    if (!needsUpdate.isValid() || !needsUpdate.value()) {
+        return;
+    }
+
+    call = QDBusMessage::createMethodCall(m_service, m_path, kInterface, "GetLayout");
+    call << id << -1 << QStringList();
+    QDBusPendingReply<uint, DBusMenuLayoutItem> reply = m_connection.asyncCall(call, kCallTimeoutMs);
+    reply.waitForFinished();
+    if (reply.isValid()) {
+        QMutexLocker locker(&m_mutex);
+        replaceSubtree(reply.argumentAt<1>());
+    }
+}
+
+void DBusMenuClient::sendEvent(int id, const QString& eventId)
+{
+    QDBusMessage call = QDBusMessage::createMethodCall(m_service, m_path, kInterface, "Event");
+    call << id << eventId << QVariant::fromValue(QDBusVariant(QVariant(0)))
+         << uint(QDateTime::currentSecsSinceEpoch());
+    m_connection.call(call, QDBus::NoBlock);
+}
+
+void DBusMenuClient::onLayoutUpdated(uint revision, int parent)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        // Already part of the last full fetch
+        if (!m_loaded || revision <= m_loadedRevision) {
+            return;
+        }
+        if (!m_items.contains(parent)) {
+            parent = 0;
+        }
+    }
+    fetchLayout(parent);
+}
+
+void DBusMenuClient::fetchLayout(int parent)
+{
+    auto pending = m_fetching.find(parent);
+    if (pending != m_fetching.end()) {
+        *pending = true;
+        return;
+    }
+    m_fetching.insert(parent, false);
+
+    QElapsedTimer requested;
+    requested.start();
+
+    QDBusMessage call = QDBusMessage::createMethodCall(m_service, m_path, kInterface, "GetLayout");
+    call << parent << -1 << QStringList();
+    auto* watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(call, kCallTimeoutMs), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this, parent, requested](QDBusPendingCallWatcher* watcher) {
+        watcher->deleteLater();
+        bool again = m_fetching.take(parent);
+
+        QDBusPendingReply<uint, DBusMenuLayoutItem> reply = *watcher;
+        if (reply.isError()) {
+            qDebug() << "Menu layout of" << m_service << "unavailable:" << reply.error().message();
+        } else {
+            {
+                QMutexLocker locker(&m_mutex);
+                replaceSubtree(reply.argumentAt<1>());
+            }
+            Metrics::record(Metrics::MenuRemoteUpdate, requested.nsecsElapsed() / 1000);
+            emit layoutChanged(parent);
+        }
+
+        if (again) {
+            fetchLayout(parent);
+        }
+    });
+}
+
+void DBusMenuClient::onItemsPropertiesUpdated(const DBusMenuItemPropertiesList& updated,
+                                              const DBusMenuItemPropertyNamesList& removed)
+{
+    QVector<int> ids;
+    bool stateOnly = true;
+    {
+        Metrics::Scope apply(Metrics::MenuRemoteUpdate);
+        QMutexLocker locker(&m_mutex);
+        // Items not fetched yet come with their properties when they are
+        for (const DBusMenuItemProperties& entry : updated) {
+            auto it = m_items.find(entry.id);
+            if (it == m_items.end()) {
+                continue;
+            }
+            for (auto property = entry.properties.constBegin(); property != entry.properties.constEnd(); ++property) {
+                it->properties.insert(property.key(), property.value());
+                stateOnly = stateOnly && isStateProperty(property.key());
+            }
+            ids.append(entry.id);
+        }
+        for (const DBusMenuItemPropertyNames& entry : removed) {
+            auto it = m_items.find(entry.id);
+            if (it == m_items.end()) {
+                continue;
+            }
+            for (const QString& name : entry.names) {
+                it->properties.remove(name);
+                stateOnly = stateOnly && isStateProperty(name);
+            }
+            ids.append(entry.id);
+        }
+    }
+
+    if (!ids.isEmpty()) {
+        emit propertiesChanged(ids, stateOnly);
+    }
+}
+
+void DBusMenuClient::replaceSubtree(const DBusMenuLayoutItem& layout)
+{
+    auto it = m_items.find(layout.id);
+    if (it == m_items.end()) {
+        // Removed by an update that arrived first
+        if (layout.id != 0) {
+            return;
+        }
+        insertLayout(layout, -1);
+        return;
+    }
+
+    int parent = it->parent;
+    removeDescendants(layout.id);
+    m_items.remove(layout.id);
+    insertLayout(layout, parent);
+
+    // Submenus that came back get a fresh AboutToShow
+    if (layout.id == 0) {
+        m_shown.clear();
+    }
+}
+
+void DBusMenuClient::insertLayout(const DBusMenuLayoutItem& layout, int parent)
+{
+    Item item;
+    item.parent = parent;
+    item.properties = layout.properties;
+    item.children.reserve(layout.children.size());
+    for (const DBusMenuLayoutItem& child : layout.children) {
+        item.children.append(child.id);
+    }
+    m_items.insert(layout.id, item);
+
+    for (const DBusMenuLayoutItem& child : layout.children) {
+        insertLayout(child, layout.id);
+    }
+}
+
+void DBusMenuClient::removeDescendants(int id)
+{
+    auto it = m_items.find(id);
+    if (it == m_items.end()) {
+        return;
+    }
+    const QVector<int> children = it->children;
+    for (int child : children) {
+        removeDescendants(child);
+        m_items.remove(child);
+        m_shown.remove(child);
+    }
+}
+
+QString DBusMenuClient::plainLabel(const QString& label)
+{
+    QString text;
+    text.reserve(label.size());
+    for (int i = 0; i < label.size(); ++i) {
+        if (label.at(i) != QLatin1Char('_')) {
+            text.append(label.at(i));
+        } else if (i + 1 < label.size() && label.at(i + 1) == QLatin1Char('_')) {
+            text.append(QLatin1Char('_'));
+            ++i;
+        }
+    }
+    return text;
+}
+
+QString DBusMenuClient::shortcutText(const QVariant& shortcut)
+{
+    if (!shortcut.canConvert<QDBusArgument>()) {
+        return QString();
+    }
+
+    // One list of keys per chord, e.g. [["Control", "Shift", "s"]]
+    QList<QStringList> chords;
+    shortcut.value<QDBusArgument>() >> chords;
+
+    QStringList parts;
+    for (const QStringList& chord : std::as_const(chords)) {
+        QStringList keys;
+        for (QString key : chord) {
+            if (key == QLatin1String("Control")) {
+                key = QStringLiteral("Ctrl");
+            } else if (key == QLatin1String("Super")) {
+                key = QStringLiteral("Meta");
+            } else if (key.size() == 1) {
+                key = key.toUpper();
+            }
+            keys.append(key);
+        }
+        parts.append(keys.join(QLatin1Char('+')));
+    }
+    return parts.join(QStringLiteral(", "));
+}
+
+AppMenuRegistrar::AppMenuRegistrar(const QDBusConnection& connection, QObject* parent)
+    : QObject(parent)
+    , m_connection(connection)
+{
+    m_connection.connect(kRegistrarService, kRegistrarPath, kRegistrarInterface, "WindowRegistered",
+                         this, SLOT(onWindowRegistered(uint,QString,QDBusObjectPath)));
+    m_connection.connect(kRegistrarService, kRegistrarPath, kRegistrarInterface, "WindowUnregistered",
+                         this, SLOT(onWindowUnregistered(uint)));
+}
+
+bool AppMenuRegistrar::menuForWindow(quint32 window, QString& service, QString& path)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_menus.constFind(window);
+        if (it != m_menus.constEnd()) {
+            service = it->first;
+            path = it->second;
+            return !service.isEmpty();
+        }
+    }
+
+    QDBusMessage call = QDBusMessage::createMethodCall(kRegistrarService, kRegistrarPath,
+                                                       kRegistrarInterface, "GetMenuForWindow");
+    call << window;
+    QDBusMessage reply = m_connection.call(call, QDBus::Block, kCallTimeoutMs);
+    if (reply.type() == QDBusMessage::ReplyMessage && reply.arguments().size() == 2) {
+        service = reply.arguments().at(0).toString();
+        path = qvariant_cast<QDBusObjectPath>(reply.arguments().at(1)).path();
+    } else {
+        // Unknown window, or no registrar at all. A later registration
+        // arrives as a signal.
+        service.clear();
+        path.clear();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_menus.insert(window, qMakePair(service, path));
+    return !service.isEmpty();
+}
+
+void AppMenuRegistrar::onWindowRegistered(uint window, const QString& service, const QDBusObjectPath& path)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_menus.insert(window, qMakePair(service, path.path()));
+    }
+    emit windowChanged(window);
+}
+
+void AppMenuRegistrar::onWindowUnregistered(uint window)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_menus.insert(window, qMakePair(QString(), QString()));
+    }
+    emit windowChanged(window);
+}
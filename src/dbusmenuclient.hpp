@@ -0,0 +1,157 @@
+// include/dbusmenuclient.hpp
+#pragma once
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusObjectPath>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+// Wire types of com.canonical.dbusmenu. A layout is (ia{sv}av): id,
+// properties and the children, each wrapped in a variant.
+struct DBusMenuLayoutItem {
+    int id = 0;
+    QVariantMap properties;
+    QList<DBusMenuLayoutItem> children;
+};
+
+struct DBusMenuItemProperties {
+    int id = 0;
+    QVariantMap properties;
+};
+
+struct DBusMenuItemPropertyNames {
+    int id = 0;
+    QStringList names;
+};
+
+using DBusMenuItemPropertiesList = QList<DBusMenuItemProperties>;
+using DBusMenuItemPropertyNamesList = QList<DBusMenuItemPropertyNames>;
+
+Q_DECLARE_METATYPE(DBusMenuLayoutItem)
+Q_DECLARE_METATYPE(DBusMenuItemProperties)
+Q_DECLARE_METATYPE(DBusMenuItemPropertyNames)
+Q_DECLARE_METATYPE(DBusMenuItemPropertiesList)
+Q_DECLARE_METATYPE(DBusMenuItemPropertyNamesList)
+
+QDBusArgument& operator<<(QDBusArgument& argument, const DBusMenuLayoutItem& item);
+const QDBusArgument& operator>>(const QDBusArgument& argument, DBusMenuLayoutItem& item);
+QDBusArgument& operator<<(QDBusArgument& argument, const DBusMenuItemProperties& item);
+const QDBusArgument& operator>>(const QDBusArgument& argument, DBusMenuItemProperties& item);
+QDBusArgument& operator<<(QDBusArgument& argument, const DBusMenuItemPropertyNames& item);
+const QDBusArgument& operator>>(const QDBusArgument& argument, DBusMenuItemPropertyNames& item);
+
+// Local copy of one application's exported menu. The whole layout is
+// fetched once; after that LayoutUpdated refetches only the subtree that
+// changed and ItemsPropertiesUpdated is patched in place. Reads are safe
+// from any thread. Change signals are handled on the thread the client
+// lives on, which needs an event loop.
+class DBusMenuClient : public QObject {
+    Q_OBJECT
+
+public:
+    DBusMenuClient(const QDBusConnection& connection, const QString& service, const QString& path,
+                   QObject* parent = nullptr);
+
+    // Registers the wire types with Qt D-Bus; safe to call repeatedly
+    static void registerTypes();
+
+    QString service() const { return m_service; }
+    QString path() const { return m_path; }
+
+    // Fetches the whole layout, blocking. False when the exporter did not
+    // answer; the cached layout is then left as it was.
+    bool load();
+    bool isLoaded() const;
+    int size() const;
+
+    // -1 when id is not in the layout
+    int childCount(int id) const;
+    bool child(int id, int position, int& childId, QVariantMap& properties) const;
+    bool contains(int id) const;
+    bool properties(int id, QVariantMap& properties) const;
+
+    // Lets the exporter fill a submenu before it is first read, and fetches
+    // the submenu again when the exporter says it changed. Blocking.
+    void aboutToShow(int id);
+    // "clicked" on a command; does not wait for the exporter
+    void sendEvent(int id, const QString& eventId);
+
+    // "_Save As" -> "Save As"; "__" is a literal underscore
+    static QString plainLabel(const QString& label);
+    // The "shortcut" property (aas) as text, e.g. "Ctrl+Shift+S"
+    static QString shortcutText(const QVariant& shortcut);
+
+signals:
+    // stateOnly when nothing but "enabled" and "toggle-state" changed, so
+    // labels and structure are as they were
+    void propertiesChanged(const QVector<int>& ids, bool stateOnly);
+    // The subtree under parent was replaced
+    void layoutChanged(int parent);
+
+private slots:
+    void onLayoutUpdated(uint revision, int parent);
+    void onItemsPropertiesUpdated(const DBusMenuItemPropertiesList& updated,
+                                  const DBusMenuItemPropertyNamesList& removed);
+
+private:
+    struct Item {
+        int parent = -1;
+        QVariantMap properties;
+        QVector<int> children;
+    };
+
+    void fetchLayout(int parent);
+    // Callers hold m_mutex
+    void replaceSubtree(const DBusMenuLayoutItem& layout);
+    void insertLayout(const DBusMenuLayoutItem& layout, int parent);
+    void removeDescendants(int id);
+
+private:
+    QDBusConnection m_connection;
+    QString m_service;
+    QString m_path;
+
+    mutable QMutex m_mutex;
+    QHash<int, Item> m_items;
+    quint32 m_loadedRevision; // Of the last full fetch
+    bool m_loaded;
+    QSet<int> m_shown; // Submenus AboutToShow was sent for
+
+    // Subtrees with a GetLayout in flight; true when another update came in
+    // meanwhile and the subtree has to be fetched again. Client thread only.
+    QHash<int, bool> m_fetching;
+};
+
+// Which service exports the menu of an X11 window, from
+// com.canonical.AppMenu.Registrar. Lookups are cached, including windows
+// without a menu, and kept current from the registrar's signals.
+class AppMenuRegistrar : public QObject {
+    Q_OBJECT
+
+public:
+    explicit AppMenuRegistrar(const QDBusConnection& connection, QObject* parent = nullptr);
+
+    // Blocking on a cache miss; false when window has no menu
+    bool menuForWindow(quint32 window, QString& service, QString& path);
+
+signals:
+    // window registered, dropped or moved its menu
+    void windowChanged(quint32 window);
+
+private slots:
+    void onWindowRegistered(uint window, const QString& service, const QDBusObjectPath& path);
+    void onWindowUnregistered(uint window);
+
+private:
+    QDBusConnection m_connection;
+    QMutex m_mutex;
+    QHash<quint32, QPair<QString, QString>> m_menus; // Empty service: none
+};
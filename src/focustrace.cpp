@@ -0,0 +1,246 @@
+// src/focustrace.cpp
+#include "focustrace.hpp"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
+#include <QSaveFile>
+#include <QFile>
+
+namespace {
+const quint32 kFileMagic = 0x56424654; // "VBFT"
+const quint16 kFileVersion = 1;
+
+// Submenus nest a handful of levels in practice; anything deeper is corrupt
+const int kMaxMenuDepth = 32;
+
+const quint16 kStoredFlags = MenuItemRecord::Separator | MenuItemRecord::HasSubmenu
+    | MenuItemRecord::ChildrenLoaded;
+
+quint32 intern(QHash<QString, quint32>& strings, const QString& text)
+{
+    auto it = strings.constFind(text);
+    if (it != strings.constEnd()) {
+        return it.value();
+    }
+    quint32 id = quint32(strings.size());
+    strings.insert(text, id);
+    return id;
+}
+
+// Children of parent, then each loaded submenu right after its item
+void writeMenu(QDataStream& out, const MenuTree& tree, qint32 parent,
+               QHash<QString, quint32>& strings)
+{
+    out << quint32(tree.childCount(parent));
+    for (qint32 index = tree.firstChild(parent); index != MenuItemRecord::None;
+         index = tree.item(index).nextSibling) {
+        const MenuItemRecord& record = tree.item(index);
+        out << intern(strings, tree.label(index)) << record.commandId << record.state
+            << quint16(record.flags & kStoredFlags);
+        if (record.flags & MenuItemRecord::ChildrenLoaded) {
+            writeMenu(out, tree, index, strings);
+        }
+    }
+}
+
+bool readMenu(QDataStream& in, MenuTree& tree, qint32 parent, int level,
+              const QVector<QString>& strings)
+{
+    if (level > kMaxMenuDepth) {
+        return false;
+    }
+
+    quint32 count = 0;
+    in >> count;
+    MenuTree::Occurrences occurrences;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        quint32 label = 0;
+        MenuItemRecord record;
+        in >> label >> record.commandId >> record.state >> record.flags;
+        if (label >= quint32(strings.size())) {
+            return false;
+        }
+
+        record.flags &= kStoredFlags;
+        record.level = quint16(level);
+        qint32 index = tree.append(parent, record, strings.at(label), occurrences);
+        if ((record.flags & MenuItemRecord::ChildrenLoaded)
+            && !readMenu(in, tree, index, level + 1, strings)) {
+            return false;
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
+}
+
+bool FocusTrace::save(const QString& path) const
+{
+    // The body goes first into a buffer so the string table can precede it
+    QHash<QString, quint32> strings;
+    QByteArray body;
+    {
+        QBuffer buffer(&body);
+        buffer.open(QIODevice::WriteOnly);
+        QDataStream out(&buffer);
+
+        out << quint32(windows.size());
+        for (const Window& window : windows) {
+            out << intern(strings, window.processName);
+            writeMenu(out, window.menu, MenuItemRecord::None, strings);
+        }
+
+        out << quint32(events.size());
+        for (const Event& event : events) {
+            out << event.timeUs << event.window << intern(strings, event.title);
+        }
+    }
+
+    QVector<QString> table(strings.size());
+    for (auto it = strings.constBegin(); it != strings.constEnd(); ++it) {
+        table[int(it.value())] = it.key();
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to write focus trace:" << path;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << kFileMagic << kFileVersion << quint32(table.size());
+    for (const QString& text : table) {
+        out << text.toUtf8();
+    }
+    out.writeRawData(body.constData(), int(body.size()));
+
+    if (!file.commit()) {
+        qDebug() << "Failed to write focus trace:" << path;
+        return false;
+    }
+    return true;
+}
+
+bool FocusTrace::load(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open focus trace:" << path;
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 stringCount = 0;
+    in >> magic >> version >> stringCount;
+    if (magic != kFileMagic || version != kFileVersion) {
+        qDebug() << "Not a focus trace:" << path;
+        return false;
+    }
+
+    QVector<QString> strings;
+    for (quint32 i = 0; i < stringCount && in.status() == QDataStream::Ok; ++i) {
+        QByteArray text;
+        in >> text;
+        strings.append(QString::fromUtf8(text));
+    }
+
+    windows.clear();
+    events.clear();
+
+    quint32 windowCount = 0;
+    in >> windowCount;
+    for (quint32 i = 0; i < windowCount && in.status() == QDataStream::Ok; ++i) {
+        quint32 processName = 0;
+        in >> processName;
+        Window window;
+        if (processName >= quint32(strings.size())
+            || !readMenu(in, window.menu, MenuItemRecord::None, 0, strings)) {
+            qDebug() << "Focus trace is corrupt:" << path;
+            windows.clear();
+            return false;
+        }
+        window.processName = strings.at(processName);
+        windows.append(window);
+    }
+
+    quint32 eventCount = 0;
+    in >> eventCount;
+    for (quint32 i = 0; i < eventCount && in.status() == QDataStream::Ok; ++i) {
+        Event event;
+        quint32 title = 0;
+        in >> event.timeUs >> event.window >> title;
+        if (event.window >= quint32(windows.size()) || title >= quint32(strings.size())) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        event.title = strings.at(title);
+        events.append(event);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "Focus trace is truncated:" << path;
+        windows.clear();
+        events.clear();
+        return false;
+    }
+    return true;
+}
+
+FocusTraceRecorder::FocusTraceRecorder(const QString& path)
+    : m_path(path)
+{
+    m_clock.start();
+}
+
+QString FocusTraceRecorder::requestedPath()
+{
+    return qEnvironmentVariable("VELOBAR_RECORD_FOCUS");
+}
+
+quint32 FocusTraceRecorder::indexOf(quintptr window)
+{
+    auto it = m_windows.constFind(window);
+    if (it != m_windows.constEnd()) {
+        return it.value();
+    }
+    quint32 index = quint32(m_trace.windows.size());
+    m_trace.windows.append(FocusTrace::Window());
+    m_windows.insert(window, index);
+    return index;
+}
+
+void FocusTraceRecorder::focusChanged(quintptr window)
+{
+    FocusTrace::Event event;
+    event.timeUs = m_clock.nsecsElapsed() / 1000;
+    event.window = indexOf(window);
+    m_trace.events.append(event);
+}
+
+void FocusTraceRecorder::menuShown(quintptr window, const QString& title,
+                                   const QString& processName, const MenuTree& tree)
+{
+    quint32 index = indexOf(window);
+    FocusTrace::Window& entry = m_trace.windows[int(index)];
+    entry.processName = processName;
+    entry.menu = tree;
+
+    // Titles belong to the focus change that showed them
+    for (int i = m_trace.events.size() - 1; i >= 0; --i) {
+        if (m_trace.events.at(i).window == index) {
+            m_trace.events[i].title = title;
+            break;
+        }
+    }
+}
+
+bool FocusTraceRecorder::write() const
+{
+    if (!m_trace.save(m_path)) {
+        return false;
+    }
+    qDebug() << "Focus trace written to" << m_path << "with"
+             << m_trace.events.size() << "focus changes";
+    return true;
+}
@@ -0,0 +1,57 @@
+// include/focustrace.hpp
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "menutree.hpp"
+
+// A recorded sequence of foreground changes with the title, process and
+// menu tree shown for each window. Written by FocusTraceRecorder and fed
+// back through FakeWindowSystem by the focusreplay tool.
+class FocusTrace {
+public:
+    struct Window {
+        QString processName;
+        MenuTree menu; // Last tree shown, with the submenus loaded by then
+    };
+
+    struct Event {
+        qint64 timeUs = 0;  // Since recording started
+        quint32 window = 0; // Index into windows
+        QString title;
+    };
+
+    QVector<Window> windows;
+    QVector<Event> events;
+
+    // Labels, titles and process names are stored once in a string table
+    bool save(const QString& path) const;
+    bool load(const QString& path);
+};
+
+// Records what MenuController sees. Enabled with
+// VELOBAR_RECORD_FOCUS=<file>; the trace is written when the controller
+// goes away.
+class FocusTraceRecorder {
+public:
+    explicit FocusTraceRecorder(const QString& path);
+
+    // Path from the environment, empty when recording is off
+    static QString requestedPath();
+
+    void focusChanged(quintptr window);
+    void menuShown(quintptr window, const QString& title, const QString& processName,
+                   const MenuTree& tree);
+    bool write() const;
+
+private:
+    quint32 indexOf(quintptr window);
+
+private:
+    QString m_path;
+    QElapsedTimer m_clock;
+    FocusTrace m_trace;
+    QHash<quintptr, quint32> m_windows; // Handle -> index into m_trace.windows
+};
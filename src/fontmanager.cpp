@@ -0,0 +1,83 @@
+// src/fontmanager.cpp
+#include "fontmanager.hpp"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QFontDatabase>
+#include <QResource>
+
+namespace {
+const char kBundleName[] = "fonts.rcc";
+const char kBundleRoot[] = "/fontbundle";
+}
+
+FontManager::FontManager(QObject* parent)
+    : QObject(parent)
+    , m_bundleTried(false)
+{
+}
+
+FontManager::~FontManager()
+{
+    if (!m_bundlePath.isEmpty()) {
+        QResource::unregisterResource(m_bundlePath, kBundleRoot);
+    }
+}
+
+QString FontManager::family(const QString& style, const QString& width)
+{
+    const QString face = QStringLiteral("MonaSans%1-%2").arg(width, style);
+
+    auto it = m_families.constFind(face);
+    if (it != m_families.constEnd()) {
+        return it.value();
+    }
+
+    QString family = QFontDatabase::systemFont(QFontDatabase::GeneralFont).family();
+    if (openBundle()) {
+        const QString path = QStringLiteral(":%1/%2.ttf").arg(kBundleRoot, face);
+        int id = QFontDatabase::addApplicationFont(path);
+        const QStringList families = id >= 0 ? QFontDatabase::applicationFontFamilies(id)
+                                             : QStringList();
+        if (!families.isEmpty()) {
+            family = families.first();
+        } else {
+            qDebug() << "Failed to load font" << face;
+        }
+    }
+
+    // Failures are cached too so a missing face is only looked up once
+    m_families.insert(face, family);
+    return family;
+}
+
+bool FontManager::openBundle()
+{
+    if (m_bundleTried) {
+        return !m_bundlePath.isEmpty();
+    }
+    m_bundleTried = true;
+
+    // Next to the executable, or one up for multi-config build trees
+    const QDir appDir(QCoreApplication::applicationDirPath());
+    const QStringList candidates = {
+        appDir.filePath(kBundleName),
+        appDir.filePath(QStringLiteral("../") + kBundleName),
+    };
+
+    for (const QString& candidate : candidates) {
+        if (!QFileInfo::exists(candidate)) {
+            continue;
+        }
+        const QString path = QFileInfo(candidate).canonicalFilePath();
+        if (QResource::registerResource(path, kBundleRoot)) {
+            m_bundlePath = path;
+            return true;
+        }
+        qDebug() << "Failed to register font bundle" << path;
+    }
+
+    qDebug() << "Font bundle" << kBundleName << "not found, using system fonts";
+    return false;
+}
@@ -0,0 +1,34 @@
+// include/fontmanager.hpp
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+// Registers Mona Sans faces on first use. The fonts are not compiled into
+// the executable; they ship as a compressed binary resource (fonts.rcc, built
+// by tools/subset_fonts.py) that is only mapped once a face is requested.
+class FontManager : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FontManager(QObject* parent = nullptr);
+    ~FontManager();
+
+    // style is the weight name ("Regular", "Bold", "SemiBoldItalic"...) and
+    // width is empty, "Condensed" or "Expanded". Returns the family to use,
+    // the default UI family when the face is unavailable.
+    Q_INVOKABLE QString family(const QString& style = QStringLiteral("Regular"),
+                               const QString& width = QString());
+    // Faces registered so far, e.g. "MonaSans-Bold"
+    Q_INVOKABLE QStringList loadedFaces() const { return m_families.keys(); }
+
+private:
+    bool openBundle();
+
+private:
+    QString m_bundlePath; // Empty until the bundle was found and registered
+    bool m_bundleTried;
+    QHash<QString, QString> m_families; // Face -> family
+};
@@ -0,0 +1,222 @@
+// src/foregroundwatcher.cpp
+#include "foregroundwatcher.hpp"
+#include <QDebug>
+
+#ifdef VELOBAR_DBUSMENU
+#include <QSocketNotifier>
+#include <xcb/xcb.h>
+#include <cstdlib>
+#include "x11connection.hpp"
+#endif
+
+ForegroundWatcher::ForegroundWatcher(QObject* parent)
+    : QObject(parent)
+    , m_lastWindow(0)
+{
+}
+
+ForegroundWatcher* ForegroundWatcher::create(QObject* parent)
+{
+#if defined(Q_OS_WIN)
+    return new WinEventForegroundWatcher(parent);
+#elif defined(VELOBAR_DBUSMENU)
+    return new X11ForegroundWatcher(parent);
+#else
+    return new FakeForegroundWatcher(parent);
+#endif
+}
+
+void ForegroundWatcher::notify(quintptr window)
+{
+    if (!window || window == m_lastWindow) {
+        return;
+    }
+
+    m_lastWindow = window;
+    emit foregroundChanged(window);
+}
+
+FakeForegroundWatcher::FakeForegroundWatcher(QObject* parent)
+    : ForegroundWatcher(parent)
+    , m_window(0)
+    , m_running(false)
+{
+}
+
+bool FakeForegroundWatcher::start()
+{
+    m_running = true;
+    notify(m_window);
+    return true;
+}
+
+void FakeForegroundWatcher::stop()
+{
+    m_running = false;
+}
+
+void FakeForegroundWatcher::setForegroundWindow(quintptr window)
+{
+    m_window = window;
+    if (m_running) {
+        notify(window);
+    }
+}
+
+#ifdef Q_OS_WIN
+
+WinEventForegroundWatcher* WinEventForegroundWatcher::s_instance = nullptr;
+
+WinEventForegroundWatcher::WinEventForegroundWatcher(QObject* parent)
+    : ForegroundWatcher(parent)
+    , m_foregroundHook(nullptr)
+    , m_minimizeHook(nullptr)
+{
+}
+
+WinEventForegroundWatcher::~WinEventForegroundWatcher()
+{
+    stop();
+}
+
+bool WinEventForegroundWatcher::start()
+{
+    if (m_foregroundHook) {
+        return true;
+    }
+
+    // WinEvent callbacks carry no user data, so only one hook owner can exist
+    if (s_instance && s_instance != this) {
+        qDebug() << "Foreground watcher already running";
+        return false;
+    }
+    s_instance = this;
+
+    m_foregroundHook = SetWinEventHook(
+        EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND,
+        nullptr, winEventProc, 0, 0,
+        WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+
+    // Restoring a minimized window does not always raise a foreground event
+    m_minimizeHook = SetWinEventHook(
+        EVENT_SYSTEM_MINIMIZEEND, EVENT_SYSTEM_MINIMIZEEND,
+        nullptr, winEventProc, 0, 0,
+        WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+
+    if (!m_foregroundHook) {
+        qDebug() << "Failed to install foreground event hook";
+        stop();
+        return false;
+    }
+
+    // Report the window that was active before the hook existed
+    notify(reinterpret_cast<quintptr>(GetForegroundWindow()));
+    return true;
+}
+
+void WinEventForegroundWatcher::stop()
+{
+    if (m_foregroundHook) {
+        UnhookWinEvent(m_foregroundHook);
+        m_foregroundHook = nullptr;
+    }
+    if (m_minimizeHook) {
+        UnhookWinEvent(m_minimizeHook);
+        m_minimizeHook = nullptr;
+    }
+    if (s_instance == this) {
+        s_instance = nullptr;
+    }
+}
+
+void CALLBACK WinEventForegroundWatcher::winEventProc(HWINEVENTHOOK, DWORD, HWND hwnd,
+                                                      LONG idObject, LONG idChild,
+                                                      DWORD, DWORD)
+{
+    if (!s_instance || idObject != OBJID_WINDOW || idChild != CHILDID_SELF) {
+        return;
+    }
+
+    // The event window can be an owned popup; the foreground window is what
+    // the menu belongs to
+    HWND foreground = GetForegroundWindow();
+    s_instance->notify(reinterpret_cast<quintptr>(foreground ? foreground : hwnd));
+}
+
+#endif // Q_OS_WIN
+
+#ifdef VELOBAR_DBUSMENU
+
+X11ForegroundWatcher::X11ForegroundWatcher(QObject* parent)
+    : ForegroundWatcher(parent)
+    , m_notifier(nullptr)
+    , m_activeWindowAtom(0)
+{
+}
+
+X11ForegroundWatcher::~X11ForegroundWatcher()
+{
+    stop();
+}
+
+bool X11ForegroundWatcher::start()
+{
+    if (m_notifier) {
+        return true;
+    }
+
+    m_x11.reset(new X11Connection);
+    if (!m_x11->isOpen()) {
+        m_x11.reset();
+        return false;
+    }
+    m_activeWindowAtom = m_x11->atom("_NET_ACTIVE_WINDOW");
+    m_x11->selectPropertyChanges(m_x11->rootWindow());
+
+    m_notifier = new QSocketNotifier(m_x11->fileDescriptor(), QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &X11ForegroundWatcher::readEvents);
+
+    // Report the window that was active before the watch started
+    notify(m_x11->cardinal(m_x11->rootWindow(), m_activeWindowAtom));
+    return true;
+}
+
+void X11ForegroundWatcher::stop()
+{
+    // Can run from the notifier's own signal
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+    m_x11.reset();
+}
+
+void X11ForegroundWatcher::readEvents()
+{
+    xcb_connection_t* connection = m_x11->connection();
+    for (;;) {
+        bool changed = false;
+        while (xcb_generic_event_t* event = xcb_poll_for_event(connection)) {
+            if ((event->response_type & ~0x80) == XCB_PROPERTY_NOTIFY) {
+                auto* property = reinterpret_cast<xcb_property_notify_event_t*>(event);
+                changed |= property->atom == m_activeWindowAtom;
+            }
+            std::free(event);
+        }
+        if (!changed) {
+            break;
+        }
+
+        // One read per burst. The round trip can queue more events without
+        // the socket becoming readable again, hence the loop.
+        notify(m_x11->cardinal(m_x11->rootWindow(), m_activeWindowAtom));
+    }
+
+    if (m_x11 && xcb_connection_has_error(connection)) {
+        qDebug() << "X connection lost, menu will not follow focus";
+        stop();
+    }
+}
+
+#endif // VELOBAR_DBUSMENU
@@ -0,0 +1,109 @@
+// include/foregroundwatcher.hpp
+#pragma once
+
+#include <QObject>
+#include <memory>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+class QSocketNotifier;
+class X11Connection;
+
+// Source of foreground window change events. MenuController only looks at
+// the active window when one of these fires instead of polling for it.
+class ForegroundWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ForegroundWatcher(QObject* parent = nullptr);
+    virtual ~ForegroundWatcher() = default;
+
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    // Creates the backend for the running platform
+    static ForegroundWatcher* create(QObject* parent = nullptr);
+
+signals:
+    void foregroundChanged(quintptr window);
+
+protected:
+    // Emits foregroundChanged only when the window actually differs
+    void notify(quintptr window);
+
+private:
+    quintptr m_lastWindow;
+};
+
+// In-process backend driven by hand, used off Windows and by tests
+class FakeForegroundWatcher : public ForegroundWatcher {
+    Q_OBJECT
+
+public:
+    explicit FakeForegroundWatcher(QObject* parent = nullptr);
+
+    bool start() override;
+    void stop() override;
+
+    quintptr foregroundWindow() const { return m_window; }
+
+public slots:
+    void setForegroundWindow(quintptr window);
+
+private:
+    quintptr m_window;
+    bool m_running;
+};
+
+#ifdef Q_OS_WIN
+// Out-of-context WinEvent hook on EVENT_SYSTEM_FOREGROUND. Events are
+// delivered through the installing thread's message loop, so the signal
+// is always emitted on the GUI thread.
+class WinEventForegroundWatcher : public ForegroundWatcher {
+    Q_OBJECT
+
+public:
+    explicit WinEventForegroundWatcher(QObject* parent = nullptr);
+    ~WinEventForegroundWatcher();
+
+    bool start() override;
+    void stop() override;
+
+private:
+    static void CALLBACK winEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd,
+                                      LONG idObject, LONG idChild,
+                                      DWORD eventThread, DWORD eventTime);
+
+private:
+    HWINEVENTHOOK m_foregroundHook;
+    HWINEVENTHOOK m_minimizeHook;
+
+    static WinEventForegroundWatcher* s_instance;
+};
+#endif
+
+#ifdef VELOBAR_DBUSMENU
+// _NET_ACTIVE_WINDOW on the root window, read when the window manager
+// changes it. PropertyNotify events come in on a private X connection
+// watched by a socket notifier, so nothing polls.
+class X11ForegroundWatcher : public ForegroundWatcher {
+    Q_OBJECT
+
+public:
+    explicit X11ForegroundWatcher(QObject* parent = nullptr);
+    ~X11ForegroundWatcher();
+
+    bool start() override;
+    void stop() override;
+
+private slots:
+    void readEvents();
+
+private:
+    std::unique_ptr<X11Connection> m_x11;
+    QSocketNotifier* m_notifier;
+    quint32 m_activeWindowAtom;
+};
+#endif
@@ -2,21 +2,32 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
-#include <QUrl>
+#include <QQuickWindow>
+#include "barmanager.hpp"
+#include "fontmanager.hpp"
+#include "startuptrace.hpp"
 #include "topbarcontroller.hpp"
 
 int main(int argc, char *argv[])
 {
+    // Set VELOBAR_TRACE_STARTUP=<file> to record where startup time goes
+    StartupTrace::initialize();
+
     // Enable high DPI scaling
     QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QGuiApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 
+    qint64 phaseStart = StartupTrace::nowUs();
     QGuiApplication app(argc, argv);
     app.setOrganizationName("TopbarApp");
     app.setApplicationName("Topbar");
+    StartupTrace::complete("application init", phaseStart, StartupTrace::nowUs());
 
     // Create the controller
+    phaseStart = StartupTrace::nowUs();
     TopbarController controller;
+    FontManager fontManager;
+    StartupTrace::complete("system init", phaseStart, StartupTrace::nowUs());
 
     // Create QML engine
     QQmlApplicationEngine engine;
@@ -24,20 +35,20 @@ int main(int argc, char *argv[])
     // Register the controller instances with QML
     engine.rootContext()->setContextProperty("topbarController", &controller);
     engine.rootContext()->setContextProperty("menuController", controller.menuController());
-
-    // Load the QML file from resources
-    engine.load(QUrl(QStringLiteral("qrc:/qml/topbar.qml")));
-
-    // Check if QML loaded successfully
-    if (engine.rootObjects().isEmpty()) {
-        return -1;
-    }
-
-    // Initialize the controller with the main window
-    QWindow* mainWindow = qobject_cast<QWindow*>(engine.rootObjects().first());
-    if (mainWindow) {
-        controller.initialize(mainWindow);
+    engine.rootContext()->setContextProperty("tickScheduler", controller.tickScheduler());
+    engine.rootContext()->setContextProperty("fontManager", &fontManager);
+
+    // One bar per screen from the Velobar module's Topbar, whose QML is
+    // compiled ahead of time into the executable. All of them share the
+    // controller above.
+    BarManager bars(&engine, &controller);
+    {
+        StartupTrace::Scope phase("qml load");
+        if (!bars.start()) {
+            return -1;
+        }
     }
+    StartupTrace::watchFirstFrame(bars.windowFor(QGuiApplication::primaryScreen()));
 
     // Connect cleanup on app quit
     QObject::connect(&app, &QGuiApplication::aboutToQuit,
@@ -1,301 +1,515 @@
 // src/menucontroller.cpp
 #include "menucontroller.hpp"
+#include "menusnapshotworker.hpp"
+#include "metrics.hpp"
+#include <QCoreApplication>
 #include <QDebug>
-#include <psapi.h>
-#include <QFileInfo>
-#include <QVersionNumber>
-#include <QFuture>
-#include <memory>
+#include <QTimer>
+
+namespace {
+// Some applications build their menu bar after they come to the foreground
+const int kMenuRecheckAttempts = 3;
+const int kMenuRecheckDelayMs = 50;
+// MFS_DISABLED, which is the same bits as MFS_GRAYED
+const quint32 kDisabledState = 0x3;
+
+// Items of tree among commandIds whose live state differs, as { index, state }
+QVector<QPair<qint32, quint32>> changedStates(const WindowSystem& system, quint64 menu, const MenuTree& tree,
+                                              const QSet<quint32>& commandIds)
+{
+    QVector<QPair<qint32, quint32>> changes;
+    if (!menu) {
+        return changes;
+    }
+    for (qint32 i = 0; i < tree.size(); ++i) {
+        const MenuItemRecord& record = tree.item(i);
+        quint32 state = 0;
+        if (record.isSeparator() || !commandIds.contains(record.commandId)
+            || !system.readCommandState(menu, record.commandId, state) || state == record.state) {
+            continue;
+        }
+        changes.append(qMakePair(i, state));
+    }
+    return changes;
+}
+}
 
-MenuController::MenuController(QObject* parent)
+MenuController::MenuController(QObject* parent, ForegroundWatcher* watcher,
+                               WindowSystem* windowSystem)
     : QObject(parent)
-    , m_lastHwnd(nullptr)
+    , m_watcher(watcher ? watcher : ForegroundWatcher::create())
+    , m_windowSystem(windowSystem ? windowSystem : WindowSystem::create())
+    , m_generation(0)
+    , m_cache(m_windowSystem.get())
+    , m_lastWindow(0)
+    , m_shownWindow(0)
     , m_model(new MenuItemModel(this))
 {
-    m_timer = new QTimer(this);
-    connect(m_timer, &QTimer::timeout, this, &MenuController::checkActiveWindow);
-    m_timer->start(100); // Check every 100ms
+    qRegisterMetaType<MenuSnapshot>();
+    qRegisterMetaType<MenuTree>();
+    qRegisterMetaType<MenuStateProbe>();
+    qRegisterMetaType<QVector<MenuStateChange>>();
+
+    MenuSnapshotWorker* worker = new MenuSnapshotWorker(&m_generation, m_windowSystem.get());
+    worker->moveToThread(&m_snapshotThread);
+    connect(&m_snapshotThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(this, &MenuController::snapshotRequested, worker, &MenuSnapshotWorker::capture);
+    connect(this, &MenuController::submenuRequested, worker, &MenuSnapshotWorker::expand);
+    connect(this, &MenuController::stateRefreshRequested, worker, &MenuSnapshotWorker::refreshState);
+    connect(worker, &MenuSnapshotWorker::snapshotReady, this, &MenuController::applySnapshot);
+    connect(worker, &MenuSnapshotWorker::submenuReady, this, &MenuController::applySubmenu);
+    connect(worker, &MenuSnapshotWorker::stateReady, this, &MenuController::applyMenuState);
+    m_snapshotThread.setObjectName("MenuSnapshot");
+    m_snapshotThread.start();
+
+    m_windowSystem->setMenuChangedHandler([this](quintptr window) {
+        onMenuChanged(window);
+    });
+    m_windowSystem->setMenuStateChangedHandler([this](quintptr window, const QVector<quint32>& commandIds) {
+        onMenuStateChanged(window, commandIds);
+    });
+
+    m_watcher->setParent(this);
+    connect(m_watcher, &ForegroundWatcher::foregroundChanged,
+            this, &MenuController::onForegroundChanged);
+
+    const QString tracePath = FocusTraceRecorder::requestedPath();
+    if (!tracePath.isEmpty()) {
+        m_recorder.reset(new FocusTraceRecorder(tracePath));
+    }
+
+    if (!m_watcher->start()) {
+        qDebug() << "Foreground events unavailable, menu will not follow focus";
+    }
 }
 
 MenuController::~MenuController()
 {
+    // Makes any capture still running bail out at its next check
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_snapshotThread.quit();
+    m_snapshotThread.wait();
+
+    if (m_recorder) {
+        m_recorder->write();
+    }
 }
 
-QString MenuController::getProcessName(HWND hwnd)
+void MenuController::onForegroundChanged(quintptr window)
 {
-    try {
-        DWORD processId;
-        GetWindowThreadProcessId(hwnd, &processId);
+    if (!window || window == m_lastWindow) {
+        return;
+    }
+    // The bar's own windows, e.g. the command palette, keep the menu of the
+    // application they act on
+    if (m_windowSystem->processId(window) == quint32(QCoreApplication::applicationPid())) {
+        return;
+    }
+    m_lastWindow = window;
+    Metrics::increment(Metrics::FocusChanges);
 
-        HANDLE processHandle = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
-        if (!processHandle) {
-            return "Unknown";
-        }
+    if (m_recorder) {
+        m_recorder->focusChanged(window);
+    }
 
-        std::unique_ptr<void, decltype(&CloseHandle)> handleGuard(processHandle, CloseHandle);
-
-        wchar_t filePath[MAX_PATH];
-        if (GetModuleFileNameEx(processHandle, nullptr, filePath, MAX_PATH)) {
-            // First try to get version info description
-            DWORD dummy;
-            DWORD fileInfoSize = GetFileVersionInfoSize(filePath, &dummy);
-            if (fileInfoSize > 0) {
-                std::vector<BYTE> fileInfoBuffer(fileInfoSize);
-                if (GetFileVersionInfo(filePath, 0, fileInfoSize, fileInfoBuffer.data())) {
-                    struct LANGANDCODEPAGE {
-                        WORD language;
-                        WORD codePage;
-                    } *translations;
-                    UINT translationsLen = 0;
-
-                    // Get list of languages
-                    if (VerQueryValue(fileInfoBuffer.data(), L"\\VarFileInfo\\Translation",
-                        (LPVOID*)&translations, &translationsLen)) {
-                        
-                        // Try different version info strings in order of preference
-                        const wchar_t* queries[] = {
-                            L"FileDescription",
-                            L"ProductName",
-                            L"OriginalFilename"
-                        };
-
-                        for (const auto& query : queries) {
-                            for (UINT i = 0; i < translationsLen / sizeof(LANGANDCODEPAGE); i++) {
-                                wchar_t subBlock[128];
-                                _snwprintf_s(subBlock, _countof(subBlock), _TRUNCATE,
-                                    L"\\StringFileInfo\\%04x%04x\\%s",
-                                    translations[i].language,
-                                    translations[i].codePage,
-                                    query);
-
-                                LPWSTR value = nullptr;
-                                UINT len = 0;
-                                if (VerQueryValue(fileInfoBuffer.data(), subBlock, (LPVOID*)&value, &len) && value && len > 0) {
-                                    QString friendly = QString::fromWCharArray(value).trimmed();
-                                    if (!friendly.isEmpty()) {
-                                        return friendly;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+    // Measured until menuChanged is emitted
+    m_focusLatency.start();
 
-            // Fallback to executable name without extension
-            QString path = QString::fromWCharArray(filePath);
-            return QFileInfo(path).completeBaseName();
-        }
-    }
-    catch (const std::exception& e) {
-        qDebug() << "Error getting process name:" << e.what();
+    quint64 generation = m_generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+    m_pendingSubmenus.clear();
+    m_pendingStates.clear();
+
+    // Show the last known menu right away; the worker confirms or replaces it
+    quint64 knownSignature = 0;
+    if (const MenuSnapshot* cached = m_cache.find(m_cache.keyFor(window))) {
+        MenuSnapshot instant = *cached;
+        instant.generation = generation;
+        knownSignature = cached->signature;
+        publishSnapshot(instant);
     }
 
-    return "Unknown";
+    emit snapshotRequested(generation, window, 0, knownSignature);
 }
 
-QVariantMap MenuController::getMenuText(HMENU hmenu, int position)
+void MenuController::onMenuChanged(quintptr window)
 {
-    QVariantMap result;
+    // A cached tree of the window may pass the top-level signature check
+    // while a submenu below it changed
+    m_cache.remove(m_cache.keyFor(window));
+    emit cacheStatsChanged();
+    if (window != m_shownWindow) {
+        return;
+    }
 
-    try {
-        MENUITEMINFO mii = { sizeof(MENUITEMINFO) };
-        mii.fMask = MIIM_FTYPE | MIIM_STATE | MIIM_ID;
+    quint64 generation = m_generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+    m_pendingSubmenus.clear();
+    m_pendingStates.clear();
+    emit snapshotRequested(generation, window, 0, 0);
+}
 
-        if (!GetMenuItemInfo(hmenu, position, TRUE, &mii)) {
-            return result;
+void MenuController::onMenuStateChanged(quintptr window, const QVector<quint32>& commandIds)
+{
+    // Labels and links are unchanged, so the tree, its grafted submenus and
+    // the command index stay; only the rows of these commands are re-read
+    const QSet<quint32> changed(commandIds.cbegin(), commandIds.cend());
+    const quint64 menu = m_windowSystem->menuBar(window);
+
+    if (window == m_shownWindow) {
+        const QVector<QPair<qint32, quint32>> changes = changedStates(*m_windowSystem, menu, m_model->tree(), changed);
+        if (changes.isEmpty()) {
+            return;
+        }
+        for (const auto& change : changes) {
+            m_model->setItemState(change.first, change.second);
         }
+        Metrics::increment(Metrics::MenuStateChanges, quint64(changes.size()));
 
-        // Check if separator
-        if (mii.fType & MFT_SEPARATOR) {
-            result["text"] = "";
-            result["is_separator"] = true;
-            result["id"] = (int)mii.wID;
-            result["state"] = (int)mii.fState;
-            return result;
+        // Search results carry the enabled state
+        emit commandsChanged();
+        updateCachedTree();
+        return;
+    }
+
+    MenuCacheKey cacheKey = m_cache.keyFor(window);
+    if (const MenuSnapshot* cached = m_cache.find(cacheKey)) {
+        const QVector<QPair<qint32, quint32>> changes = changedStates(*m_windowSystem, menu, cached->items, changed);
+        if (changes.isEmpty()) {
+            return;
+        }
+        MenuSnapshot updated = *cached;
+        for (const auto& change : changes) {
+            updated.items.setState(change.first, change.second);
         }
+        m_cache.insert(cacheKey, updated);
+        emit cacheStatsChanged();
+    }
+}
 
-        // Get text length
-        int length = GetMenuString(hmenu, position, nullptr, 0, MF_BYPOSITION);
-        if (length == 0) {
-            return result;
+void MenuController::applySnapshot(const MenuSnapshot& snapshot)
+{
+    // Focus changed again after this snapshot was requested
+    if (snapshot.generation != m_generation.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    MenuSnapshot applied = snapshot;
+    MenuCacheKey key = m_cache.keyFor(snapshot.window);
+    quintptr window = snapshot.window;
+
+    if (snapshot.treeReused) {
+        const MenuSnapshot* cached = m_cache.find(key);
+        if (!cached) {
+            // Evicted or destroyed while the worker was validating
+            emit snapshotRequested(snapshot.generation, window, snapshot.attempt, 0);
+            return;
         }
+        applied.items = cached->items;
+        m_cache.recordHit();
+        Metrics::increment(Metrics::MenuCacheHits);
+    } else if (snapshot.attempt == 0) {
+        m_cache.recordMiss();
+    }
 
-        // Get text
-        std::wstring buffer(length + 1, 0);
-        GetMenuStringW(hmenu, position, &buffer[0], length + 1, MF_BYPOSITION);
+    if (!applied.items.isEmpty()) {
+        m_cache.insert(key, applied);
+    }
+    emit cacheStatsChanged();
+
+    // A re-check that still found no menu has nothing new to show
+    bool unchanged = applied.attempt > 0 && applied.items.isEmpty();
+    if (snapshot.treeReused && window == m_shownWindow) {
+        // The cached tree was shown on focus and kept in step since; only
+        // the title and process name may have moved on
+        if (applied.title != m_activeWindow || applied.processName != m_activeApp) {
+            m_activeWindow = applied.title;
+            m_activeApp = applied.processName;
+            emit menuChanged(m_activeWindow, m_activeApp, m_model->tree().size());
+        }
+    } else if (!unchanged) {
+        publishSnapshot(applied);
+    }
 
-        // Get submenu
-        HMENU submenu = GetSubMenu(hmenu, position);
+    if (applied.items.isEmpty() && applied.attempt < kMenuRecheckAttempts) {
+        quint64 generation = applied.generation;
+        int attempt = applied.attempt + 1;
+        QTimer::singleShot(kMenuRecheckDelayMs, this, [this, generation, window, attempt]() {
+            if (generation == m_generation.load(std::memory_order_acquire)) {
+                emit snapshotRequested(generation, window, attempt, 0);
+            }
+        });
+    }
+}
 
-        // Remove & from text
-        QString menuText = QString::fromWCharArray(buffer.c_str()).replace("&", "");
+void MenuController::prefetchSubmenu(const QString& key)
+{
+    qint32 index = m_model->tree().find(key);
+    if (index != MenuItemRecord::None) {
+        requestSubmenu(index, 1);
+    }
+}
 
-        result["text"] = menuText;
-        result["is_separator"] = false;
-        result["id"] = (int)mii.wID;
-        result["state"] = (int)mii.fState;
-        result["has_submenu"] = submenu != nullptr;
-        result["submenu_handle"] = (qulonglong)submenu;
+void MenuController::loadAllSubmenus()
+{
+    // Grafted subtrees come back fully loaded, so only the outermost
+    // unloaded submenus need a request
+    const MenuTree& tree = m_model->tree();
+    for (qint32 i = 0; i < tree.size(); ++i) {
+        requestSubmenu(i, -1);
+    }
+}
 
-        return result;
+void MenuController::requestSubmenu(qint32 index, int depth)
+{
+    const MenuTree& tree = m_model->tree();
+    const MenuItemRecord& record = tree.item(index);
+    if (!record.needsChildren()) {
+        return;
     }
-    catch (const std::exception& e) {
-        qDebug() << "Error getting menu text:" << e.what();
-        return result;
+    const QString key = tree.key(index);
+    if (m_pendingSubmenus.contains(key)) {
+        return;
     }
+
+    m_pendingSubmenus.insert(key);
+    emit submenuRequested(m_generation.load(std::memory_order_acquire),
+                          m_shownWindow,
+                          key, record.submenu, record.level + 1, depth);
 }
 
-QVariantList MenuController::enumerateMenu(HMENU hmenu, int level)
+void MenuController::applySubmenu(quint64 generation, const QString& key, const MenuTree& children)
 {
-    QVariantList menuItems;
+    if (generation != m_generation.load(std::memory_order_acquire)) {
+        return;
+    }
+    m_pendingSubmenus.remove(key);
 
-    if (!hmenu) {
-        return menuItems;
+    // A newer snapshot of the same window may have replaced the tree
+    qint32 index = m_model->tree().find(key);
+    if (index == MenuItemRecord::None || !m_model->tree().item(index).needsChildren()) {
+        return;
     }
 
-    try {
-        int count = GetMenuItemCount(hmenu);
-        if (count == -1) {
-            return menuItems;
-        }
+    m_model->insertChildren(index, children);
+    syncCommandIndex();
 
-        for (int i = 0; i < count; ++i) {
-            QVariantMap item = getMenuText(hmenu, i);
-            if (!item.isEmpty()) {
-                item["level"] = level;
-                menuItems.append(item);
-
-                if (!item["is_separator"].toBool() && item["has_submenu"].toBool()) {
-                    HMENU submenu = (HMENU)item["submenu_handle"].toULongLong();
-                    QVariantList subItems = enumerateMenu(submenu, level + 1);
-                    menuItems.append(subItems);
-                }
-            }
+    if (m_recorder) {
+        m_recorder->menuShown(m_shownWindow, m_activeWindow, m_activeApp, m_model->tree());
+    }
+
+    updateCachedTree();
+}
+
+void MenuController::refreshMenuState(const QString& key)
+{
+    const MenuTree& tree = m_model->tree();
+    qint32 parent = MenuItemRecord::None;
+    if (!key.isEmpty()) {
+        parent = tree.find(key);
+        // A submenu not loaded yet is read in full by prefetchSubmenu()
+        if (parent == MenuItemRecord::None || !tree.item(parent).hasSubmenu()
+            || tree.item(parent).needsChildren()) {
+            return;
         }
     }
-    catch (const std::exception& e) {
-        qDebug() << "Error enumerating menu:" << e.what();
+
+    if (!m_shownWindow || tree.childCount(parent) == 0 || m_pendingStates.contains(key)) {
+        return;
     }
 
-    return menuItems;
+    MenuStateProbe probe;
+    probe.key = key;
+    probe.menu = parent == MenuItemRecord::None ? 0 : tree.item(parent).submenu;
+    probe.hashes.reserve(tree.childCount(parent));
+    for (qint32 i = tree.firstChild(parent); i != MenuItemRecord::None; i = tree.item(i).nextSibling) {
+        probe.hashes.append(tree.stateHash(i));
+    }
+
+    m_pendingStates.insert(key);
+    emit stateRefreshRequested(m_generation.load(std::memory_order_acquire), m_shownWindow, probe);
 }
 
-QVariantList MenuController::getWindowMenuItems(HWND hwnd)
+void MenuController::applyMenuState(quint64 generation, quintptr window, const QString& key,
+                                    const QVector<MenuStateChange>& changes, bool structureChanged)
 {
-    try {
-        HMENU menuBar = GetMenu(hwnd);
-        if (menuBar) {
-            QVariantList menuItems = enumerateMenu(menuBar);
-
-            // Clean up items for display
-            QVariantList cleanedItems;
-            for (const QVariant& item : menuItems) {
-                QVariantMap itemMap = item.toMap();
-                if (!itemMap["text"].toString().isEmpty() || itemMap["is_separator"].toBool()) {
-                    itemMap.remove("submenu_handle");
-                    cleanedItems.append(itemMap);
-                }
-            }
+    if (generation != m_generation.load(std::memory_order_acquire)) {
+        return;
+    }
+    m_pendingStates.remove(key);
+    if (window != m_shownWindow) {
+        return;
+    }
 
-            return cleanedItems;
-        }
+    // Items came or went since the tree was read; only a capture helps
+    if (structureChanged) {
+        onMenuChanged(window);
+        return;
     }
-    catch (const std::exception& e) {
-        qDebug() << "Error getting window menu items:" << e.what();
+    if (changes.isEmpty()) {
+        return;
+    }
+
+    const MenuTree& tree = m_model->tree();
+    qint32 parent = key.isEmpty() ? MenuItemRecord::None : tree.find(key);
+    if (!key.isEmpty() && parent == MenuItemRecord::None) {
+        return;
+    }
+
+    for (const MenuStateChange& change : changes) {
+        // A newer snapshot of the same window may have replaced the tree
+        qint32 index = tree.childAt(parent, change.row);
+        if (index == MenuItemRecord::None || tree.item(index).commandId != change.commandId) {
+            onMenuChanged(window);
+            return;
+        }
+        m_model->setItemState(index, change.state);
     }
+    Metrics::increment(Metrics::MenuStateChanges, quint64(changes.size()));
 
-    return QVariantList();
+    // Search results carry the enabled state
+    emit commandsChanged();
+    updateCachedTree();
 }
 
-void MenuController::checkActiveWindow()
+void MenuController::updateCachedTree()
 {
-    try {
-        HWND hwnd = GetForegroundWindow();
-        if (hwnd && hwnd != m_lastHwnd) {
-            m_lastHwnd = hwnd;
-
-            wchar_t windowTitle[256];
-            GetWindowTextW(hwnd, windowTitle, 256);
-            QString title = QString::fromWCharArray(windowTitle);
-            QString processName = getProcessName(hwnd);
-
-            // Get menu items with retry
-            QVariantList menuItems;
-            int retryCount = 0;
-            while (menuItems.isEmpty() && retryCount < 3) {
-                menuItems = getWindowMenuItems(hwnd);
-                if (menuItems.isEmpty()) {
-                    retryCount++;
-                    Sleep(50);
-                }
-            }
+    // Keep the cached tree as complete and current as the shown one
+    MenuCacheKey cacheKey = m_cache.keyFor(m_shownWindow);
+    if (const MenuSnapshot* cached = m_cache.find(cacheKey)) {
+        MenuSnapshot updated = *cached;
+        updated.items = m_model->tree();
+        m_cache.insert(cacheKey, updated);
+        emit cacheStatsChanged();
+    }
+}
 
-            m_activeWindow = title;
-            m_activeApp = processName;
-            m_menuItems = menuItems;
-            m_model->setItems(menuItems);
+void MenuController::publishSnapshot(const MenuSnapshot& snapshot)
+{
+    m_activeWindow = snapshot.title;
+    m_activeApp = snapshot.processName;
+    m_shownWindow = snapshot.window;
+
+    // Delegates the views built for the previous change, after it settled
+    Metrics::increment(Metrics::DelegatesCreated, quint64(m_model->takeDelegateCount()));
+    {
+        Metrics::Scope update(Metrics::ModelUpdate);
+        m_model->setTree(snapshot.items);
+    }
+    Metrics::increment(Metrics::ModelUpdates);
+    syncCommandIndex();
 
-            // Debug output
-            qDebug() << "\nActive Window:" << title;
-            qDebug() << "Process:" << processName;
-            qDebug() << "Menu Items:" << menuItems.size();
+    if (m_recorder) {
+        m_recorder->menuShown(snapshot.window, snapshot.title, snapshot.processName, m_model->tree());
+    }
 
-            emit menuChanged(title, processName, menuItems);
-        }
+    if (m_focusLatency.isValid()) {
+        Metrics::record(Metrics::FocusToMenu, m_focusLatency.nsecsElapsed() / 1000);
+        m_focusLatency.invalidate();
     }
-    catch (const std::exception& e) {
-        qDebug() << "Error checking active window:" << e.what();
+
+    emit menuChanged(snapshot.title, snapshot.processName, snapshot.items.size());
+}
+
+void MenuController::syncCommandIndex()
+{
+    {
+        Metrics::Scope sync(Metrics::CommandIndexSync);
+        m_commandIndex.sync(m_model->tree());
     }
+    emit commandsChanged();
 }
 
-void MenuController::triggerMenuItem(const QString& menuText)
+QVariantList MenuController::searchCommands(const QString& query, int limit) const
+{
+    Metrics::Scope search(Metrics::CommandSearch);
+
+    QVariantList results;
+    const MenuTree& tree = m_model->tree();
+    const QVector<CommandIndex::Match> matches = m_commandIndex.search(query, limit);
+    results.reserve(matches.size());
+    for (const CommandIndex::Match& match : matches) {
+        const MenuItemRecord& record = tree.item(match.record);
+        QVariantMap result;
+        result["key"] = tree.key(match.record);
+        result["label"] = CommandIndex::displayLabel(tree.label(match.record));
+        result["path"] = CommandIndex::path(tree, match.record).join(QStringLiteral(" > "));
+        result["shortcut"] = CommandIndex::shortcut(tree.label(match.record));
+        result["enabled"] = (record.state & kDisabledState) == 0;
+        results.append(result);
+    }
+    return results;
+}
+
+void MenuController::triggerMenuItem(const QString& key)
 {
     try {
-        HWND hwnd = GetForegroundWindow();
-        if (!hwnd) {
+        quintptr window = m_shownWindow;
+        if (!window || !m_windowSystem->isWindow(window)) {
             return;
         }
 
-        HMENU menu = GetMenu(hwnd);
-        if (menu) {
-            if (triggerMenuItemRecursive(menu, menuText)) {
-                SetForegroundWindow(hwnd);
+        quint64 menu = m_windowSystem->menuBar(window);
+        if (!menu) {
+            return;
+        }
+
+        // Command id recorded when the menu was enumerated
+        const MenuTree& tree = m_model->tree();
+        qint32 index = tree.find(key);
+        if (index != MenuItemRecord::None) {
+            const MenuItemRecord& record = tree.item(index);
+
+            // The index is stale once the command is gone from the live menu
+            if (record.hasSubmenu() || m_windowSystem->hasCommand(menu, record.commandId)) {
+                m_windowSystem->postCommand(window, record.commandId);
+                m_windowSystem->activate(window);
+                return;
             }
         }
+
+        // Fall back to finding the item by its path in the live menu
+        quint32 commandId = 0;
+        if (resolveCommand(*m_windowSystem, menu, MenuTree::splitKey(key), 0, commandId)) {
+            m_windowSystem->postCommand(window, commandId);
+            m_windowSystem->activate(window);
+        }
     }
     catch (const std::exception& e) {
         qDebug() << "Error triggering menu item:" << e.what();
     }
 }
 
-bool MenuController::triggerMenuItemRecursive(HMENU hmenu, const QString& targetText, int level)
+bool MenuController::resolveCommand(const WindowSystem& system, quint64 menu,
+                                    const QVector<MenuTree::KeySegment>& path, int level,
+                                    quint32& commandId)
 {
+    if (level >= path.size()) {
+        return false;
+    }
+
     try {
-        int itemCount = GetMenuItemCount(hmenu);
+        const MenuTree::KeySegment& segment = path.at(level);
+        int itemCount = system.menuItemCount(menu);
+        int occurrence = 0;
 
+        MenuItemRecord record;
+        QString text;
         for (int i = 0; i < itemCount; ++i) {
-            QVariantMap itemInfo = getMenuText(hmenu, i);
-            if (itemInfo.isEmpty()) {
+            if (!system.readMenuItem(menu, i, record, text)
+                || text != segment.first || ++occurrence != segment.second) {
                 continue;
             }
 
-            if (itemInfo["text"].toString().trimmed() == targetText.trimmed()) {
-                HWND hwnd = GetForegroundWindow();
-                PostMessage(hwnd, WM_COMMAND, itemInfo["id"].toUInt(), 0);
+            if (level == path.size() - 1) {
+                commandId = record.commandId;
                 return true;
             }
 
-            if (itemInfo["has_submenu"].toBool()) {
-                HMENU submenu = (HMENU)itemInfo["submenu_handle"].toULongLong();
-                if (triggerMenuItemRecursive(submenu, targetText, level + 1)) {
-                    return true;
-                }
-            }
+            return record.hasSubmenu()
+                && resolveCommand(system, record.submenu, path, level + 1, commandId);
         }
     }
     catch (const std::exception& e) {
-        qDebug() << "Error in recursive menu trigger:" << e.what();
+        qDebug() << "Error resolving menu path:" << e.what();
     }
 
     return false;
@@ -2,49 +2,110 @@
 #pragma once
 
 #include <QObject>
-#include <QTimer>
-#include <QVariantList>
-#include <windows.h>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include "commandindex.hpp"
 #include "menuitemmodel.hpp"
+#include "menusnapshot.hpp"
+#include "menusnapshotcache.hpp"
+#include "focustrace.hpp"
+#include "foregroundwatcher.hpp"
+#include "windowsystem.hpp"
 
 class MenuController : public QObject {
     Q_OBJECT
     Q_PROPERTY(QString activeWindow READ activeWindow NOTIFY menuChanged)
     Q_PROPERTY(QString activeApp READ activeApp NOTIFY menuChanged)
-    Q_PROPERTY(QVariantList menuItems READ menuItems NOTIFY menuChanged)
+    Q_PROPERTY(int menuItemCount READ menuItemCount NOTIFY menuChanged)
     Q_PROPERTY(MenuItemModel* mainMenu READ mainMenu CONSTANT)
+    Q_PROPERTY(double cacheHitRate READ cacheHitRate NOTIFY cacheStatsChanged)
+    Q_PROPERTY(int cacheSize READ cacheSize NOTIFY cacheStatsChanged)
+    Q_PROPERTY(qint64 cacheMemoryUsage READ cacheMemoryUsage NOTIFY cacheStatsChanged)
 
 public:
-    explicit MenuController(QObject* parent = nullptr);
+    // Takes ownership of watcher and windowSystem; the platform backends are
+    // used when null
+    explicit MenuController(QObject* parent = nullptr, ForegroundWatcher* watcher = nullptr,
+                            WindowSystem* windowSystem = nullptr);
     ~MenuController();
 
+    // Walks the live menu along a MenuTree key path; false when an entry on
+    // the way no longer exists
+    static bool resolveCommand(const WindowSystem& system, quint64 menu,
+                               const QVector<MenuTree::KeySegment>& path, int level,
+                               quint32& commandId);
+
     QString activeWindow() const { return m_activeWindow; }
     QString activeApp() const { return m_activeApp; }
-    QVariantList menuItems() const { return m_menuItems; }
+    int menuItemCount() const { return m_model->tree().size(); }
     MenuItemModel* mainMenu() const { return m_model; }
+    double cacheHitRate() const { return m_cache.hitRate(); }
+    int cacheSize() const { return m_cache.size(); }
+    qint64 cacheMemoryUsage() const { return qint64(m_cache.memoryUsage()); }
 
 public slots:
-    void triggerMenuItem(const QString& menuText);
+    // key is MenuItemModel's "key" role of the item to run
+    void triggerMenuItem(const QString& key);
+    // Fetches the submenu under key in the background if not loaded yet
+    void prefetchSubmenu(const QString& key);
+    // Fetches every submenu not loaded yet, all levels, so the command
+    // search covers the whole menu; for when the palette opens
+    void loadAllSubmenus();
+    // Re-reads only the enabled, checked and grayed state of the items
+    // under key (the menu bar when empty) and updates the rows that changed.
+    // For when the bar is hovered or a submenu is about to open: the
+    // focused window can change them without the focus moving.
+    void refreshMenuState(const QString& key = QString());
+
+public:
+    // Commands of the shown menu matching query, best first, as { key,
+    // label, path, shortcut, enabled }. Run one with triggerMenuItem(key).
+    Q_INVOKABLE QVariantList searchCommands(const QString& query, int limit = 50) const;
 
 signals:
-    void menuChanged(const QString& window, const QString& app, const QVariantList& items);
+    void menuChanged(const QString& window, const QString& app, int itemCount);
+    void cacheStatsChanged();
+    // The searchable commands changed, e.g. a submenu arrived
+    void commandsChanged();
+
+    // Queued to the snapshot worker
+    void snapshotRequested(quint64 generation, quintptr window, int attempt, quint64 knownSignature);
+    void submenuRequested(quint64 generation, quintptr window, const QString& key, quint64 submenu, int level,
+                          int depth);
+    void stateRefreshRequested(quint64 generation, quintptr window, const MenuStateProbe& probe);
 
 private slots:
-    void checkActiveWindow();
+    void onForegroundChanged(quintptr window);
+    void onMenuChanged(quintptr window);
+    void onMenuStateChanged(quintptr window, const QVector<quint32>& commandIds);
+    void applySnapshot(const MenuSnapshot& snapshot);
+    void applySubmenu(quint64 generation, const QString& key, const MenuTree& children);
+    void applyMenuState(quint64 generation, quintptr window, const QString& key,
+                        const QVector<MenuStateChange>& changes, bool structureChanged);
 
 private:
-    QString getProcessName(HWND hwnd);
-    QString getFriendlyAppName(const QString& path, HANDLE processHandle);
-    QVariantMap getMenuText(HMENU hmenu, int position);
-    QVariantList enumerateMenu(HMENU hmenu, int level = 0);
-    QVariantList getWindowMenuItems(HWND hwnd);
-    bool triggerMenuItemRecursive(HMENU hmenu, const QString& targetText, int level = 0);
+    void publishSnapshot(const MenuSnapshot& snapshot);
+    void requestSubmenu(qint32 index, int depth);
+    void updateCachedTree();
+    void syncCommandIndex();
 
 private:
     QString m_activeWindow;
     QString m_activeApp;
-    QVariantList m_menuItems;
-    QTimer* m_timer;
-    HWND m_lastHwnd;
+    ForegroundWatcher* m_watcher;
+    std::unique_ptr<WindowSystem> m_windowSystem; // Outlives the thread and cache
+    QThread m_snapshotThread;
+    std::atomic<quint64> m_generation; // Bumped on every focus change
+    MenuSnapshotCache m_cache;
+    QSet<QString> m_pendingSubmenus; // Keys with an expand() in flight
+    QSet<QString> m_pendingStates;   // Keys with a refreshState() in flight
+    QElapsedTimer m_focusLatency;
+    quintptr m_lastWindow;
+    quintptr m_shownWindow; // Window whose menu is currently shown
     MenuItemModel* m_model;
+    CommandIndex m_commandIndex; // Over m_model's tree
+    std::unique_ptr<FocusTraceRecorder> m_recorder; // Only with VELOBAR_RECORD_FOCUS
 };
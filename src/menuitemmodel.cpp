@@ -2,28 +2,367 @@
 #include "menuitemmodel.hpp"
 
 MenuItemModel::MenuItemModel(QObject* parent)
-    : QObject(parent)
+    : QAbstractItemModel(parent)
+    , m_delegatesCreated(0)
 {
 }
 
-QVariantList MenuItemModel::items() const
+QVector<qint32> MenuItemModel::visibleRoots(const MenuTree& tree)
 {
-    return m_mainItems;
+    QVector<qint32> roots;
+
+    // Only main menu items are shown in the bar
+    for (qint32 i = tree.firstChild(MenuItemRecord::None); i != MenuItemRecord::None;
+         i = tree.item(i).nextSibling) {
+        if (!tree.item(i).isSeparator() && !tree.label(i).isEmpty()) {
+            roots.append(i);
+        }
+    }
+
+    return roots;
+}
+
+bool MenuItemModel::sameRecord(const MenuTree& a, qint32 i, const MenuTree& b, qint32 j)
+{
+    const MenuItemRecord& left = a.item(i);
+    const MenuItemRecord& right = b.item(j);
+    return left.commandId == right.commandId
+        && left.state == right.state
+        && left.flags == right.flags
+        && a.label(i) == b.label(j);
+}
+
+bool MenuItemModel::sameSubtree(const MenuTree& a, qint32 i, const MenuTree& b, qint32 j)
+{
+    if (a.childCount(i) != b.childCount(j)) {
+        return false;
+    }
+
+    for (qint32 x = a.firstChild(i), y = b.firstChild(j); x != MenuItemRecord::None;
+         x = a.item(x).nextSibling, y = b.item(y).nextSibling) {
+        if (!sameRecord(a, x, b, y) || !sameSubtree(a, x, b, y)) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
-void MenuItemModel::setItems(const QVariantList& allItems)
+void MenuItemModel::setTree(const MenuTree& tree)
 {
-    m_mainItems.clear();
+    const int oldCount = m_rootRows.size();
+    const QVector<qint32> newRoots = visibleRoots(tree);
+
+    // Pair every new top-level item with an unused old one of the same label
+    QHash<QString, QVector<int>> oldByLabel;
+    for (int row = 0; row < m_rootRows.size(); ++row) {
+        oldByLabel[m_tree.label(m_rootRows.at(row))].append(row);
+    }
+
+    QVector<bool> isNew(newRoots.size(), true);
+    QVector<int> matchedBy(m_rootRows.size(), -1); // Old row -> new row
+    for (int n = 0; n < newRoots.size(); ++n) {
+        auto it = oldByLabel.find(tree.label(newRoots.at(n)));
+        if (it != oldByLabel.end() && !it->isEmpty()) {
+            matchedBy[it->takeFirst()] = n;
+            isNew[n] = false;
+        }
+    }
+
+    // Drop old rows without a counterpart, back to front in contiguous runs
+    for (int last = m_rootRows.size() - 1; last >= 0; --last) {
+        if (matchedBy.at(last) != -1) {
+            continue;
+        }
+
+        int first = last;
+        while (first > 0 && matchedBy.at(first - 1) == -1) {
+            --first;
+        }
+
+        beginRemoveRows(QModelIndex(), first, last);
+        m_rootRows.remove(first, last - first + 1);
+        matchedBy.remove(first, last - first + 1);
+        endRemoveRows();
+
+        last = first;
+    }
+
+    // Surviving rows whose submenu differs get their children rebuilt
+    QVector<bool> recordChanged(newRoots.size(), false);
+    QVector<bool> collapsed(m_rootRows.size(), false);
+    for (int row = 0; row < m_rootRows.size(); ++row) {
+        qint32 oldRecord = m_rootRows.at(row);
+        qint32 newRecord = newRoots.at(matchedBy.at(row));
+
+        recordChanged[matchedBy.at(row)] = !sameRecord(m_tree, oldRecord, tree, newRecord);
+        if (sameSubtree(m_tree, oldRecord, tree, newRecord)) {
+            continue;
+        }
 
-    // Filter and store only main menu items
-    for (const QVariant& item : allItems) {
-        QVariantMap itemMap = item.toMap();
-        if (itemMap["level"].toInt() == 0 &&
-            !itemMap["is_separator"].toBool() &&
-            !itemMap["text"].toString().isEmpty()) {
-            m_mainItems.append(item);
+        collapsed[row] = true;
+        int children = m_tree.childCount(oldRecord);
+        if (children > 0) {
+            beginRemoveRows(index(row, 0), 0, children - 1);
+            m_collapsed.insert(oldRecord);
+            endRemoveRows();
+        } else {
+            m_collapsed.insert(oldRecord);
         }
     }
 
-    emit dataChanged();
+    // Switch to the new tree; surviving rows keep their current position
+    QVector<qint32> survivors;
+    survivors.reserve(m_rootRows.size());
+    QSet<qint32> survivorsCollapsed;
+    for (int row = 0; row < m_rootRows.size(); ++row) {
+        survivors.append(newRoots.at(matchedBy.at(row)));
+        if (collapsed.at(row)) {
+            survivorsCollapsed.insert(survivors.last());
+        }
+    }
+
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex& index : from) {
+        to.append(remapIndex(index, tree, survivors));
+    }
+
+    m_tree = tree;
+    m_rootRows = survivors;
+    m_collapsed = survivorsCollapsed;
+    changePersistentIndexList(from, to);
+
+    // Bring surviving rows into the new order and add the new ones
+    QVector<int> order = matchedBy; // New row shown at each current position
+    for (int n = 0; n < newRoots.size(); ++n) {
+        if (isNew.at(n)) {
+            beginInsertRows(QModelIndex(), n, n);
+            m_rootRows.insert(n, newRoots.at(n));
+            order.insert(n, n);
+            endInsertRows();
+            continue;
+        }
+
+        int current = order.indexOf(n, n);
+        if (current != n) {
+            beginMoveRows(QModelIndex(), current, current, QModelIndex(), n);
+            m_rootRows.move(current, n);
+            order.move(current, n);
+            endMoveRows();
+        }
+    }
+
+    // Show rebuilt submenus and refresh entries whose own data changed
+    for (int n = 0; n < newRoots.size(); ++n) {
+        qint32 record = newRoots.at(n);
+        if (m_collapsed.contains(record)) {
+            int children = m_tree.childCount(record);
+            if (children > 0) {
+                beginInsertRows(index(n, 0), 0, children - 1);
+                m_collapsed.remove(record);
+                endInsertRows();
+            } else {
+                m_collapsed.remove(record);
+            }
+        }
+
+        if (recordChanged.at(n)) {
+            QModelIndex changed = index(n, 0);
+            emit dataChanged(changed, changed);
+        }
+    }
+
+    if (oldCount != m_rootRows.size()) {
+        emit countChanged();
+    }
+}
+
+void MenuItemModel::insertChildren(qint32 record, const MenuTree& children)
+{
+    QModelIndex parentIndex = indexForRecord(record);
+    int first = m_tree.childCount(record);
+    int count = children.childCount(MenuItemRecord::None);
+
+    // Items hidden from the views take the children without notifying
+    if (!parentIndex.isValid() || count == 0) {
+        m_tree.graft(record, children);
+    } else {
+        beginInsertRows(parentIndex, first, first + count - 1);
+        m_tree.graft(record, children);
+        endInsertRows();
+    }
+
+    if (parentIndex.isValid()) {
+        emit dataChanged(parentIndex, parentIndex);
+    }
+}
+
+void MenuItemModel::setItemState(qint32 record, quint32 state)
+{
+    if (m_tree.item(record).state == state) {
+        return;
+    }
+    m_tree.setState(record, state);
+
+    // Rows hidden from the views pick the state up when shown
+    QModelIndex index = indexForRecord(record);
+    if (index.isValid()) {
+        emit dataChanged(index, index, { MenuStateRole });
+    }
+}
+
+QModelIndex MenuItemModel::indexForRecord(qint32 record) const
+{
+    if (record == MenuItemRecord::None) {
+        return QModelIndex();
+    }
+
+    qint32 parentRecord = m_tree.item(record).parent;
+    if (parentRecord == MenuItemRecord::None) {
+        int row = m_rootRows.indexOf(record);
+        return row < 0 ? QModelIndex() : createIndex(row, 0, quintptr(record));
+    }
+
+    if (!indexForRecord(parentRecord).isValid()) {
+        return QModelIndex();
+    }
+    return createIndex(m_tree.rowOf(record), 0, quintptr(record));
+}
+
+QModelIndex MenuItemModel::remapIndex(const QModelIndex& index, const MenuTree& tree,
+                                      const QVector<qint32>& rootRows) const
+{
+    // Row path from the top-level item down to index, resolved in tree
+    QVector<int> path;
+    for (QModelIndex i = index; i.isValid(); i = i.parent()) {
+        path.prepend(i.row());
+    }
+
+    if (path.isEmpty() || path.first() >= rootRows.size()) {
+        return QModelIndex();
+    }
+
+    qint32 record = rootRows.at(path.first());
+    for (int depth = 1; depth < path.size() && record != MenuItemRecord::None; ++depth) {
+        record = tree.childAt(record, path.at(depth));
+    }
+
+    if (record == MenuItemRecord::None) {
+        return QModelIndex();
+    }
+    return createIndex(path.last(), index.column(), quintptr(record));
+}
+
+int MenuItemModel::takeDelegateCount()
+{
+    int count = m_delegatesCreated;
+    m_delegatesCreated = 0;
+    return count;
+}
+
+qint32 MenuItemModel::recordIndex(const QModelIndex& index) const
+{
+    return index.isValid() ? static_cast<qint32>(index.internalId()) : MenuItemRecord::None;
+}
+
+QModelIndex MenuItemModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (row < 0 || column != 0) {
+        return QModelIndex();
+    }
+
+    if (!parent.isValid()) {
+        if (row >= m_rootRows.size()) {
+            return QModelIndex();
+        }
+        return createIndex(row, column, quintptr(m_rootRows.at(row)));
+    }
+
+    qint32 parentRecord = recordIndex(parent);
+    if (m_collapsed.contains(parentRecord)) {
+        return QModelIndex();
+    }
+
+    qint32 child = m_tree.childAt(parentRecord, row);
+    if (child == MenuItemRecord::None) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, quintptr(child));
+}
+
+QModelIndex MenuItemModel::parent(const QModelIndex& child) const
+{
+    qint32 parentIndex = child.isValid() ? m_tree.item(recordIndex(child)).parent : MenuItemRecord::None;
+    if (parentIndex == MenuItemRecord::None) {
+        return QModelIndex();
+    }
+
+    int row = m_tree.item(parentIndex).parent == MenuItemRecord::None
+        ? m_rootRows.indexOf(parentIndex)
+        : m_tree.rowOf(parentIndex);
+    return createIndex(row, 0, quintptr(parentIndex));
+}
+
+int MenuItemModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.column() > 0) {
+        return 0;
+    }
+    if (!parent.isValid()) {
+        return m_rootRows.size();
+    }
+
+    qint32 record = recordIndex(parent);
+    return m_collapsed.contains(record) ? 0 : m_tree.childCount(record);
+}
+
+int MenuItemModel::columnCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return 1;
+}
+
+QVariant MenuItemModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    qint32 i = recordIndex(index);
+    const MenuItemRecord& record = m_tree.item(i);
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case TextRole:
+        return m_tree.label(i);
+    case CommandIdRole:
+        return record.commandId;
+    case MenuStateRole:
+        return record.state;
+    case SeparatorRole:
+        return record.isSeparator();
+    case HasSubmenuRole:
+        return record.hasSubmenu();
+    case LevelRole:
+        return int(record.level);
+    case KeyRole:
+        return m_tree.key(i);
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> MenuItemModel::roleNames() const
+{
+    return {
+        { TextRole, "text" },
+        { CommandIdRole, "commandId" },
+        { MenuStateRole, "menuState" },
+        { SeparatorRole, "isSeparator" },
+        { HasSubmenuRole, "hasSubmenu" },
+        { LevelRole, "level" },
+        { KeyRole, "key" }
+    };
 }
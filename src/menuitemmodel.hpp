@@ -1,22 +1,71 @@
 // include/menuitemmodel.hpp
 #pragma once
 
-#include <QObject>
-#include <QVariantList>
+#include <QAbstractItemModel>
+#include <QSet>
+#include <QVector>
+#include "menutree.hpp"
 
-class MenuItemModel : public QObject {
+// The active window's menu tree. Top-level rows are the visible menu bar
+// entries (separators and empty labels are left out); each of them has the
+// submenu items as children.
+//
+// setTree() diffs against the current tree and emits only the row inserts,
+// removes, moves and data changes needed, so views keep their delegates for
+// menu entries that survived.
+class MenuItemModel : public QAbstractItemModel {
     Q_OBJECT
-    Q_PROPERTY(QVariantList items READ items NOTIFY dataChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
 
 public:
+    enum Roles {
+        TextRole = Qt::UserRole + 1,
+        CommandIdRole,
+        MenuStateRole,
+        SeparatorRole,
+        HasSubmenuRole,
+        LevelRole,
+        KeyRole
+    };
+
     explicit MenuItemModel(QObject* parent = nullptr);
 
-    QVariantList items() const;
-    void setItems(const QVariantList& allItems);
+    int count() const { return m_rootRows.size(); }
+    const MenuTree& tree() const { return m_tree; }
+    void setTree(const MenuTree& tree);
+    // Adds a lazily fetched submenu under the item at record
+    void insertChildren(qint32 record, const MenuTree& children);
+    // Updates the MFS_* state of the item at record; views only hear
+    // about that one row
+    void setItemState(qint32 record, quint32 state);
+
+    // Called by view delegates from Component.onCompleted
+    Q_INVOKABLE void delegateCreated() { ++m_delegatesCreated; }
+    // Delegates created since the last call
+    int takeDelegateCount();
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
 
 signals:
-    void dataChanged();
+    void countChanged();
+
+private:
+    qint32 recordIndex(const QModelIndex& index) const;
+    QModelIndex indexForRecord(qint32 record) const;
+    QModelIndex remapIndex(const QModelIndex& index, const MenuTree& tree,
+                           const QVector<qint32>& rootRows) const;
+    static QVector<qint32> visibleRoots(const MenuTree& tree);
+    static bool sameSubtree(const MenuTree& a, qint32 i, const MenuTree& b, qint32 j);
+    static bool sameRecord(const MenuTree& a, qint32 i, const MenuTree& b, qint32 j);
 
 private:
-    QVariantList m_mainItems;
+    MenuTree m_tree;
+    QVector<qint32> m_rootRows; // Tree indices of the visible top-level items
+    QSet<qint32> m_collapsed;   // Rows whose children are hidden mid-update
+    int m_delegatesCreated;
 };
@@ -0,0 +1,40 @@
+// include/menusnapshot.hpp
+#pragma once
+
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include "menutree.hpp"
+
+// Everything MenuController shows for one foreground window. Captured on the
+// snapshot worker and handed to the GUI thread as a whole.
+struct MenuSnapshot {
+    quint64 generation = 0; // Focus change this snapshot belongs to
+    int attempt = 0;        // Re-checks already made for an empty menu
+    quint64 signature = 0;  // MenuTree::signature() of the live menu bar
+    bool treeReused = false; // Cached tree still valid, items left empty
+    quintptr window = 0;
+    QString title;
+    QString processName;
+    MenuTree items;
+};
+
+Q_DECLARE_METATYPE(MenuSnapshot)
+
+// One shown menu level to re-read the item states of: the menu bar or a
+// loaded submenu, with what the view currently has for each item
+struct MenuStateProbe {
+    QString key;             // Parent item, empty for the menu bar
+    quint64 menu = 0;        // Its submenu; unused for the menu bar
+    QVector<quint64> hashes; // MenuTree::stateHash() of the shown items
+};
+
+// A shown item whose state no longer matches the live menu
+struct MenuStateChange {
+    int row = 0; // Among the probed items
+    quint32 commandId = 0;
+    quint32 state = 0;
+};
+
+Q_DECLARE_METATYPE(MenuStateProbe)
+Q_DECLARE_METATYPE(MenuStateChange)
@@ -0,0 +1,81 @@
+// src/menusnapshotcache.cpp
+#include "menusnapshotcache.hpp"
+
+MenuSnapshotCache::MenuSnapshotCache(const WindowSystem* windowSystem, int capacity)
+    : m_windowSystem(windowSystem)
+    , m_capacity(qMax(1, capacity))
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+MenuCacheKey MenuSnapshotCache::keyFor(quintptr window) const
+{
+    MenuCacheKey key;
+    key.window = window;
+    key.processId = m_windowSystem->processId(window);
+    return key;
+}
+
+const MenuSnapshot* MenuSnapshotCache::find(const MenuCacheKey& key)
+{
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd()) {
+        return nullptr;
+    }
+
+    // The window may have been destroyed since it was cached
+    if (!m_windowSystem->isWindow(key.window)) {
+        remove(key);
+        return nullptr;
+    }
+
+    touch(key);
+    return &it.value();
+}
+
+void MenuSnapshotCache::insert(const MenuCacheKey& key, const MenuSnapshot& snapshot)
+{
+    m_entries.insert(key, snapshot);
+    touch(key);
+
+    while (m_recency.size() > m_capacity) {
+        m_entries.remove(m_recency.takeLast());
+    }
+}
+
+void MenuSnapshotCache::remove(const MenuCacheKey& key)
+{
+    m_entries.remove(key);
+    m_recency.removeOne(key);
+}
+
+void MenuSnapshotCache::clear()
+{
+    m_entries.clear();
+    m_recency.clear();
+}
+
+void MenuSnapshotCache::touch(const MenuCacheKey& key)
+{
+    // Capacity is small, a linear scan beats maintaining linked nodes
+    m_recency.removeOne(key);
+    m_recency.prepend(key);
+}
+
+size_t MenuSnapshotCache::memoryUsage() const
+{
+    size_t bytes = 0;
+    for (const MenuSnapshot& snapshot : m_entries) {
+        bytes += sizeof(MenuSnapshot);
+        bytes += (snapshot.title.capacity() + snapshot.processName.capacity()) * sizeof(QChar);
+        bytes += snapshot.items.memoryUsage();
+    }
+    return bytes;
+}
+
+double MenuSnapshotCache::hitRate() const
+{
+    quint64 total = m_hits + m_misses;
+    return total ? double(m_hits) / double(total) : 0.0;
+}
@@ -0,0 +1,62 @@
+// include/menusnapshotcache.hpp
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include "menusnapshot.hpp"
+#include "windowsystem.hpp"
+
+// Identifies a window across handle reuse
+struct MenuCacheKey {
+    quintptr window = 0;
+    quint32 processId = 0;
+
+    bool operator==(const MenuCacheKey& other) const
+    {
+        return window == other.window && processId == other.processId;
+    }
+};
+
+inline size_t qHash(const MenuCacheKey& key, size_t seed = 0)
+{
+    return qHash(key.window, seed) ^ qHash(key.processId, seed);
+}
+
+// Bounded least-recently-used store of the last snapshot taken for each
+// window, so focus coming back to a window can show its menu at once.
+// GUI thread only.
+class MenuSnapshotCache {
+public:
+    // windowSystem must outlive the cache
+    explicit MenuSnapshotCache(const WindowSystem* windowSystem, int capacity = 16);
+
+    MenuCacheKey keyFor(quintptr window) const;
+
+    // Marks the entry as most recently used; nullptr if absent
+    const MenuSnapshot* find(const MenuCacheKey& key);
+    void insert(const MenuCacheKey& key, const MenuSnapshot& snapshot);
+    void remove(const MenuCacheKey& key);
+    void clear();
+
+    int size() const { return m_entries.size(); }
+    int capacity() const { return m_capacity; }
+    size_t memoryUsage() const;
+
+    // Validated reuses vs full enumerations
+    void recordHit() { ++m_hits; }
+    void recordMiss() { ++m_misses; }
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+    double hitRate() const;
+
+private:
+    void touch(const MenuCacheKey& key);
+
+private:
+    const WindowSystem* m_windowSystem;
+    int m_capacity;
+    QHash<MenuCacheKey, MenuSnapshot> m_entries;
+    QList<MenuCacheKey> m_recency; // Most recently used first
+    quint64 m_hits;
+    quint64 m_misses;
+};
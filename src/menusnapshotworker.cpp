@@ -0,0 +1,292 @@
+// src/menusnapshotworker.cpp
+#include "menusnapshotworker.hpp"
+#include "metrics.hpp"
+#include <QDebug>
+#include <QFileInfo>
+
+namespace {
+// New names are written this long after the last miss, so a burst of new
+// applications costs one write and none of it lands in a capture
+const int kNameCacheSaveDelayMs = 5000;
+}
+
+MenuSnapshotWorker::MenuSnapshotWorker(const std::atomic<quint64>* currentGeneration,
+                                       WindowSystem* windowSystem, QObject* parent)
+    : QObject(parent)
+    , m_currentGeneration(currentGeneration)
+    , m_windowSystem(windowSystem)
+    , m_nameCacheSave(new QTimer(this))
+{
+    m_nameCache.load();
+
+    m_nameCacheSave->setSingleShot(true);
+    m_nameCacheSave->setInterval(kNameCacheSaveDelayMs);
+    connect(m_nameCacheSave, &QTimer::timeout, this, &MenuSnapshotWorker::saveNameCache);
+}
+
+MenuSnapshotWorker::~MenuSnapshotWorker()
+{
+    saveNameCache();
+}
+
+void MenuSnapshotWorker::saveNameCache()
+{
+    // No-op unless a miss added a name
+    m_nameCache.save();
+}
+
+bool MenuSnapshotWorker::isStale(quint64 generation) const
+{
+    return generation != m_currentGeneration->load(std::memory_order_acquire);
+}
+
+void MenuSnapshotWorker::capture(quint64 generation, quintptr window, int attempt, quint64 knownSignature)
+{
+    // Focus already moved on while this request sat in the queue
+    if (isStale(generation)) {
+        return;
+    }
+
+    try {
+        MenuSnapshot snapshot;
+        snapshot.generation = generation;
+        snapshot.attempt = attempt;
+        snapshot.window = window;
+        snapshot.title = m_windowSystem->windowTitle(window);
+        snapshot.processName = getProcessName(window);
+
+        if (isStale(generation)) {
+            return;
+        }
+
+        if (knownSignature && getMenuSignature(*m_windowSystem, window) == knownSignature) {
+            snapshot.signature = knownSignature;
+            snapshot.treeReused = true;
+            emit snapshotReady(snapshot);
+            return;
+        }
+
+        {
+            Metrics::Scope enumeration(Metrics::MenuEnumeration);
+            snapshot.items = getWindowMenuItems(*m_windowSystem, window);
+        }
+        Metrics::increment(Metrics::MenuCaptures);
+        snapshot.signature = snapshot.items.signature();
+
+        if (isStale(generation)) {
+            return;
+        }
+
+        emit snapshotReady(snapshot);
+    }
+    catch (const std::exception& e) {
+        qDebug() << "Error capturing menu snapshot:" << e.what();
+    }
+}
+
+void MenuSnapshotWorker::expand(quint64 generation, quintptr window, const QString& key,
+                                quint64 submenu, int level, int depth)
+{
+    if (isStale(generation)) {
+        return;
+    }
+
+    // The handle belongs to the window; do not read it once that is gone
+    if (!m_windowSystem->isWindow(window)) {
+        return;
+    }
+
+    MenuTree children;
+    {
+        Metrics::Scope enumeration(Metrics::MenuEnumeration);
+        enumerateMenu(*m_windowSystem, submenu, children, MenuItemRecord::None, level, depth);
+    }
+
+    if (isStale(generation)) {
+        return;
+    }
+
+    emit submenuReady(generation, key, children);
+}
+
+void MenuSnapshotWorker::refreshState(quint64 generation, quintptr window, const MenuStateProbe& probe)
+{
+    if (isStale(generation)) {
+        return;
+    }
+
+    // A window that is gone takes its handles with it; focus moves on soon
+    QVector<MenuStateChange> changes;
+    if (!m_windowSystem->isWindow(window)) {
+        emit stateReady(generation, window, probe.key, changes, false);
+        return;
+    }
+
+    bool matched = false;
+    {
+        Metrics::Scope refresh(Metrics::MenuStateRefresh);
+        matched = readMenuState(*m_windowSystem, window, probe, changes);
+    }
+
+    if (isStale(generation)) {
+        return;
+    }
+
+    emit stateReady(generation, window, probe.key, changes, !matched);
+}
+
+QString MenuSnapshotWorker::getProcessName(quintptr window)
+{
+    Metrics::Scope resolve(Metrics::ProcessNameResolve);
+
+    try {
+        QString path;
+        qint64 modified = 0;
+        if (!m_windowSystem->processImage(window, path, modified)) {
+            return "Unknown";
+        }
+
+        QString friendly;
+        if (m_nameCache.lookup(path, modified, friendly)) {
+            return friendly;
+        }
+
+        Metrics::increment(Metrics::ProcessNameMisses);
+        friendly = m_windowSystem->describeExecutable(path);
+        if (friendly.isEmpty()) {
+            // Fallback to executable name without extension
+            friendly = QFileInfo(path).completeBaseName();
+        }
+        m_nameCache.insert(path, modified, friendly);
+        m_nameCacheSave->start();
+        return friendly;
+    }
+    catch (const std::exception& e) {
+        qDebug() << "Error getting process name:" << e.what();
+    }
+
+    return "Unknown";
+}
+
+void MenuSnapshotWorker::enumerateMenu(const WindowSystem& system, quint64 menu, MenuTree& tree,
+                                       qint32 parent, int level, int depth)
+{
+    if (!menu || depth == 0) {
+        return;
+    }
+
+    try {
+        int count = system.menuItemCount(menu);
+        if (count == -1) {
+            return;
+        }
+
+        MenuItemRecord record;
+        QString text;
+        MenuTree::Occurrences occurrences;
+        for (int i = 0; i < count; ++i) {
+            if (!system.readMenuItem(menu, i, record, text)) {
+                continue;
+            }
+
+            // Submenus below the depth limit are left for expand()
+            bool descend = record.hasSubmenu() && depth != 1;
+            if (descend) {
+                record.flags |= MenuItemRecord::ChildrenLoaded;
+            }
+
+            record.level = static_cast<quint16>(level);
+            qint32 index = tree.append(parent, record, text, occurrences);
+
+            if (descend) {
+                enumerateMenu(system, record.submenu, tree, index, level + 1, depth - 1);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        qDebug() << "Error enumerating menu:" << e.what();
+    }
+}
+
+MenuTree MenuSnapshotWorker::getWindowMenuItems(const WindowSystem& system, quintptr window)
+{
+    MenuTree tree;
+
+    try {
+        quint64 menuBar = system.menuBar(window);
+        if (menuBar) {
+            // Only the bar itself; submenus are fetched when first needed
+            enumerateMenu(system, menuBar, tree, MenuItemRecord::None, 0, 1);
+        }
+    }
+    catch (const std::exception& e) {
+        qDebug() << "Error getting window menu items:" << e.what();
+    }
+
+    return tree;
+}
+
+quint64 MenuSnapshotWorker::getMenuSignature(const WindowSystem& system, quintptr window)
+{
+    MenuTree topLevel;
+
+    try {
+        quint64 menuBar = system.menuBar(window);
+        int count = menuBar ? system.menuItemCount(menuBar) : 0;
+
+        MenuItemRecord record;
+        QString text;
+        MenuTree::Occurrences occurrences;
+        for (int i = 0; i < count; ++i) {
+            if (system.readMenuItem(menuBar, i, record, text)) {
+                topLevel.append(MenuItemRecord::None, record, text, occurrences);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        qDebug() << "Error reading menu signature:" << e.what();
+    }
+
+    return topLevel.signature();
+}
+
+bool MenuSnapshotWorker::readMenuState(const WindowSystem& system, quintptr window, const MenuStateProbe& probe,
+                                       QVector<MenuStateChange>& changes)
+{
+    try {
+        quint64 menu = probe.key.isEmpty() ? system.menuBar(window) : probe.menu;
+        int count = menu ? system.menuItemCount(menu) : -1;
+        if (count == -1) {
+            return false;
+        }
+
+        // Positions readMenuItemState() skips were skipped by the
+        // enumeration too, so rows pair up with the probed items
+        int row = 0;
+        quint32 commandId = 0;
+        quint32 state = 0;
+        for (int i = 0; i < count; ++i) {
+            if (!system.readMenuItemState(menu, i, commandId, state)) {
+                continue;
+            }
+            if (row >= probe.hashes.size()) {
+                return false;
+            }
+            if (MenuTree::stateHash(commandId, state) != probe.hashes.at(row)) {
+                MenuStateChange change;
+                change.row = row;
+                change.commandId = commandId;
+                change.state = state;
+                changes.append(change);
+            }
+            ++row;
+        }
+
+        return row == probe.hashes.size();
+    }
+    catch (const std::exception& e) {
+        qDebug() << "Error reading menu state:" << e.what();
+    }
+
+    return false;
+}
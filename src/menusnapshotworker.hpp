@@ -0,0 +1,68 @@
+// include/menusnapshotworker.hpp
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <atomic>
+#include "menusnapshot.hpp"
+#include "processnamecache.hpp"
+#include "windowsystem.hpp"
+
+// Lives on MenuController's snapshot thread. Reads title, process name and
+// menu tree of a window without touching the GUI thread.
+class MenuSnapshotWorker : public QObject {
+    Q_OBJECT
+
+public:
+    // currentGeneration is owned by the controller and bumped on every focus
+    // change; requests older than it are dropped before doing any work.
+    // windowSystem must outlive the worker.
+    explicit MenuSnapshotWorker(const std::atomic<quint64>* currentGeneration,
+                                WindowSystem* windowSystem, QObject* parent = nullptr);
+    // Writes process names resolved since the last save
+    ~MenuSnapshotWorker();
+
+    // Friendly name of the window's executable, cached per binary
+    QString getProcessName(quintptr window);
+    // Enumerates depth levels below menu (-1 for all of them)
+    static void enumerateMenu(const WindowSystem& system, quint64 menu, MenuTree& tree,
+                              qint32 parent, int level, int depth);
+    // Top level of the window's menu bar
+    static MenuTree getWindowMenuItems(const WindowSystem& system, quintptr window);
+    // Signature of the top-level items only, without descending
+    static quint64 getMenuSignature(const WindowSystem& system, quintptr window);
+    // Re-reads the item states of the probed menu level and appends the
+    // items whose state hash differs. False when the level no longer has
+    // the probed items, i.e. the menu's structure changed.
+    static bool readMenuState(const WindowSystem& system, quintptr window, const MenuStateProbe& probe,
+                              QVector<MenuStateChange>& changes);
+
+public slots:
+    // knownSignature is the signature of a cached tree for window, or 0.
+    // When the live menu still matches it the tree is not re-enumerated.
+    void capture(quint64 generation, quintptr window, int attempt, quint64 knownSignature);
+    // Reads depth levels of one submenu of window (-1 for all of them); key
+    // names its parent item
+    void expand(quint64 generation, quintptr window, const QString& key, quint64 submenu, int level,
+                int depth);
+    // States only, for a menu level window already shows; no labels read
+    void refreshState(quint64 generation, quintptr window, const MenuStateProbe& probe);
+
+signals:
+    void snapshotReady(const MenuSnapshot& snapshot);
+    void submenuReady(quint64 generation, const QString& key, const MenuTree& children);
+    // Answers every refreshState() that is not stale. structureChanged
+    // means changes is incomplete and the menu needs a capture.
+    void stateReady(quint64 generation, quintptr window, const QString& key,
+                    const QVector<MenuStateChange>& changes, bool structureChanged);
+
+private:
+    bool isStale(quint64 generation) const;
+    void saveNameCache();
+
+private:
+    const std::atomic<quint64>* m_currentGeneration;
+    WindowSystem* m_windowSystem;
+    ProcessNameCache m_nameCache;
+    QTimer* m_nameCacheSave; // Debounces writes off the capture path
+};
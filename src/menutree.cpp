@@ -0,0 +1,257 @@
+// src/menutree.cpp
+#include "menutree.hpp"
+#include <QStringList>
+#include <QVarLengthArray>
+
+namespace {
+// Control characters cannot appear in menu labels
+const QChar kPathSeparator(0x1f);
+const QChar kOccurrenceSeparator(0x1e);
+}
+
+MenuStringPool::MenuStringPool()
+{
+    clear();
+}
+
+MenuStringId MenuStringPool::find(const QString& text) const
+{
+    return m_index.value(text, Missing);
+}
+
+MenuStringId MenuStringPool::intern(const QString& text)
+{
+    auto it = m_index.constFind(text);
+    if (it != m_index.constEnd()) {
+        return it.value();
+    }
+
+    MenuStringId id = static_cast<MenuStringId>(m_strings.size());
+    m_strings.append(text);
+    m_index.insert(text, id);
+    return id;
+}
+
+void MenuStringPool::clear()
+{
+    m_strings.clear();
+    m_index.clear();
+
+    m_strings.append(QString());
+    m_index.insert(QString(), 0);
+}
+
+void MenuStringPool::reserve(int count)
+{
+    m_strings.reserve(count);
+    m_index.reserve(count);
+}
+
+size_t MenuStringPool::memoryUsage() const
+{
+    size_t bytes = m_strings.capacity() * sizeof(QString);
+    for (const QString& text : m_strings) {
+        bytes += text.capacity() * sizeof(QChar);
+    }
+    // Hash nodes share the string data, only the buckets cost extra
+    bytes += m_index.capacity() * (sizeof(QString) + sizeof(MenuStringId) + sizeof(void*));
+    return bytes;
+}
+
+MenuTree::MenuTree()
+    : m_firstRoot(MenuItemRecord::None)
+    , m_lastRoot(MenuItemRecord::None)
+    , m_rootCount(0)
+{
+}
+
+qint32 MenuTree::append(qint32 parent, MenuItemRecord record, const QString& label, Occurrences& occurrences)
+{
+    record.label = m_strings.intern(label);
+    record.occurrence = ++occurrences[record.label];
+    return link(parent, record);
+}
+
+qint32 MenuTree::link(qint32 parent, MenuItemRecord record)
+{
+    qint32 index = m_items.size();
+
+    record.parent = parent;
+    record.firstChild = MenuItemRecord::None;
+    record.lastChild = MenuItemRecord::None;
+    record.nextSibling = MenuItemRecord::None;
+    record.childCount = 0;
+    m_items.append(record);
+
+    if (parent == MenuItemRecord::None) {
+        if (m_lastRoot != MenuItemRecord::None) {
+            m_items[m_lastRoot].nextSibling = index;
+        } else {
+            m_firstRoot = index;
+        }
+        m_lastRoot = index;
+        ++m_rootCount;
+    } else {
+        MenuItemRecord& owner = m_items[parent];
+        if (owner.lastChild != MenuItemRecord::None) {
+            m_items[owner.lastChild].nextSibling = index;
+        } else {
+            owner.firstChild = index;
+        }
+        owner.lastChild = index;
+        ++owner.childCount;
+    }
+
+    return index;
+}
+
+void MenuTree::graft(qint32 parent, const MenuTree& children)
+{
+    graftItems(parent, children, MenuItemRecord::None);
+    m_items[parent].flags |= MenuItemRecord::ChildrenLoaded;
+}
+
+void MenuTree::graftItems(qint32 parent, const MenuTree& from, qint32 fromParent)
+{
+    // Siblings keep their order, so from's occurrence numbers still hold
+    for (qint32 i = from.firstChild(fromParent); i != MenuItemRecord::None; i = from.item(i).nextSibling) {
+        MenuItemRecord record = from.item(i);
+        record.label = m_strings.intern(from.label(i));
+        qint32 index = link(parent, record);
+        graftItems(index, from, i);
+    }
+}
+
+QString MenuTree::key(qint32 index) const
+{
+    QVarLengthArray<qint32, 8> path;
+    for (qint32 i = index; i != MenuItemRecord::None; i = m_items.at(i).parent) {
+        path.append(i);
+    }
+
+    QString key;
+    for (int step = path.size() - 1; step >= 0; --step) {
+        const MenuItemRecord& record = m_items.at(path.at(step));
+        if (step != path.size() - 1) {
+            key += kPathSeparator;
+        }
+        key += m_strings.string(record.label);
+        // Repeated label under the same parent
+        if (record.occurrence > 1) {
+            key += kOccurrenceSeparator + QString::number(record.occurrence);
+        }
+    }
+    return key;
+}
+
+qint32 MenuTree::find(const QString& key) const
+{
+    qint32 index = MenuItemRecord::None;
+    const QVector<KeySegment> path = splitKey(key);
+    for (const KeySegment& segment : path) {
+        // A label the tree never saw cannot be on the path
+        MenuStringId label = m_strings.find(segment.first);
+        if (label == MenuStringPool::Missing) {
+            return MenuItemRecord::None;
+        }
+
+        qint32 child = firstChild(index);
+        while (child != MenuItemRecord::None
+               && (m_items.at(child).label != label || m_items.at(child).occurrence != segment.second)) {
+            child = m_items.at(child).nextSibling;
+        }
+        if (child == MenuItemRecord::None) {
+            return MenuItemRecord::None;
+        }
+        index = child;
+    }
+    return index;
+}
+
+QVector<MenuTree::KeySegment> MenuTree::splitKey(const QString& key)
+{
+    QVector<KeySegment> segments;
+
+    const QStringList parts = key.split(kPathSeparator);
+    for (const QString& part : parts) {
+        int marker = part.lastIndexOf(kOccurrenceSeparator);
+        if (marker < 0) {
+            segments.append(qMakePair(part, 1));
+        } else {
+            segments.append(qMakePair(part.left(marker), part.mid(marker + 1).toInt()));
+        }
+    }
+
+    return segments;
+}
+
+qint32 MenuTree::firstChild(qint32 parent) const
+{
+    return parent == MenuItemRecord::None ? m_firstRoot : m_items.at(parent).firstChild;
+}
+
+int MenuTree::childCount(qint32 parent) const
+{
+    return parent == MenuItemRecord::None ? m_rootCount : m_items.at(parent).childCount;
+}
+
+qint32 MenuTree::childAt(qint32 parent, int row) const
+{
+    qint32 index = firstChild(parent);
+    while (index != MenuItemRecord::None && row-- > 0) {
+        index = m_items.at(index).nextSibling;
+    }
+    return index;
+}
+
+int MenuTree::rowOf(qint32 index) const
+{
+    int row = 0;
+    for (qint32 i = firstChild(m_items.at(index).parent); i != index; i = m_items.at(i).nextSibling) {
+        ++row;
+    }
+    return row;
+}
+
+quint64 MenuTree::signature() const
+{
+    size_t hash = qHash(m_rootCount);
+    for (qint32 i = m_firstRoot; i != MenuItemRecord::None; i = m_items.at(i).nextSibling) {
+        hash = qHash(m_items.at(i).commandId, hash);
+        hash = qHash(label(i), hash);
+    }
+
+    // 0 means "no signature" to the snapshot worker
+    return hash ? quint64(hash) : 1;
+}
+
+quint64 MenuTree::stateHash(quint32 commandId, quint32 state)
+{
+    return quint64(qHash(state, qHash(commandId)));
+}
+
+quint64 MenuTree::stateHash(qint32 index) const
+{
+    const MenuItemRecord& record = m_items.at(index);
+    return stateHash(record.commandId, record.state);
+}
+
+void MenuTree::clear()
+{
+    m_items.clear();
+    m_strings.clear();
+    m_firstRoot = MenuItemRecord::None;
+    m_lastRoot = MenuItemRecord::None;
+    m_rootCount = 0;
+}
+
+void MenuTree::reserve(int count)
+{
+    m_items.reserve(count);
+    m_strings.reserve(count);
+}
+
+size_t MenuTree::memoryUsage() const
+{
+    return m_items.capacity() * sizeof(MenuItemRecord) + m_strings.memoryUsage();
+}
@@ -0,0 +1,137 @@
+// include/menutree.hpp
+#pragma once
+
+#include <QHash>
+#include <QMetaType>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+// Index into a MenuStringPool; 0 is always the empty string
+using MenuStringId = quint32;
+
+// Deduplicating label storage, so repeated labels ("Open", "Recent",
+// plugin entries) are stored once per tree
+class MenuStringPool {
+public:
+    static constexpr MenuStringId Missing = 0xffffffff;
+
+    MenuStringPool();
+
+    MenuStringId intern(const QString& text);
+    // Id of text if it was interned, else Missing
+    MenuStringId find(const QString& text) const;
+    const QString& string(MenuStringId id) const { return m_strings.at(id); }
+    int size() const { return m_strings.size(); }
+
+    void clear();
+    void reserve(int count);
+    size_t memoryUsage() const;
+
+private:
+    QVector<QString> m_strings;
+    QHash<QString, MenuStringId> m_index;
+};
+
+// One menu entry. Plain data; links are indices into MenuTree
+struct MenuItemRecord {
+    enum Flag : quint16 {
+        Separator = 0x1,
+        HasSubmenu = 0x2,
+        ChildrenLoaded = 0x4  // Submenu items have been enumerated
+    };
+
+    static constexpr qint32 None = -1;
+
+    MenuStringId label = 0;
+    quint32 commandId = 0;
+    quint32 state = 0;     // MFS_* flags
+    qint32 parent = None;
+    qint32 firstChild = None;
+    qint32 lastChild = None;
+    qint32 nextSibling = None;
+    qint32 childCount = 0;
+    qint32 occurrence = 1; // Among the siblings with the same label
+    quint16 level = 0;
+    quint16 flags = 0;
+    quint64 submenu = 0;   // HMENU, only meaningful while the window lives
+
+    bool isSeparator() const { return flags & Separator; }
+    bool hasSubmenu() const { return flags & HasSubmenu; }
+    bool needsChildren() const { return (flags & HasSubmenu) && !(flags & ChildrenLoaded); }
+};
+
+// A menu bar as one contiguous array. Top-level items have parent == None.
+// Submenus are enumerated on demand and grafted in later, so children are
+// reached through the link fields rather than by array position.
+//
+// Every item also has a key: the labels on its path, with a sibling
+// occurrence number when labels repeat. Keys stay the same across
+// enumerations of an unchanged menu, so views can hold on to them. They
+// are built from the parent chain when asked for, not stored per item.
+class MenuTree {
+public:
+    // One path step of a key: label and 1-based occurrence among siblings
+    using KeySegment = QPair<QString, int>;
+
+    MenuTree();
+
+    // Label -> items so far under one parent. Kept by the caller while it
+    // appends that parent's items, so the tree does not carry it around.
+    using Occurrences = QHash<MenuStringId, int>;
+
+    // Links record under parent (None for top level) and returns its index.
+    // Pass the same occurrences for all of parent's items.
+    qint32 append(qint32 parent, MenuItemRecord record, const QString& label, Occurrences& occurrences);
+
+    // Appends the whole of children (its top level becomes parent's items)
+    // and marks parent as loaded
+    void graft(qint32 parent, const MenuTree& children);
+
+    int size() const { return m_items.size(); }
+    bool isEmpty() const { return m_items.isEmpty(); }
+    const MenuItemRecord& item(qint32 index) const { return m_items.at(index); }
+    const QString& label(qint32 index) const { return m_strings.string(m_items.at(index).label); }
+    QString key(qint32 index) const;
+
+    // Item with the given key, or None. Walks the key's path, so costs
+    // the sibling count at each level
+    qint32 find(const QString& key) const;
+    static QVector<KeySegment> splitKey(const QString& key);
+
+    qint32 firstChild(qint32 parent) const;
+    int childCount(qint32 parent) const;
+    qint32 childAt(qint32 parent, int row) const;
+    int rowOf(qint32 index) const;
+
+    const MenuStringPool& strings() const { return m_strings; }
+
+    // Hash of the top-level item count, command ids and labels. Cheap to
+    // recompute from a live HMENU, so used to validate cached trees
+    quint64 signature() const;
+
+    // Hash of one item's command id and MFS_* state: what a state refresh
+    // compares, without the labels
+    static quint64 stateHash(quint32 commandId, quint32 state);
+    quint64 stateHash(qint32 index) const;
+    // Only the state changes; links and key stay as they are
+    void setState(qint32 index, quint32 state) { m_items[index].state = state; }
+
+    void clear();
+    void reserve(int count);
+    size_t memoryUsage() const;
+
+private:
+    // record's label and occurrence are already set
+    qint32 link(qint32 parent, MenuItemRecord record);
+    void graftItems(qint32 parent, const MenuTree& from, qint32 fromParent);
+
+private:
+    QVector<MenuItemRecord> m_items;
+    MenuStringPool m_strings;
+    qint32 m_firstRoot;
+    qint32 m_lastRoot;
+    int m_rootCount;
+};
+
+Q_DECLARE_METATYPE(MenuTree)
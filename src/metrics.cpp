@@ -0,0 +1,179 @@
+// src/metrics.cpp
+#include "metrics.hpp"
+
+#ifndef VELOBAR_NO_METRICS
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtAlgorithms>
+#include <atomic>
+
+namespace {
+// Values below 4us get a bucket each; above that, four per power of two up
+// to 2^36us (about 19 hours). The last bucket takes anything larger.
+const int kSubBuckets = 4;
+const int kMaxExponent = 36;
+const int kBuckets = (kMaxExponent - 1) * kSubBuckets;
+
+const char* const kCounterNames[Metrics::CounterCount] = {
+    "focusChanges",
+    "menuCaptures",
+    "menuCacheHits",
+    "processNameMisses",
+    "modelUpdates",
+    "frames",
+    "configReloads",
+    "menuStateChanges",
+    "delegatesCreated",
+};
+
+const char* const kHistogramNames[Metrics::HistogramCount] = {
+    "focusToMenu",
+    "menuEnumeration",
+    "processNameResolve",
+    "networkEvaluate",
+    "powerEvaluate",
+    "modelUpdate",
+    "frameRender",
+    "configReload",
+    "configToFrame",
+    "widgetCreate",
+    "commandIndexSync",
+    "commandSearch",
+    "menuRemoteUpdate",
+    "menuStateRefresh",
+};
+
+struct HistogramData {
+    std::atomic<quint64> buckets[kBuckets];
+    std::atomic<quint64> sumUs;
+    std::atomic<quint64> maxUs;
+};
+
+// Zero-initialised as statics, so usable before main()
+std::atomic<quint64> s_counters[Metrics::CounterCount];
+HistogramData s_histograms[Metrics::HistogramCount];
+
+int bucketFor(quint64 us)
+{
+    if (us < quint64(kSubBuckets)) {
+        return int(us);
+    }
+    int exponent = 63 - qCountLeadingZeroBits(us);
+    if (exponent >= kMaxExponent) {
+        return kBuckets - 1;
+    }
+    int sub = int(us >> (exponent - 2)) & (kSubBuckets - 1);
+    return (exponent - 1) * kSubBuckets + sub;
+}
+
+quint64 bucketLower(int bucket)
+{
+    if (bucket < kSubBuckets) {
+        return quint64(bucket);
+    }
+    int exponent = bucket / kSubBuckets + 1;
+    return quint64(kSubBuckets + bucket % kSubBuckets) << (exponent - 2);
+}
+
+// Midpoint of the bucket holding the given rank, capped at the maximum seen
+quint64 percentile(const quint64* buckets, quint64 count, quint64 maxUs, double fraction)
+{
+    quint64 rank = qMax<quint64>(1, quint64(fraction * double(count) + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            quint64 lower = bucketLower(i);
+            quint64 upper = i + 1 < kBuckets ? bucketLower(i + 1) : maxUs + 1;
+            return qMin(maxUs, lower + (upper - lower - 1) / 2);
+        }
+    }
+    return maxUs;
+}
+}
+
+void Metrics::increment(Counter counter, quint64 amount)
+{
+    s_counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Metrics::record(Histogram histogram, qint64 elapsedUs)
+{
+    quint64 us = quint64(qMax<qint64>(0, elapsedUs));
+    HistogramData& data = s_histograms[histogram];
+    data.buckets[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+    data.sumUs.fetch_add(us, std::memory_order_relaxed);
+
+    quint64 max = data.maxUs.load(std::memory_order_relaxed);
+    while (us > max && !data.maxUs.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+}
+
+Metrics::Summary Metrics::summary(Histogram histogram)
+{
+    const HistogramData& data = s_histograms[histogram];
+
+    // Samples taken while copying may make the totals disagree by a few;
+    // the bucket copy is what percentiles are computed from
+    quint64 buckets[kBuckets];
+    Summary summary;
+    for (int b = 0; b < kBuckets; ++b) {
+        buckets[b] = data.buckets[b].load(std::memory_order_relaxed);
+        summary.count += buckets[b];
+    }
+    summary.sumUs = data.sumUs.load(std::memory_order_relaxed);
+    summary.maxUs = data.maxUs.load(std::memory_order_relaxed);
+    if (summary.count > 0) {
+        summary.p50Us = percentile(buckets, summary.count, summary.maxUs, 0.50);
+        summary.p90Us = percentile(buckets, summary.count, summary.maxUs, 0.90);
+        summary.p99Us = percentile(buckets, summary.count, summary.maxUs, 0.99);
+    }
+    return summary;
+}
+
+QByteArray Metrics::toJson()
+{
+    QJsonObject counters;
+    for (int i = 0; i < CounterCount; ++i) {
+        counters[kCounterNames[i]] = double(s_counters[i].load(std::memory_order_relaxed));
+    }
+
+    QJsonObject histograms;
+    for (int i = 0; i < HistogramCount; ++i) {
+        const Summary data = summary(Histogram(i));
+
+        QJsonObject entry;
+        entry["count"] = double(data.count);
+        entry["sumUs"] = double(data.sumUs);
+        entry["maxUs"] = double(data.maxUs);
+        if (data.count > 0) {
+            entry["p50Us"] = double(data.p50Us);
+            entry["p90Us"] = double(data.p90Us);
+            entry["p99Us"] = double(data.p99Us);
+        }
+        histograms[kHistogramNames[i]] = entry;
+    }
+
+    QJsonObject root;
+    root["counters"] = counters;
+    root["histograms"] = histograms;
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+bool Metrics::write(const QString& path)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(toJson()) < 0 || !file.commit()) {
+        qDebug() << "Failed to write metrics to" << path;
+        return false;
+    }
+    return true;
+}
+
+QString Metrics::exportPath()
+{
+    return qEnvironmentVariable("VELOBAR_METRICS");
+}
+#endif
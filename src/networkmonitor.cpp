@@ -0,0 +1,458 @@
+// src/networkmonitor.cpp
+#include "networkmonitor.hpp"
+#include "metrics.hpp"
+#include "systemprobe.hpp"
+#include "tickscheduler.hpp"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+NetworkMonitor::NetworkMonitor(QObject* parent)
+    : QObject(parent)
+    , m_scheduler(nullptr)
+    , m_reported(false)
+{
+}
+
+NetworkMonitor* NetworkMonitor::create(QObject* parent)
+{
+#if defined(Q_OS_WIN)
+    return new WinNetworkMonitor(parent);
+#elif defined(Q_OS_LINUX)
+    return new NetlinkNetworkMonitor(parent);
+#else
+    return new FakeNetworkMonitor(parent);
+#endif
+}
+
+int NetworkMonitor::strengthFromRssi(int rssi)
+{
+    int signal = qAbs(rssi);
+    if (signal <= 50) return 4;
+    if (signal <= 60) return 3;
+    if (signal <= 70) return 2;
+    return 1;
+}
+
+int NetworkMonitor::strengthFromQuality(int quality)
+{
+    if (quality >= 75) return 4;
+    if (quality >= 50) return 3;
+    if (quality >= 25) return 2;
+    return 1;
+}
+
+void NetworkMonitor::notify(const NetworkState& state)
+{
+    // The first evaluation is always reported so listeners drop their defaults
+    if (m_reported && state == m_state) {
+        return;
+    }
+
+    m_reported = true;
+    m_state = state;
+    emit stateChanged(state);
+}
+
+FakeNetworkMonitor::FakeNetworkMonitor(QObject* parent)
+    : NetworkMonitor(parent)
+    , m_running(false)
+{
+}
+
+bool FakeNetworkMonitor::start()
+{
+    m_running = true;
+    notify(m_pending);
+    return true;
+}
+
+void FakeNetworkMonitor::stop()
+{
+    m_running = false;
+}
+
+void FakeNetworkMonitor::setState(const NetworkState& state)
+{
+    m_pending = state;
+    if (m_running) {
+        notify(state);
+    }
+}
+
+#ifdef Q_OS_WIN
+
+WinNetworkMonitor::WinNetworkMonitor(QObject* parent)
+    : NetworkMonitor(parent)
+    , m_interfaceNotification(nullptr)
+    , m_wlanClient(nullptr)
+    , m_signalNotifications(false)
+    , m_evaluateQueued(false)
+{
+}
+
+WinNetworkMonitor::~WinNetworkMonitor()
+{
+    stop();
+}
+
+bool WinNetworkMonitor::start()
+{
+    if (m_interfaceNotification) {
+        return true;
+    }
+
+    if (NotifyIpInterfaceChange(AF_UNSPEC, interfaceChanged, this, FALSE,
+                                &m_interfaceNotification) != NO_ERROR) {
+        qDebug() << "Failed to register for interface change notifications";
+        m_interfaceNotification = nullptr;
+        return false;
+    }
+
+    // Missing on Server SKUs without the WLAN service; wired state still works
+    DWORD negotiatedVersion = 0;
+    if (WlanOpenHandle(2, nullptr, &negotiatedVersion, &m_wlanClient) != ERROR_SUCCESS) {
+        m_wlanClient = nullptr;
+    }
+
+    evaluate();
+    return true;
+}
+
+void WinNetworkMonitor::stop()
+{
+    // Both calls wait for callbacks already running to return
+    if (m_interfaceNotification) {
+        CancelMibChangeNotify2(m_interfaceNotification);
+        m_interfaceNotification = nullptr;
+    }
+    if (m_wlanClient) {
+        WlanCloseHandle(m_wlanClient, nullptr);
+        m_wlanClient = nullptr;
+        m_signalNotifications = false;
+    }
+}
+
+void WinNetworkMonitor::queueEvaluate()
+{
+    if (!m_evaluateQueued.exchange(true)) {
+        QMetaObject::invokeMethod(this, "evaluate", Qt::QueuedConnection);
+    }
+}
+
+void WinNetworkMonitor::evaluate()
+{
+    m_evaluateQueued = false;
+    Metrics::Scope timing(Metrics::NetworkEvaluate);
+    SystemProbe::Deadline deadline(Metrics::NetworkEvaluate);
+
+    PMIB_IF_TABLE2 table = nullptr;
+    if (GetIfTable2(&table) != NO_ERROR) {
+        qDebug() << "Failed to read interface table";
+        return;
+    }
+
+    bool ethernet = false;
+    bool wifi = false;
+    for (ULONG i = 0; i < table->NumEntries; ++i) {
+        const MIB_IF_ROW2& row = table->Table[i];
+        if (!row.InterfaceAndOperStatusFlags.HardwareInterface || row.OperStatus != IfOperStatusUp) {
+            continue;
+        }
+
+        if (row.Type == IF_TYPE_ETHERNET_CSMACD) {
+            ethernet = true;
+        } else if (row.Type == IF_TYPE_IEEE80211) {
+            wifi = true;
+        }
+    }
+    FreeMibTable(table);
+
+    // Wired takes precedence, so signal only matters on a wireless-only link
+    bool wirelessOnly = wifi && !ethernet;
+    setSignalNotifications(wirelessOnly);
+
+    NetworkState state;
+    state.ethernet = ethernet;
+    state.wifiStrength = wirelessOnly ? qMax(1, sampleWifiStrength()) : 0;
+    notify(state);
+}
+
+int WinNetworkMonitor::sampleWifiStrength()
+{
+    if (!m_wlanClient) {
+        return 0;
+    }
+
+    int strength = 0;
+    PWLAN_INTERFACE_INFO_LIST interfaces = nullptr;
+    if (WlanEnumInterfaces(m_wlanClient, nullptr, &interfaces) != ERROR_SUCCESS) {
+        return 0;
+    }
+
+    for (DWORD i = 0; i < interfaces->dwNumberOfItems && !strength; ++i) {
+        const WLAN_INTERFACE_INFO& info = interfaces->InterfaceInfo[i];
+        if (info.isState != wlan_interface_state_connected) {
+            continue;
+        }
+
+        DWORD size = 0;
+        PWLAN_CONNECTION_ATTRIBUTES attributes = nullptr;
+        if (WlanQueryInterface(m_wlanClient, &info.InterfaceGuid, wlan_intf_opcode_current_connection,
+                               nullptr, &size, reinterpret_cast<PVOID*>(&attributes), nullptr) == ERROR_SUCCESS) {
+            strength = strengthFromQuality(int(attributes->wlanAssociationAttributes.wlanSignalQuality));
+            WlanFreeMemory(attributes);
+        }
+    }
+
+    WlanFreeMemory(interfaces);
+    return strength;
+}
+
+void WinNetworkMonitor::setSignalNotifications(bool enabled)
+{
+    if (!m_wlanClient || enabled == m_signalNotifications) {
+        return;
+    }
+
+    DWORD source = enabled ? WLAN_NOTIFICATION_SOURCE_MSM : WLAN_NOTIFICATION_SOURCE_NONE;
+    if (WlanRegisterNotification(m_wlanClient, source, TRUE, enabled ? wlanNotification : nullptr,
+                                 this, nullptr, nullptr) == ERROR_SUCCESS) {
+        m_signalNotifications = enabled;
+    }
+}
+
+void WINAPI WinNetworkMonitor::interfaceChanged(PVOID context, PMIB_IPINTERFACE_ROW, MIB_NOTIFICATION_TYPE)
+{
+    static_cast<WinNetworkMonitor*>(context)->queueEvaluate();
+}
+
+void WINAPI WinNetworkMonitor::wlanNotification(PWLAN_NOTIFICATION_DATA data, PVOID context)
+{
+    if (data && data->NotificationSource == WLAN_NOTIFICATION_SOURCE_MSM
+        && data->NotificationCode == wlan_notification_msm_signal_quality_change) {
+        static_cast<WinNetworkMonitor*>(context)->queueEvaluate();
+    }
+}
+
+#endif // Q_OS_WIN
+
+#ifdef Q_OS_LINUX
+
+namespace {
+// Nothing announces signal changes over rtnetlink; re-read at this pace
+// while a wireless link is up
+const int kSignalSampleIntervalMs = 10000;
+
+const int kArphrdEther = 1;
+
+QByteArray readAttribute(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll().trimmed();
+}
+}
+
+NetlinkNetworkMonitor::NetlinkNetworkMonitor(QObject* parent, const QString& sysfsRoot,
+                                             const QString& wirelessFile, bool physicalOnly)
+    : NetworkMonitor(parent)
+    , m_sysfsRoot(sysfsRoot)
+    , m_wirelessFile(wirelessFile)
+    , m_physicalOnly(physicalOnly)
+    , m_socket(-1)
+    , m_notifier(nullptr)
+    , m_signalTick(0)
+{
+}
+
+NetlinkNetworkMonitor::~NetlinkNetworkMonitor()
+{
+    stop();
+}
+
+bool NetlinkNetworkMonitor::start()
+{
+    if (m_socket >= 0) {
+        return true;
+    }
+
+    m_socket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (m_socket < 0) {
+        qDebug() << "Failed to open rtnetlink socket:" << strerror(errno);
+        return false;
+    }
+
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        qDebug() << "Failed to bind rtnetlink socket:" << strerror(errno);
+        stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &NetlinkNetworkMonitor::readNetlink);
+
+    if (scheduler()) {
+        m_signalTick = scheduler()->add("wifi-signal", kSignalSampleIntervalMs, this,
+                                        [this]() { evaluate(); });
+        scheduler()->setActive(m_signalTick, false);
+    }
+
+    evaluate();
+    return true;
+}
+
+void NetlinkNetworkMonitor::stop()
+{
+    if (m_signalTick) {
+        scheduler()->remove(m_signalTick);
+        m_signalTick = 0;
+    }
+
+    delete m_notifier;
+    m_notifier = nullptr;
+
+    if (m_socket >= 0) {
+        close(m_socket);
+        m_socket = -1;
+    }
+}
+
+void NetlinkNetworkMonitor::readNetlink()
+{
+    // Drain everything queued and evaluate once for the whole burst
+    bool relevant = false;
+    char buffer[8192];
+    for (;;) {
+        ssize_t length = recv(m_socket, buffer, sizeof(buffer), 0);
+        if (length <= 0) {
+            // ENOBUFS means events were dropped; state must be re-read anyway
+            if (length < 0 && errno == ENOBUFS) {
+                relevant = true;
+                continue;
+            }
+            break;
+        }
+
+        int remaining = int(length);
+        for (nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            switch (header->nlmsg_type) {
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                relevant = true;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (relevant) {
+        evaluate();
+    }
+}
+
+void NetlinkNetworkMonitor::evaluate()
+{
+    Metrics::Scope timing(Metrics::NetworkEvaluate);
+    SystemProbe::Deadline deadline(Metrics::NetworkEvaluate);
+    bool ethernet = false;
+    QString wirelessInterface;
+
+    const QDir root(m_sysfsRoot);
+    const QStringList interfaces = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& name : interfaces) {
+        const QString base = root.filePath(name);
+
+        if (readAttribute(base + "/type").toInt() != kArphrdEther) {
+            continue; // Loopback, tunnels and other non-ethernet framing
+        }
+        if (m_physicalOnly && !QFileInfo::exists(base + "/device")) {
+            continue;
+        }
+
+        // Virtual links without carrier detection report "unknown"
+        QByteArray operstate = readAttribute(base + "/operstate");
+        bool up = operstate == "up"
+            || (operstate == "unknown" && readAttribute(base + "/carrier") == "1");
+        if (!up) {
+            continue;
+        }
+
+        if (QFileInfo::exists(base + "/wireless") || QFileInfo::exists(base + "/phy80211")) {
+            if (wirelessInterface.isEmpty()) {
+                wirelessInterface = name;
+            }
+        } else {
+            ethernet = true;
+        }
+    }
+
+    // Wired takes precedence, so signal only matters on a wireless-only link
+    bool wirelessOnly = !wirelessInterface.isEmpty() && !ethernet;
+
+    NetworkState state;
+    state.ethernet = ethernet;
+    state.wifiStrength = wirelessOnly ? qMax(1, sampleWifiStrength(wirelessInterface)) : 0;
+
+    if (m_signalTick) {
+        scheduler()->setActive(m_signalTick, wirelessOnly);
+    }
+
+    notify(state);
+}
+
+int NetlinkNetworkMonitor::sampleWifiStrength(const QString& interface) const
+{
+    QFile file(m_wirelessFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    // "wlan0: 0000   56.  -54.  -256        0 ..." after two header lines
+    const QByteArray prefix = interface.toLatin1() + ':';
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (!line.startsWith(prefix)) {
+            continue;
+        }
+
+        const QList<QByteArray> fields = line.mid(prefix.size()).simplified().split(' ');
+        if (fields.size() < 3) {
+            return 0;
+        }
+
+        bool ok = false;
+        int level = fields.at(2).chopped(fields.at(2).endsWith('.') ? 1 : 0).toInt(&ok);
+        if (ok && level < 0) {
+            return strengthFromRssi(level);
+        }
+
+        // Drivers without dBm report link quality out of 70
+        int link = fields.at(1).chopped(fields.at(1).endsWith('.') ? 1 : 0).toInt(&ok);
+        return ok ? strengthFromQuality(link * 100 / 70) : 0;
+    }
+
+    return 0;
+}
+
+#endif // Q_OS_LINUX
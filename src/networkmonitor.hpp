@@ -0,0 +1,160 @@
+// include/networkmonitor.hpp
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#include <windows.h>
+#include <iphlpapi.h>
+#include <netioapi.h>
+#include <wlanapi.h>
+#endif
+
+class QSocketNotifier;
+class TickScheduler;
+
+// What the bar shows for connectivity
+struct NetworkState {
+    bool ethernet = false;
+    int wifiStrength = 0; // 0 when no wireless link, otherwise 1-4
+
+    bool operator==(const NetworkState& other) const
+    {
+        return ethernet == other.ethernet && wifiStrength == other.wifiStrength;
+    }
+    bool operator!=(const NetworkState& other) const { return !(*this == other); }
+};
+
+Q_DECLARE_METATYPE(NetworkState)
+
+// Source of connectivity changes. Backends re-evaluate only when the system
+// reports a link or address change instead of being polled.
+class NetworkMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit NetworkMonitor(QObject* parent = nullptr);
+    virtual ~NetworkMonitor() = default;
+
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    // Periodic re-sampling, where a backend needs any, is registered here.
+    // Must be set before start().
+    void setScheduler(TickScheduler* scheduler) { m_scheduler = scheduler; }
+
+    NetworkState state() const { return m_state; }
+
+    // Creates the backend for the running platform
+    static NetworkMonitor* create(QObject* parent = nullptr);
+
+    // Maps received signal strength (dBm) or quality (0-100) to 1-4 bars
+    static int strengthFromRssi(int rssi);
+    static int strengthFromQuality(int quality);
+
+signals:
+    void stateChanged(const NetworkState& state);
+
+protected:
+    TickScheduler* scheduler() const { return m_scheduler; }
+
+    // Emits stateChanged only on a real transition
+    void notify(const NetworkState& state);
+
+private:
+    TickScheduler* m_scheduler;
+    NetworkState m_state;
+    bool m_reported;
+};
+
+// In-process backend driven by hand, used where no native backend exists
+class FakeNetworkMonitor : public NetworkMonitor {
+    Q_OBJECT
+
+public:
+    explicit FakeNetworkMonitor(QObject* parent = nullptr);
+
+    bool start() override;
+    void stop() override;
+
+    void setState(const NetworkState& state);
+
+private:
+    NetworkState m_pending;
+    bool m_running;
+};
+
+#ifdef Q_OS_WIN
+// IP Helper interface-change notifications for link state. WLAN signal
+// quality notifications are only registered while a wireless link is up.
+// Callbacks arrive on system threads and are queued to this object.
+class WinNetworkMonitor : public NetworkMonitor {
+    Q_OBJECT
+
+public:
+    explicit WinNetworkMonitor(QObject* parent = nullptr);
+    ~WinNetworkMonitor();
+
+    bool start() override;
+    void stop() override;
+
+private slots:
+    void evaluate();
+
+private:
+    void queueEvaluate();
+    int sampleWifiStrength();
+    void setSignalNotifications(bool enabled);
+
+    static void WINAPI interfaceChanged(PVOID context, PMIB_IPINTERFACE_ROW row,
+                                        MIB_NOTIFICATION_TYPE type);
+    static void WINAPI wlanNotification(PWLAN_NOTIFICATION_DATA data, PVOID context);
+
+private:
+    HANDLE m_interfaceNotification;
+    HANDLE m_wlanClient;
+    bool m_signalNotifications;
+    std::atomic<bool> m_evaluateQueued; // Coalesces bursts of callbacks
+};
+#endif
+
+#ifdef Q_OS_LINUX
+// rtnetlink link/address multicast groups drive re-evaluation of
+// /sys/class/net. Wireless signal is read from /proc/net/wireless on a
+// slow scheduler tick that only runs while a wireless link is up.
+class NetlinkNetworkMonitor : public NetworkMonitor {
+    Q_OBJECT
+
+public:
+    // sysfsRoot and wirelessFile can point at a fake tree. With
+    // physicalOnly off, virtual links (dummy, veth) count as ethernet.
+    explicit NetlinkNetworkMonitor(QObject* parent = nullptr,
+                                   const QString& sysfsRoot = QStringLiteral("/sys/class/net"),
+                                   const QString& wirelessFile = QStringLiteral("/proc/net/wireless"),
+                                   bool physicalOnly = true);
+    ~NetlinkNetworkMonitor();
+
+    bool start() override;
+    void stop() override;
+
+public slots:
+    void evaluate();
+
+private slots:
+    void readNetlink();
+
+private:
+    int sampleWifiStrength(const QString& interface) const;
+
+private:
+    QString m_sysfsRoot;
+    QString m_wirelessFile;
+    bool m_physicalOnly;
+    int m_socket;
+    QSocketNotifier* m_notifier;
+    int m_signalTick; // TickScheduler source, 0 when not started
+};
+#endif
@@ -0,0 +1,112 @@
+// src/noisebackground.cpp
+#include "noisebackground.hpp"
+#include <QQuickWindow>
+#include <QSGImageNode>
+#include <QSGRectangleNode>
+
+namespace {
+// Power of two so the tile repeats on every graphics backend
+const int kTileSize = 64;
+}
+
+NoiseBackground::NoiseBackground(QQuickItem* parent)
+    : QQuickItem(parent)
+    , m_color(Qt::transparent)
+    , m_strength(0.03)
+    , m_phase(0)
+    , m_textureDirty(true)
+{
+    setFlag(ItemHasContents, true);
+}
+
+void NoiseBackground::setColor(const QColor& color)
+{
+    if (m_color != color) {
+        m_color = color;
+        emit colorChanged();
+        update();
+    }
+}
+
+void NoiseBackground::setStrength(qreal strength)
+{
+    strength = qBound<qreal>(0, strength, 1);
+    if (!qFuzzyCompare(m_strength, strength)) {
+        m_strength = strength;
+        m_textureDirty = true;
+        emit strengthChanged();
+        update();
+    }
+}
+
+void NoiseBackground::setPhase(int phase)
+{
+    if (m_phase != phase) {
+        m_phase = phase;
+        emit phaseChanged();
+        update();
+    }
+}
+
+QImage NoiseBackground::noiseTile(qreal strength)
+{
+    QImage tile(kTileSize, kTileSize, QImage::Format_ARGB32_Premultiplied);
+
+    // Fixed seed so the grain looks the same on every start
+    quint32 seed = 0x9e3779b9u;
+    for (int y = 0; y < kTileSize; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(tile.scanLine(y));
+        for (int x = 0; x < kTileSize; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            // White at the noise's alpha, premultiplied
+            int value = int((seed >> 24) * strength);
+            line[x] = qRgba(value, value, value, value);
+        }
+    }
+
+    return tile;
+}
+
+QSGNode* NoiseBackground::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data)
+{
+    Q_UNUSED(data);
+
+    QSGNode* root = oldNode;
+    QSGRectangleNode* base = nullptr;
+    QSGImageNode* grain = nullptr;
+
+    if (!root) {
+        root = new QSGNode;
+        base = window()->createRectangleNode();
+        grain = window()->createImageNode();
+        grain->setOwnsTexture(true);
+        grain->setFiltering(QSGTexture::Nearest);
+        root->appendChildNode(base);
+        root->appendChildNode(grain);
+        m_textureDirty = true;
+    } else {
+        base = static_cast<QSGRectangleNode*>(root->firstChild());
+        grain = static_cast<QSGImageNode*>(root->lastChild());
+    }
+
+    if (m_textureDirty) {
+        // No atlas: atlased textures cannot repeat
+        QSGTexture* texture = window()->createTextureFromImage(
+            noiseTile(m_strength), QQuickWindow::TextureHasAlphaChannel);
+        texture->setHorizontalWrapMode(QSGTexture::Repeat);
+        texture->setVerticalWrapMode(QSGTexture::Repeat);
+        grain->setTexture(texture);
+        m_textureDirty = false;
+    }
+
+    const QRectF bounds = boundingRect();
+    base->setRect(bounds);
+    base->setColor(m_color);
+
+    // Each phase starts the repeated tile at a different texel
+    QPointF shift((m_phase * 37) % kTileSize, (m_phase * 23) % kTileSize);
+    grain->setRect(bounds);
+    grain->setSourceRect(QRectF(shift, bounds.size()));
+
+    return root;
+}
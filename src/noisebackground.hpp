@@ -0,0 +1,47 @@
+// include/noisebackground.hpp
+#pragma once
+
+#include <QColor>
+#include <QImage>
+#include <QQuickItem>
+#include <QtQml/qqmlregistration.h>
+
+// Flat background with a grain texture on top. The grain is a small noise
+// tile generated once and repeated across the item by the scene graph, so an
+// unchanged bar costs no frames. Bumping phase shifts the tile for an
+// animated look.
+class NoiseBackground : public QQuickItem {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    Q_PROPERTY(qreal strength READ strength WRITE setStrength NOTIFY strengthChanged)
+    Q_PROPERTY(int phase READ phase WRITE setPhase NOTIFY phaseChanged)
+
+public:
+    explicit NoiseBackground(QQuickItem* parent = nullptr);
+
+    QColor color() const { return m_color; }
+    void setColor(const QColor& color);
+    // Peak grain brightness, 0-1
+    qreal strength() const { return m_strength; }
+    void setStrength(qreal strength);
+    int phase() const { return m_phase; }
+    void setPhase(int phase);
+
+signals:
+    void colorChanged();
+    void strengthChanged();
+    void phaseChanged();
+
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+
+private:
+    static QImage noiseTile(qreal strength);
+
+private:
+    QColor m_color;
+    qreal m_strength;
+    int m_phase;
+    bool m_textureDirty; // strength changed since the texture was made
+};
@@ -0,0 +1,380 @@
+// src/powermonitor.cpp
+#include "powermonitor.hpp"
+#include "metrics.hpp"
+#include "systemprobe.hpp"
+#include "tickscheduler.hpp"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+PowerMonitor::PowerMonitor(QObject* parent)
+    : QObject(parent)
+    , m_scheduler(nullptr)
+    , m_reported(false)
+{
+}
+
+PowerMonitor* PowerMonitor::create(QObject* parent)
+{
+#if defined(Q_OS_WIN)
+    return new WinPowerMonitor(parent);
+#elif defined(Q_OS_LINUX)
+    return new SysfsPowerMonitor(parent);
+#else
+    return new FakePowerMonitor(parent);
+#endif
+}
+
+void PowerMonitor::notify(const PowerState& state)
+{
+    // The first evaluation is always reported so listeners drop their defaults
+    if (m_reported && state == m_state) {
+        return;
+    }
+
+    m_reported = true;
+    m_state = state;
+    emit stateChanged(state);
+}
+
+FakePowerMonitor::FakePowerMonitor(QObject* parent)
+    : PowerMonitor(parent)
+    , m_running(false)
+{
+}
+
+bool FakePowerMonitor::start()
+{
+    m_running = true;
+    notify(m_pending);
+    return true;
+}
+
+void FakePowerMonitor::stop()
+{
+    m_running = false;
+}
+
+void FakePowerMonitor::setState(const PowerState& state)
+{
+    m_pending = state;
+    if (m_running) {
+        notify(state);
+    }
+}
+
+#ifdef Q_OS_WIN
+
+WinPowerMonitor::WinPowerMonitor(QObject* parent)
+    : PowerMonitor(parent)
+    , m_sourceNotification(nullptr)
+    , m_percentageNotification(nullptr)
+    , m_evaluateQueued(false)
+{
+    m_subscription.Callback = powerSettingChanged;
+    m_subscription.Context = this;
+}
+
+WinPowerMonitor::~WinPowerMonitor()
+{
+    stop();
+}
+
+bool WinPowerMonitor::start()
+{
+    if (m_sourceNotification) {
+        return true;
+    }
+
+    if (PowerSettingRegisterNotification(&GUID_ACDC_POWER_SOURCE, DEVICE_NOTIFY_CALLBACK,
+                                         reinterpret_cast<HANDLE>(&m_subscription), &m_sourceNotification) != ERROR_SUCCESS) {
+        qDebug() << "Failed to register for power source notifications";
+        m_sourceNotification = nullptr;
+        return false;
+    }
+
+    // Desktops without a battery still report the power source
+    if (PowerSettingRegisterNotification(&GUID_BATTERY_PERCENTAGE_REMAINING, DEVICE_NOTIFY_CALLBACK,
+                                         reinterpret_cast<HANDLE>(&m_subscription), &m_percentageNotification) != ERROR_SUCCESS) {
+        m_percentageNotification = nullptr;
+    }
+
+    evaluate();
+    return true;
+}
+
+void WinPowerMonitor::stop()
+{
+    if (m_sourceNotification) {
+        PowerSettingUnregisterNotification(m_sourceNotification);
+        m_sourceNotification = nullptr;
+    }
+    if (m_percentageNotification) {
+        PowerSettingUnregisterNotification(m_percentageNotification);
+        m_percentageNotification = nullptr;
+    }
+}
+
+void WinPowerMonitor::queueEvaluate()
+{
+    if (!m_evaluateQueued.exchange(true)) {
+        QMetaObject::invokeMethod(this, "evaluate", Qt::QueuedConnection);
+    }
+}
+
+void WinPowerMonitor::evaluate()
+{
+    m_evaluateQueued = false;
+    Metrics::Scope timing(Metrics::PowerEvaluate);
+    SystemProbe::Deadline deadline(Metrics::PowerEvaluate);
+
+    SYSTEM_POWER_STATUS powerStatus;
+    if (!GetSystemPowerStatus(&powerStatus)) {
+        return;
+    }
+
+    PowerState state;
+    state.onBattery = (powerStatus.ACLineStatus == 0);
+    state.level = (powerStatus.BatteryLifePercent == 255) ? 100 : powerStatus.BatteryLifePercent;
+    notify(state);
+}
+
+ULONG CALLBACK WinPowerMonitor::powerSettingChanged(PVOID context, ULONG type, PVOID)
+{
+    if (type == PBT_POWERSETTINGCHANGE) {
+        static_cast<WinPowerMonitor*>(context)->queueEvaluate();
+    }
+    return ERROR_SUCCESS;
+}
+
+#endif // Q_OS_WIN
+
+#ifdef Q_OS_LINUX
+
+namespace {
+// Only for batteries that do not announce capacity changes
+const int kResyncIntervalMs = 60000;
+
+int openAttribute(const QString& path)
+{
+    return open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+}
+}
+
+SysfsPowerMonitor::SysfsPowerMonitor(QObject* parent, const QString& sysfsRoot)
+    : PowerMonitor(parent)
+    , m_sysfsRoot(sysfsRoot)
+    , m_socket(-1)
+    , m_notifier(nullptr)
+    , m_resyncTick(0)
+{
+}
+
+SysfsPowerMonitor::~SysfsPowerMonitor()
+{
+    stop();
+}
+
+bool SysfsPowerMonitor::start()
+{
+    if (m_socket >= 0) {
+        return true;
+    }
+
+    m_socket = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (m_socket < 0) {
+        qDebug() << "Failed to open uevent socket:" << strerror(errno);
+        return false;
+    }
+
+    // Group 1 carries the kernel's own uevents, no udev daemon needed
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1;
+    if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        qDebug() << "Failed to bind uevent socket:" << strerror(errno);
+        stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &SysfsPowerMonitor::readUevents);
+
+    if (scheduler()) {
+        m_resyncTick = scheduler()->add("power-resync", kResyncIntervalMs, this,
+                                        [this]() { evaluate(); },
+                                        TickScheduler::ThrottleIdle | TickScheduler::PauseWhenLocked);
+        scheduler()->setActive(m_resyncTick, false);
+    }
+
+    rescan();
+    return true;
+}
+
+void SysfsPowerMonitor::stop()
+{
+    if (m_resyncTick) {
+        scheduler()->remove(m_resyncTick);
+        m_resyncTick = 0;
+    }
+
+    delete m_notifier;
+    m_notifier = nullptr;
+
+    if (m_socket >= 0) {
+        close(m_socket);
+        m_socket = -1;
+    }
+
+    closeSupplies();
+}
+
+void SysfsPowerMonitor::closeSupplies()
+{
+    for (const Supply& supply : m_supplies) {
+        for (int fd : { supply.onlineFd, supply.capacityFd, supply.statusFd }) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+    m_supplies.clear();
+}
+
+void SysfsPowerMonitor::rescan()
+{
+    closeSupplies();
+
+    const QDir root(m_sysfsRoot);
+    const QStringList names = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& name : names) {
+        const QString base = root.filePath(name);
+
+        QFile typeFile(base + "/type");
+        QFile scopeFile(base + "/scope");
+        QByteArray type = typeFile.open(QIODevice::ReadOnly) ? typeFile.readAll().trimmed() : QByteArray();
+        QByteArray scope = scopeFile.open(QIODevice::ReadOnly) ? scopeFile.readAll().trimmed() : QByteArray();
+
+        // Peripherals (mice, headsets) report their own batteries
+        if (scope == "Device") {
+            continue;
+        }
+
+        Supply supply;
+        if (type == "Battery") {
+            supply.battery = true;
+            supply.capacityFd = openAttribute(base + "/capacity");
+            supply.statusFd = openAttribute(base + "/status");
+            if (supply.capacityFd < 0) {
+                continue;
+            }
+        } else if (type == "Mains" || type.startsWith("USB")) {
+            supply.onlineFd = openAttribute(base + "/online");
+            if (supply.onlineFd < 0) {
+                continue;
+            }
+        } else {
+            continue;
+        }
+
+        m_supplies.append(supply);
+    }
+
+    evaluate();
+}
+
+QByteArray SysfsPowerMonitor::readFd(int fd)
+{
+    // sysfs regenerates the value on every read from offset 0
+    char buffer[64];
+    ssize_t length = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (length <= 0) {
+        return QByteArray();
+    }
+    return QByteArray(buffer, int(length)).trimmed();
+}
+
+void SysfsPowerMonitor::evaluate()
+{
+    Metrics::Scope timing(Metrics::PowerEvaluate);
+    SystemProbe::Deadline deadline(Metrics::PowerEvaluate);
+    bool haveMains = false;
+    bool mainsOnline = false;
+    bool discharging = false;
+    int batteries = 0;
+    int capacity = 0;
+
+    for (const Supply& supply : m_supplies) {
+        if (supply.battery) {
+            ++batteries;
+            capacity += readFd(supply.capacityFd).toInt();
+            if (supply.statusFd >= 0 && readFd(supply.statusFd) == "Discharging") {
+                discharging = true;
+            }
+        } else {
+            haveMains = true;
+            if (readFd(supply.onlineFd) == "1") {
+                mainsOnline = true;
+            }
+        }
+    }
+
+    PowerState state;
+    if (batteries > 0) {
+        state.level = qBound(0, capacity / batteries, 100);
+        state.onBattery = haveMains ? !mainsOnline : discharging;
+    }
+
+    if (m_resyncTick) {
+        scheduler()->setActive(m_resyncTick, state.onBattery);
+    }
+
+    notify(state);
+}
+
+void SysfsPowerMonitor::readUevents()
+{
+    // Drain the socket and act once for the whole burst
+    bool changed = false;
+    bool added = false;
+    char buffer[4096];
+    for (;;) {
+        ssize_t length = recv(m_socket, buffer, sizeof(buffer) - 1, 0);
+        if (length <= 0) {
+            if (length < 0 && errno == ENOBUFS) {
+                added = true; // Events were lost; start over
+                continue;
+            }
+            break;
+        }
+
+        // "ACTION@devpath\0KEY=VALUE\0..."
+        const QByteArray message(buffer, int(length));
+        if (!message.contains("SUBSYSTEM=power_supply")) {
+            continue;
+        }
+
+        changed = true;
+        if (message.startsWith("add@") || message.startsWith("remove@")) {
+            added = true;
+        }
+    }
+
+    if (added) {
+        rescan();
+    } else if (changed) {
+        evaluate();
+    }
+}
+
+#endif // Q_OS_LINUX
@@ -0,0 +1,157 @@
+// include/powermonitor.hpp
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <powrprof.h>
+#endif
+
+class QSocketNotifier;
+class TickScheduler;
+
+// What the bar shows for power
+struct PowerState {
+    bool onBattery = false;
+    int level = 100; // Percent; 100 when there is no battery
+
+    bool operator==(const PowerState& other) const
+    {
+        return onBattery == other.onBattery && level == other.level;
+    }
+    bool operator!=(const PowerState& other) const { return !(*this == other); }
+};
+
+Q_DECLARE_METATYPE(PowerState)
+
+// Source of power supply changes, driven by system notifications rather
+// than a polling timer
+class PowerMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PowerMonitor(QObject* parent = nullptr);
+    virtual ~PowerMonitor() = default;
+
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    // Periodic re-sampling, where a backend needs any, is registered here.
+    // Must be set before start().
+    void setScheduler(TickScheduler* scheduler) { m_scheduler = scheduler; }
+
+    PowerState state() const { return m_state; }
+
+    // Creates the backend for the running platform
+    static PowerMonitor* create(QObject* parent = nullptr);
+
+signals:
+    void stateChanged(const PowerState& state);
+
+protected:
+    TickScheduler* scheduler() const { return m_scheduler; }
+
+    // Emits stateChanged only on a real transition
+    void notify(const PowerState& state);
+
+private:
+    TickScheduler* m_scheduler;
+    PowerState m_state;
+    bool m_reported;
+};
+
+// In-process backend driven by hand, used where no native backend exists
+class FakePowerMonitor : public PowerMonitor {
+    Q_OBJECT
+
+public:
+    explicit FakePowerMonitor(QObject* parent = nullptr);
+
+    bool start() override;
+    void stop() override;
+
+    void setState(const PowerState& state);
+
+private:
+    PowerState m_pending;
+    bool m_running;
+};
+
+#ifdef Q_OS_WIN
+// Power-setting callbacks for the AC/DC source and remaining battery
+// percentage. Callbacks arrive on system threads and are queued to this
+// object.
+class WinPowerMonitor : public PowerMonitor {
+    Q_OBJECT
+
+public:
+    explicit WinPowerMonitor(QObject* parent = nullptr);
+    ~WinPowerMonitor();
+
+    bool start() override;
+    void stop() override;
+
+private slots:
+    void evaluate();
+
+private:
+    void queueEvaluate();
+
+    static ULONG CALLBACK powerSettingChanged(PVOID context, ULONG type, PVOID setting);
+
+private:
+    HPOWERNOTIFY m_sourceNotification;
+    HPOWERNOTIFY m_percentageNotification;
+    DEVICE_NOTIFY_SUBSCRIBE_PARAMETERS m_subscription;
+    std::atomic<bool> m_evaluateQueued; // Coalesces bursts of callbacks
+};
+#endif
+
+#ifdef Q_OS_LINUX
+// Reads /sys/class/power_supply through descriptors that stay open and are
+// re-read with pread(). Kernel uevents for the power_supply subsystem drive
+// updates. Some ACPI batteries do not announce capacity changes, so a slow
+// resync runs while discharging.
+class SysfsPowerMonitor : public PowerMonitor {
+    Q_OBJECT
+
+public:
+    // sysfsRoot can point at a fake tree
+    explicit SysfsPowerMonitor(QObject* parent = nullptr,
+                               const QString& sysfsRoot = QStringLiteral("/sys/class/power_supply"));
+    ~SysfsPowerMonitor();
+
+    bool start() override;
+    void stop() override;
+
+public slots:
+    void evaluate();
+    // Re-opens the attribute files after supplies come or go
+    void rescan();
+
+private slots:
+    void readUevents();
+
+private:
+    struct Supply {
+        bool battery = false;
+        int onlineFd = -1;   // Mains/USB "online"
+        int capacityFd = -1; // Battery "capacity"
+        int statusFd = -1;   // Battery "status"
+    };
+
+    void closeSupplies();
+    static QByteArray readFd(int fd);
+
+private:
+    QString m_sysfsRoot;
+    QVector<Supply> m_supplies;
+    int m_socket;
+    QSocketNotifier* m_notifier;
+    int m_resyncTick; // TickScheduler source, 0 when not started
+};
+#endif
@@ -0,0 +1,124 @@
+// src/processnamecache.cpp
+#include "processnamecache.hpp"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+const quint32 kFileMagic = 0x56424e43; // "VBNC"
+const quint16 kFileVersion = 1;
+
+// Stale entries for uninstalled binaries are dropped past this size
+const int kMaxEntries = 1024;
+}
+
+ProcessNameCache::ProcessNameCache(const QString& filePath)
+    : m_filePath(filePath)
+    , m_dirty(false)
+{
+}
+
+QString ProcessNameCache::defaultFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+        + QStringLiteral("/process-names.cache");
+}
+
+QString ProcessNameCache::normalizedPath(const QString& path)
+{
+    // Windows paths are case-insensitive
+    return QDir::fromNativeSeparators(path).toLower();
+}
+
+bool ProcessNameCache::lookup(const QString& path, qint64 modified, QString& name) const
+{
+    auto it = m_entries.constFind(normalizedPath(path));
+    if (it == m_entries.constEnd() || it->modified != modified) {
+        return false;
+    }
+
+    name = it->name;
+    return true;
+}
+
+void ProcessNameCache::insert(const QString& path, qint64 modified, const QString& name)
+{
+    if (m_entries.size() >= kMaxEntries) {
+        m_entries.clear();
+    }
+
+    Entry entry;
+    entry.modified = modified;
+    entry.name = name;
+    m_entries.insert(normalizedPath(path), entry);
+    m_dirty = true;
+}
+
+bool ProcessNameCache::load()
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != kFileMagic || version != kFileVersion || count > quint32(kMaxEntries)) {
+        qDebug() << "Ignoring process name cache with unknown format:" << m_filePath;
+        return false;
+    }
+
+    m_entries.clear();
+    m_entries.reserve(int(count));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Entry entry;
+        in >> path >> entry.modified >> entry.name;
+        m_entries.insert(path, entry);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "Process name cache is truncated:" << m_filePath;
+        m_entries.clear();
+        return false;
+    }
+
+    m_dirty = false;
+    return true;
+}
+
+bool ProcessNameCache::save()
+{
+    if (!m_dirty) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to write process name cache:" << m_filePath;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << kFileMagic << kFileVersion << quint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        out << it.key() << it->modified << it->name;
+    }
+
+    if (!file.commit()) {
+        qDebug() << "Failed to write process name cache:" << m_filePath;
+        return false;
+    }
+
+    m_dirty = false;
+    return true;
+}
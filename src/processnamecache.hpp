@@ -0,0 +1,38 @@
+// include/processnamecache.hpp
+#pragma once
+
+#include <QHash>
+#include <QString>
+
+// Friendly application names keyed by executable path and modification
+// time. Kept in memory and mirrored to a small binary file in the app data
+// directory, so each binary's version resource is parsed about once per
+// install instead of on every focus change.
+class ProcessNameCache {
+public:
+    explicit ProcessNameCache(const QString& filePath = defaultFilePath());
+
+    static QString defaultFilePath();
+
+    bool lookup(const QString& path, qint64 modified, QString& name) const;
+    void insert(const QString& path, qint64 modified, const QString& name);
+
+    bool load();
+    // Writes only when something changed since the last load or save
+    bool save();
+
+    int size() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        qint64 modified = 0;
+        QString name;
+    };
+
+    static QString normalizedPath(const QString& path);
+
+private:
+    QString m_filePath;
+    QHash<QString, Entry> m_entries;
+    bool m_dirty;
+};
@@ -0,0 +1,376 @@
+// src/settings.cpp
+#include "settings.hpp"
+#include "metrics.hpp"
+#include "widgetregistry.hpp"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+namespace {
+const char kFileName[] = "velobar.yaml";
+const int kReloadDelayMs = 100;
+
+// Defaults match the bar as it looked before it was configurable
+const int kDefaultBarHeight = 30;
+const QRgb kDefaultBorderColor = 0x28949494;
+const int kDefaultBlurRadius = 10;
+
+struct Line {
+    int number;
+    int indent;
+    QString text; // Without indentation and comment
+};
+
+// Removes a # comment that is not inside quotes
+QString stripComment(const QString& line)
+{
+    QChar quote;
+    for (int i = 0; i < line.size(); ++i) {
+        const QChar c = line.at(i);
+        if (!quote.isNull()) {
+            if (c == quote) {
+                quote = QChar();
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '#' && (i == 0 || line.at(i - 1).isSpace())) {
+            return line.left(i);
+        }
+    }
+    return line;
+}
+
+QVariant scalar(const QString& text)
+{
+    if (text.size() >= 2 && (text.startsWith('"') || text.startsWith('\''))
+        && text.endsWith(text.at(0))) {
+        return text.mid(1, text.size() - 2);
+    }
+    if (text == "true" || text == "yes") {
+        return true;
+    }
+    if (text == "false" || text == "no") {
+        return false;
+    }
+    if (text.isEmpty() || text == "~" || text == "null") {
+        return QVariant();
+    }
+
+    bool ok = false;
+    int integer = text.toInt(&ok);
+    if (ok) {
+        return integer;
+    }
+    double number = text.toDouble(&ok);
+    if (ok) {
+        return number;
+    }
+    return text;
+}
+
+class Parser {
+public:
+    Parser(const QVector<Line>& lines, QString* error)
+        : m_lines(lines)
+        , m_error(error)
+        , m_pos(0)
+    {
+    }
+
+    // The block starting at the current line, all of whose lines are
+    // indented by indent
+    QVariant block(int indent)
+    {
+        if (m_lines.at(m_pos).text.startsWith("- ") || m_lines.at(m_pos).text == "-") {
+            return list(indent);
+        }
+        return map(indent);
+    }
+
+    bool atEnd() const { return m_pos >= m_lines.size(); }
+    int lineNumber() const { return atEnd() ? 0 : m_lines.at(m_pos).number; }
+    bool failed() const { return !m_error->isEmpty(); }
+
+private:
+    QVariant map(int indent)
+    {
+        QVariantMap result;
+        while (!atEnd() && !failed()) {
+            const Line& line = m_lines.at(m_pos);
+            if (line.indent < indent) {
+                break;
+            }
+            if (line.indent > indent) {
+                return fail(line, "unexpected indentation");
+            }
+
+            int colon = line.text.indexOf(':');
+            while (colon >= 0 && colon + 1 < line.text.size() && !line.text.at(colon + 1).isSpace()) {
+                colon = line.text.indexOf(':', colon + 1);
+            }
+            if (colon <= 0) {
+                return fail(line, "expected \"key: value\"");
+            }
+
+            QString key = line.text.left(colon).trimmed();
+            QString rest = line.text.mid(colon + 1).trimmed();
+            ++m_pos;
+
+            if (!rest.isEmpty()) {
+                result.insert(key, scalar(rest));
+            } else if (!atEnd() && m_lines.at(m_pos).indent > indent) {
+                result.insert(key, block(m_lines.at(m_pos).indent));
+            } else {
+                result.insert(key, QVariant());
+            }
+        }
+        return result;
+    }
+
+    QVariant list(int indent)
+    {
+        QVariantList result;
+        while (!atEnd() && !failed()) {
+            const Line& line = m_lines.at(m_pos);
+            if (line.indent < indent) {
+                break;
+            }
+            if (line.indent > indent || !(line.text.startsWith("- ") || line.text == "-")) {
+                return fail(line, "expected a \"- \" list item");
+            }
+            result.append(scalar(line.text.mid(1).trimmed()));
+            ++m_pos;
+        }
+        return result;
+    }
+
+    QVariant fail(const Line& line, const char* message)
+    {
+        *m_error = QString("line %1: %2").arg(line.number).arg(QString::fromLatin1(message));
+        return QVariant();
+    }
+
+private:
+    const QVector<Line>& m_lines;
+    QString* m_error;
+    int m_pos;
+};
+
+// Assigns value to field and emits signal when they differ
+template <typename T>
+void update(Settings* settings, T& field, const T& value, void (Settings::*signal)(), int& changed)
+{
+    if (field == value) {
+        return;
+    }
+    field = value;
+    ++changed;
+    emit (settings->*signal)();
+}
+
+QVariant lookup(const QVariantMap& config, const char* path)
+{
+    QVariant value = config;
+    const QStringList keys = QString::fromLatin1(path).split('.');
+    for (const QString& key : keys) {
+        value = value.toMap().value(key);
+    }
+    return value;
+}
+
+QColor colorValue(const QVariant& value, const QColor& fallback)
+{
+    QColor color(value.toString());
+    return value.isValid() && color.isValid() ? color : fallback;
+}
+}
+
+Settings::Settings(QObject* parent)
+    : QObject(parent)
+    , m_themeName("default")
+    , m_widgets(WidgetRegistry::defaultLayout())
+    , m_barHeight(kDefaultBarHeight)
+    , m_baseColor(Qt::transparent)
+    , m_borderColor(QColor::fromRgba(kDefaultBorderColor))
+    , m_borderWidth(1)
+    , m_blurEnabled(true)
+    , m_blurRadius(kDefaultBlurRadius)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(kReloadDelayMs);
+    connect(&m_debounce, &QTimer::timeout, this, &Settings::reload);
+
+    // Saving through a temporary file replaces the watched one, which drops
+    // the watch; the directory event catches that case
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, &m_debounce, qOverload<>(&QTimer::start));
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, &m_debounce, qOverload<>(&QTimer::start));
+}
+
+QString Settings::defaultFilePath()
+{
+    const QString fromEnvironment = qEnvironmentVariable("VELOBAR_CONFIG");
+    if (!fromEnvironment.isEmpty()) {
+        return fromEnvironment;
+    }
+
+    const QStringList candidates = {
+        QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) + '/' + kFileName,
+        QCoreApplication::applicationDirPath() + '/' + kFileName,
+    };
+    for (const QString& candidate : candidates) {
+        if (QFileInfo::exists(candidate)) {
+            return candidate;
+        }
+    }
+    return QString();
+}
+
+bool Settings::load(const QString& path)
+{
+    m_filePath = path;
+    if (m_filePath.isEmpty()) {
+        return false;
+    }
+
+    watch();
+    reload();
+    return true;
+}
+
+void Settings::watch()
+{
+    const QString directory = QFileInfo(m_filePath).absolutePath();
+    if (!m_watcher.directories().contains(directory)) {
+        m_watcher.addPath(directory);
+    }
+    if (QFileInfo::exists(m_filePath) && !m_watcher.files().contains(m_filePath)) {
+        m_watcher.addPath(m_filePath);
+    }
+}
+
+void Settings::reload()
+{
+    // Re-add the file if an atomic save replaced it
+    watch();
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    // The directory watch also fires for unrelated files next to it. The
+    // contents are compared, not the modification time and size: an edit
+    // of the same length can land within the file system's time resolution.
+    const QByteArray contents = file.readAll();
+    if (contents == m_fileContents) {
+        return;
+    }
+    m_fileContents = contents;
+
+    QString error;
+    const QVariantMap config = parse(contents, &error);
+    if (!error.isEmpty()) {
+        qDebug() << "Ignoring invalid config" << m_filePath << error;
+        return;
+    }
+
+    int changed = apply(config);
+    qint64 elapsedUs = elapsed.nsecsElapsed() / 1000;
+    Metrics::record(Metrics::ConfigReload, elapsedUs);
+    Metrics::increment(Metrics::ConfigReloads);
+    emit reloaded(elapsedUs, changed);
+}
+
+int Settings::apply(const QVariantMap& config)
+{
+    int changed = 0;
+
+    QString themeName = lookup(config, "theme.name").toString();
+    update(this, m_themeName, themeName.isEmpty() ? QString("default") : themeName,
+           &Settings::themeNameChanged, changed);
+    update(this, m_resourcePaths, lookup(config, "resources.paths").toStringList(),
+           &Settings::resourcePathsChanged, changed);
+    QVariant widgets = lookup(config, "theme.widgets");
+    update(this, m_widgets, widgets.isValid() ? widgets.toStringList() : WidgetRegistry::defaultLayout(),
+           &Settings::widgetsChanged, changed);
+    update(this, m_widgetPlugins, lookup(config, "theme.plugins").toMap(),
+           &Settings::widgetPluginsChanged, changed);
+
+    QVariant height = lookup(config, "base.height");
+    update(this, m_barHeight, height.isValid() ? qBound(16, height.toInt(), 200) : kDefaultBarHeight,
+           &Settings::barHeightChanged, changed);
+    update(this, m_baseColor, colorValue(lookup(config, "base.color"), QColor(Qt::transparent)),
+           &Settings::baseColorChanged, changed);
+    update(this, m_borderColor,
+           colorValue(lookup(config, "base.border.color"), QColor::fromRgba(kDefaultBorderColor)),
+           &Settings::borderColorChanged, changed);
+    QVariant borderWidth = lookup(config, "base.border.width");
+    update(this, m_borderWidth, borderWidth.isValid() ? qBound(0, borderWidth.toInt(), 16) : 1,
+           &Settings::borderWidthChanged, changed);
+
+    QVariant blurEnabled = lookup(config, "effects.blur.enabled");
+    update(this, m_blurEnabled, blurEnabled.isValid() ? blurEnabled.toBool() : true,
+           &Settings::blurEnabledChanged, changed);
+    QVariant blurRadius = lookup(config, "effects.blur.radius");
+    update(this, m_blurRadius, blurRadius.isValid() ? qMax(0, blurRadius.toInt()) : kDefaultBlurRadius,
+           &Settings::blurRadiusChanged, changed);
+
+    QHash<QString, int> intervals;
+    const QVariantMap samplers = config.value("samplers").toMap();
+    for (auto it = samplers.constBegin(); it != samplers.constEnd(); ++it) {
+        int intervalMs = it.value().toInt();
+        if (intervalMs > 0) {
+            intervals.insert(it.key(), intervalMs);
+        }
+    }
+    update(this, m_samplerIntervals, intervals, &Settings::samplerIntervalsChanged, changed);
+
+    return changed;
+}
+
+QVariantMap Settings::parse(const QByteArray& text, QString* error)
+{
+    QVector<Line> lines;
+    const QStringList rawLines = QString::fromUtf8(text).split('\n');
+    for (int i = 0; i < rawLines.size(); ++i) {
+        QString raw = stripComment(rawLines.at(i));
+        raw.remove('\r');
+        if (raw.trimmed().isEmpty()) {
+            continue;
+        }
+
+        int indent = 0;
+        while (raw.at(indent) == ' ') {
+            ++indent;
+        }
+        if (raw.at(indent) == '\t') {
+            *error = QString("line %1: tabs are not allowed for indentation").arg(i + 1);
+            return QVariantMap();
+        }
+        lines.append({ i + 1, indent, raw.mid(indent).trimmed() });
+    }
+
+    error->clear();
+    if (lines.isEmpty()) {
+        return QVariantMap();
+    }
+
+    Parser parser(lines, error);
+    QVariant root = parser.block(lines.first().indent);
+    if (!parser.failed() && !parser.atEnd()) {
+        *error = QString("line %1: unexpected indentation").arg(parser.lineNumber());
+    }
+    if (!error->isEmpty() || root.typeId() != QMetaType::QVariantMap) {
+        if (error->isEmpty()) {
+            *error = "top level must be a map";
+        }
+        return QVariantMap();
+    }
+    return root.toMap();
+}
@@ -0,0 +1,108 @@
+// include/settings.hpp
+#pragma once
+
+#include <QColor>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+#include <QtQml/qqmlregistration.h>
+
+// Typed view of velobar.yaml. Parsed once at startup and again whenever the
+// file changes on disk; each value that actually changed emits its own
+// signal, so QML bindings and the controller update just what the edit
+// touched and the scene is never reloaded. A file that fails to parse
+// leaves the current values in place.
+//
+// Only the subset of YAML the config uses is understood: nested maps by
+// indentation, "- " lists of scalars, quoted or plain scalars and comments.
+class Settings : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Use topbarController.settings")
+    Q_PROPERTY(QString themeName READ themeName NOTIFY themeNameChanged)
+    Q_PROPERTY(QStringList resourcePaths READ resourcePaths NOTIFY resourcePathsChanged)
+    Q_PROPERTY(QStringList widgets READ widgets NOTIFY widgetsChanged)
+    Q_PROPERTY(int barHeight READ barHeight NOTIFY barHeightChanged)
+    Q_PROPERTY(QColor baseColor READ baseColor NOTIFY baseColorChanged)
+    Q_PROPERTY(QColor borderColor READ borderColor NOTIFY borderColorChanged)
+    Q_PROPERTY(int borderWidth READ borderWidth NOTIFY borderWidthChanged)
+    Q_PROPERTY(bool blurEnabled READ blurEnabled NOTIFY blurEnabledChanged)
+    Q_PROPERTY(int blurRadius READ blurRadius NOTIFY blurRadiusChanged)
+
+public:
+    explicit Settings(QObject* parent = nullptr);
+
+    // VELOBAR_CONFIG, else velobar.yaml in the app config directory, else
+    // next to the executable; empty when none of them exists
+    static QString defaultFilePath();
+
+    // Reads path and keeps watching it. Defaults stay in effect when it is
+    // missing or invalid.
+    bool load(const QString& path);
+    QString filePath() const { return m_filePath; }
+
+    QString themeName() const { return m_themeName; }
+    QStringList resourcePaths() const { return m_resourcePaths; }
+    // theme.widgets, the bar's segments in order; the built-in layout when
+    // the theme does not set one
+    QStringList widgets() const { return m_widgets; }
+    // theme.plugins, widget name -> QML file relative to the config file
+    QVariantMap widgetPlugins() const { return m_widgetPlugins; }
+    int barHeight() const { return m_barHeight; }
+    QColor baseColor() const { return m_baseColor; }
+    QColor borderColor() const { return m_borderColor; }
+    int borderWidth() const { return m_borderWidth; }
+    bool blurEnabled() const { return m_blurEnabled; }
+    // The Windows accent blur has a fixed radius; this is for QML effects
+    int blurRadius() const { return m_blurRadius; }
+    // samplers: section, TickScheduler source name -> interval in ms
+    QHash<QString, int> samplerIntervals() const { return m_samplerIntervals; }
+
+    // Parses the config subset; error is set and an empty map returned on
+    // failure
+    static QVariantMap parse(const QByteArray& text, QString* error);
+
+signals:
+    void themeNameChanged();
+    void resourcePathsChanged();
+    void widgetsChanged();
+    void widgetPluginsChanged();
+    void barHeightChanged();
+    void baseColorChanged();
+    void borderColorChanged();
+    void borderWidthChanged();
+    void blurEnabledChanged();
+    void blurRadiusChanged();
+    void samplerIntervalsChanged();
+    // After a successful read; elapsedUs covers reading, parsing and
+    // applying, and changed counts the values that differed
+    void reloaded(qint64 elapsedUs, int changed);
+
+private slots:
+    void reload();
+
+private:
+    int apply(const QVariantMap& config);
+    void watch();
+
+private:
+    QString m_filePath;
+    QFileSystemWatcher m_watcher;
+    QTimer m_debounce; // Editors write in bursts; read once they are done
+    QByteArray m_fileContents; // As last read
+
+    QString m_themeName;
+    QStringList m_resourcePaths;
+    QStringList m_widgets;
+    QVariantMap m_widgetPlugins;
+    int m_barHeight;
+    QColor m_baseColor;
+    QColor m_borderColor;
+    int m_borderWidth;
+    bool m_blurEnabled;
+    int m_blurRadius;
+    QHash<QString, int> m_samplerIntervals;
+};
@@ -0,0 +1,219 @@
+// src/startuptrace.cpp
+#include "startuptrace.hpp"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQuickWindow>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+struct Event {
+    const char* name;
+    char phase; // 'X' complete, 'i' instant
+    qint64 startUs;
+    qint64 durationUs;
+    quint64 thread;
+};
+
+struct TraceState {
+    QString path;
+    QElapsedTimer clock;
+    qint64 baseUs = 0; // Process start to initialize()
+    QMutex mutex;
+    QVector<Event> events;
+};
+
+// Set once in initialize(), before any other thread exists
+TraceState* s_trace = nullptr;
+
+quint64 currentThread()
+{
+    return quint64(quintptr(QThread::currentThreadId()));
+}
+
+// How long the process ran before main(): loader, static initialisers and
+// compiled-in resource registration
+qint64 preMainUs()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+        return 0;
+    }
+    FILETIME now;
+    GetSystemTimePreciseAsFileTime(&now);
+    ULARGE_INTEGER start = { { creation.dwLowDateTime, creation.dwHighDateTime } };
+    ULARGE_INTEGER current = { { now.dwLowDateTime, now.dwHighDateTime } };
+    return qint64(current.QuadPart - start.QuadPart) / 10; // 100ns units
+#elif defined(Q_OS_LINUX)
+    // Field 22 of /proc/self/stat is the start time in clock ticks since boot
+    QFile stat(QStringLiteral("/proc/self/stat"));
+    QFile uptime(QStringLiteral("/proc/uptime"));
+    if (!stat.open(QIODevice::ReadOnly) || !uptime.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QByteArray line = stat.readAll();
+    // The command name may contain spaces; fields are counted after it
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 20) {
+        return 0;
+    }
+    double startSeconds = fields.at(19).toDouble() / double(sysconf(_SC_CLK_TCK));
+    double upSeconds = uptime.readAll().split(' ').value(0).toDouble();
+    return qMax<qint64>(0, qint64((upSeconds - startSeconds) * 1e6));
+#else
+    return 0;
+#endif
+}
+}
+
+StartupTrace::Scope::Scope(const char* name)
+    : m_name(name)
+    , m_startUs(StartupTrace::isEnabled() ? StartupTrace::nowUs() : 0)
+{
+}
+
+StartupTrace::Scope::~Scope()
+{
+    if (StartupTrace::isEnabled()) {
+        StartupTrace::complete(m_name, m_startUs, StartupTrace::nowUs());
+    }
+}
+
+void StartupTrace::initialize()
+{
+    const QString path = qEnvironmentVariable("VELOBAR_TRACE_STARTUP");
+    if (path.isEmpty() || s_trace) {
+        return;
+    }
+
+    s_trace = new TraceState;
+    s_trace->path = path;
+    s_trace->baseUs = preMainUs();
+    s_trace->clock.start();
+
+    complete("pre-main", 0, s_trace->baseUs);
+}
+
+bool StartupTrace::isEnabled()
+{
+    return s_trace != nullptr;
+}
+
+qint64 StartupTrace::nowUs()
+{
+    return s_trace ? s_trace->baseUs + s_trace->clock.nsecsElapsed() / 1000 : 0;
+}
+
+void StartupTrace::complete(const char* name, qint64 startUs, qint64 endUs)
+{
+    if (!s_trace) {
+        return;
+    }
+    QMutexLocker locker(&s_trace->mutex);
+    s_trace->events.append({ name, 'X', startUs, qMax<qint64>(0, endUs - startUs), currentThread() });
+}
+
+void StartupTrace::instant(const char* name)
+{
+    if (!s_trace) {
+        return;
+    }
+    qint64 now = nowUs();
+    QMutexLocker locker(&s_trace->mutex);
+    s_trace->events.append({ name, 'i', now, 0, currentThread() });
+}
+
+void StartupTrace::watchFirstFrame(QQuickWindow* window)
+{
+    if (!s_trace || !window) {
+        return;
+    }
+
+    // Sync and swap run on the render thread with the threaded render loop
+    auto syncStart = std::make_shared<std::atomic<qint64>>(0);
+    auto syncEnd = std::make_shared<std::atomic<qint64>>(0);
+    auto done = std::make_shared<std::atomic<bool>>(false);
+
+    QObject::connect(window, &QQuickWindow::beforeSynchronizing, window, [syncStart]() {
+        qint64 expected = 0;
+        syncStart->compare_exchange_strong(expected, nowUs());
+    }, Qt::DirectConnection);
+
+    QObject::connect(window, &QQuickWindow::afterSynchronizing, window, [syncStart, syncEnd]() {
+        qint64 expected = 0;
+        if (syncEnd->compare_exchange_strong(expected, nowUs())) {
+            complete("first sync", *syncStart, *syncEnd);
+        }
+    }, Qt::DirectConnection);
+
+    QObject::connect(window, &QQuickWindow::frameSwapped, window, [window, syncEnd, done]() {
+        if (done->exchange(true)) {
+            return;
+        }
+        complete("first render", *syncEnd, nowUs());
+        instant("first frame");
+        // Written from the GUI thread
+        QMetaObject::invokeMethod(window, []() { write(); }, Qt::QueuedConnection);
+    }, Qt::DirectConnection);
+}
+
+bool StartupTrace::write()
+{
+    if (!s_trace) {
+        return false;
+    }
+
+    QJsonArray events;
+    {
+        QMutexLocker locker(&s_trace->mutex);
+        for (const Event& event : s_trace->events) {
+            QJsonObject entry;
+            entry["name"] = QString::fromLatin1(event.name);
+            entry["cat"] = QStringLiteral("startup");
+            entry["ph"] = QString(QLatin1Char(event.phase));
+            entry["ts"] = double(event.startUs);
+            if (event.phase == 'X') {
+                entry["dur"] = double(event.durationUs);
+            } else {
+                entry["s"] = QStringLiteral("p");
+            }
+            entry["pid"] = double(QCoreApplication::applicationPid());
+            entry["tid"] = double(event.thread);
+            events.append(entry);
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = QStringLiteral("ms");
+
+    QSaveFile file(s_trace->path);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0
+        || !file.commit()) {
+        qDebug() << "Failed to write startup trace" << s_trace->path;
+        return false;
+    }
+
+    qDebug() << "Startup trace written to" << s_trace->path;
+    return true;
+}
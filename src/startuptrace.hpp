@@ -0,0 +1,38 @@
+// include/startuptrace.hpp
+#pragma once
+
+#include <QString>
+
+class QQuickWindow;
+
+// Startup phase timings written as a Chrome trace (chrome://tracing,
+// ui.perfetto.dev). Off unless VELOBAR_TRACE_STARTUP names the output file;
+// every call is a no-op then. Timestamps are monotonic microseconds since
+// the process started.
+class StartupTrace {
+public:
+    // Records a phase for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+
+    private:
+        const char* m_name;
+        qint64 m_startUs;
+    };
+
+    // Reads VELOBAR_TRACE_STARTUP; call first thing in main()
+    static void initialize();
+    static bool isEnabled();
+
+    static void complete(const char* name, qint64 startUs, qint64 endUs);
+    static void instant(const char* name);
+    static qint64 nowUs();
+
+    // Records the window's first scene graph sync and first swapped frame,
+    // then writes the trace
+    static void watchFirstFrame(QQuickWindow* window);
+
+    static bool write();
+};
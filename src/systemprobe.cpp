@@ -0,0 +1,156 @@
+// src/systemprobe.cpp
+#include "systemprobe.hpp"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QTimer>
+
+#ifdef Q_OS_WIN
+#include <objbase.h>
+#endif
+
+namespace {
+// Set on the probe thread when it starts, so Deadline finds its probe
+thread_local SystemProbe* t_probe = nullptr;
+}
+
+SystemProbe::Deadline::Deadline(Metrics::Histogram evaluation)
+    : m_probe(t_probe)
+    , m_evaluation(evaluation)
+    , m_sequence(m_probe ? m_probe->begin(evaluation) : 0)
+{
+}
+
+SystemProbe::Deadline::~Deadline()
+{
+    if (m_sequence) {
+        m_probe->end(m_evaluation, m_sequence);
+    }
+}
+
+SystemProbe::SystemProbe(QObject* parent)
+    : QObject(parent)
+    , m_context(new QObject)
+{
+    m_context->moveToThread(&m_thread);
+
+    connect(&m_thread, &QThread::started, m_context, [this]() {
+        t_probe = this;
+    }, Qt::DirectConnection);
+
+#ifdef Q_OS_WIN
+    // Every COM call made on the probe thread happens in this apartment
+    connect(&m_thread, &QThread::started, m_context, []() {
+        if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {
+            qDebug() << "Failed to initialize COM on the probe thread";
+        }
+    }, Qt::DirectConnection);
+
+    // finished is emitted on the probe thread itself
+    connect(&m_thread, &QThread::finished, m_context, []() {
+        CoUninitialize();
+    }, Qt::DirectConnection);
+#endif
+    connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+
+    m_thread.setObjectName("SystemProbe");
+    m_thread.start();
+}
+
+SystemProbe::~SystemProbe()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void SystemProbe::adopt(QObject* object, const QString& name, Metrics::Histogram evaluation, int budgetMs)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        Watch& watch = m_watches[evaluation];
+        watch.name = name;
+        watch.budgetMs = budgetMs;
+    }
+
+    object->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, object, &QObject::deleteLater);
+}
+
+quint64 SystemProbe::begin(Metrics::Histogram evaluation)
+{
+    quint64 sequence = 0;
+    int budgetMs = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_watches.find(evaluation);
+        if (it == m_watches.end() || it->budgetMs <= 0) {
+            return 0;
+        }
+        it->running.start();
+        sequence = ++it->sequence;
+        budgetMs = it->budgetMs;
+    }
+
+    // Armed on the GUI thread, which the evaluation cannot hold up
+    QMetaObject::invokeMethod(this, [this, evaluation, sequence, budgetMs]() {
+        QTimer::singleShot(budgetMs, this, [this, evaluation, sequence]() { expire(evaluation, sequence); });
+    }, Qt::QueuedConnection);
+    return sequence;
+}
+
+void SystemProbe::end(Metrics::Histogram evaluation, quint64 sequence)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_watches.find(evaluation);
+    if (it == m_watches.end() || it->sequence != sequence) {
+        return;
+    }
+    if (it->running.hasExpired(it->budgetMs)) {
+        ++it->overruns;
+    }
+    it->running.invalidate();
+}
+
+void SystemProbe::expire(Metrics::Histogram evaluation, quint64 sequence)
+{
+    QString name;
+    qint64 elapsedMs = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_watches.find(evaluation);
+        if (it == m_watches.end() || it->sequence != sequence || !it->running.isValid()) {
+            return;
+        }
+        ++it->stalls;
+        name = it->name;
+        elapsedMs = it->running.elapsed();
+    }
+
+    // Every other adopted object waits behind it
+    qDebug() << "Probe" << name << "still running after" << elapsedMs << "ms, the probe thread is stalled";
+}
+
+QVariantMap SystemProbe::latencyReport() const
+{
+    QHash<int, Watch> watches;
+    {
+        QMutexLocker locker(&m_mutex);
+        watches = m_watches;
+    }
+
+    // Adopted objects time themselves; read back what they recorded
+    QVariantMap report;
+    for (auto it = watches.constBegin(); it != watches.constEnd(); ++it) {
+        const Metrics::Summary summary = Metrics::summary(Metrics::Histogram(it.key()));
+        QVariantMap entry;
+        entry["runs"] = summary.count;
+        entry["maxUs"] = summary.maxUs;
+        entry["avgUs"] = summary.count ? summary.sumUs / summary.count : 0;
+        entry["p50Us"] = summary.p50Us;
+        entry["p99Us"] = summary.p99Us;
+        entry["overruns"] = it->overruns;
+        entry["stalls"] = it->stalls;
+        report.insert(it->name, entry);
+    }
+
+    return report;
+}
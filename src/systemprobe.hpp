@@ -0,0 +1,71 @@
+// include/systemprobe.hpp
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QVariant>
+#include "metrics.hpp"
+
+// Runs every system query off the GUI thread. The probe thread has its own
+// COM apartment. Objects that watch the system themselves (NetworkMonitor,
+// PowerMonitor) are moved onto it with adopt() and post only changed
+// values back.
+class SystemProbe : public QObject {
+    Q_OBJECT
+
+public:
+    // Marks one evaluation of an adopted object, made on the probe thread.
+    // Blocking system calls cannot be interrupted, so the budget is kept by
+    // a watchdog on the GUI thread: an evaluation still running when it
+    // expires is reported as stalling the probe, and one that finishes late
+    // counts as an overrun. Does nothing on other threads.
+    class Deadline {
+    public:
+        explicit Deadline(Metrics::Histogram evaluation);
+        ~Deadline();
+
+    private:
+        Q_DISABLE_COPY(Deadline)
+
+        SystemProbe* m_probe;
+        Metrics::Histogram m_evaluation;
+        quint64 m_sequence;
+    };
+
+    explicit SystemProbe(QObject* parent = nullptr);
+    ~SystemProbe();
+
+    // Moves a parentless object to the probe thread; deleted when it stops.
+    // Its evaluations, timed into the evaluation histogram, are reported
+    // under name and are each allowed budgetMs.
+    void adopt(QObject* object, const QString& name, Metrics::Histogram evaluation, int budgetMs);
+
+    // name -> { runs, maxUs, avgUs, p50Us, p99Us, overruns, stalls }, for
+    // QML or logging
+    Q_INVOKABLE QVariantMap latencyReport() const;
+
+private:
+    struct Watch {
+        QString name;
+        int budgetMs = 0;
+        quint64 sequence = 0;  // Of the last evaluation started
+        QElapsedTimer running; // Invalid between evaluations
+        quint64 overruns = 0;
+        quint64 stalls = 0;
+    };
+
+    // 0 when evaluation has no budget
+    quint64 begin(Metrics::Histogram evaluation);
+    void end(Metrics::Histogram evaluation, quint64 sequence);
+    void expire(Metrics::Histogram evaluation, quint64 sequence);
+
+private:
+    QThread m_thread;
+    QObject* m_context; // Lives on m_thread
+
+    mutable QMutex m_mutex;
+    QHash<int, Watch> m_watches; // By evaluation histogram
+};
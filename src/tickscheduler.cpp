@@ -0,0 +1,444 @@
+// src/tickscheduler.cpp
+#include "tickscheduler.hpp"
+#include <QDateTime>
+#include <QThread>
+#include <limits>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+namespace {
+// No input for this long counts as idle
+const qint64 kIdleThresholdMs = 60000;
+const int kIdleFactor = 4;
+const int kBatteryFactor = 2;
+// A source may run up to 1/8 of its interval late, capped here, so that
+// neighbouring deadlines collapse into one wakeup
+const qint64 kMaxSlackMs = 2000;
+
+qint64 now()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+}
+
+TickScheduler::TickScheduler(QObject* parent)
+    : QObject(parent)
+    , m_nextId(1)
+    , m_started(now())
+    , m_lastWake(m_started)
+    , m_lastActivity(m_started)
+    , m_wakeups(0)
+    , m_idle(false)
+    , m_onBattery(false)
+    , m_locked(false)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &TickScheduler::fire);
+}
+
+int TickScheduler::add(const QString& name, int intervalMs, QObject* context, Callback callback,
+                       Throttles throttle)
+{
+    int id = m_nextId++;
+
+    // Drop the source with its owner, whichever thread that lives on
+    QMetaObject::Connection ownerGone =
+        connect(context, &QObject::destroyed, this, [this, id]() { remove(id); });
+
+    QPointer<QObject> guard(context);
+    post([this, id, name, intervalMs, guard, callback, throttle, ownerGone]() {
+        Source& source = m_sources[id];
+        source.ownerGone = ownerGone;
+        source.name = name;
+        source.requestedMs = qMax(1, intervalMs);
+        source.intervalMs = m_overrides.value(name, source.requestedMs);
+        source.throttle = throttle;
+        source.context = guard;
+        source.callback = callback;
+        rearm();
+    });
+
+    return id;
+}
+
+void TickScheduler::remove(int id)
+{
+    post([this, id]() {
+        auto it = m_sources.find(id);
+        if (it == m_sources.end()) {
+            return;
+        }
+        // Owners that re-add on every property change would otherwise
+        // pile up destroyed connections
+        disconnect(it->ownerGone);
+        m_sources.erase(it);
+        rearm();
+    });
+}
+
+void TickScheduler::setActive(int id, bool active)
+{
+    post([this, id, active]() {
+        auto it = m_sources.find(id);
+        if (it == m_sources.end() || it->active == active) {
+            return;
+        }
+        it->active = active;
+        it->deadline = 0;
+        rearm();
+    });
+}
+
+void TickScheduler::setInterval(int id, int intervalMs)
+{
+    post([this, id, intervalMs]() {
+        auto it = m_sources.find(id);
+        if (it == m_sources.end() || it->requestedMs == intervalMs) {
+            return;
+        }
+        it->requestedMs = qMax(1, intervalMs);
+        int resolved = m_overrides.value(it->name, it->requestedMs);
+        if (it->intervalMs != resolved) {
+            it->intervalMs = resolved;
+            it->deadline = 0;
+            rearm();
+        }
+    });
+}
+
+void TickScheduler::setIntervalOverrides(const QHash<QString, int>& overrides)
+{
+    post([this, overrides]() {
+        m_overrides.clear();
+        for (auto it = overrides.constBegin(); it != overrides.constEnd(); ++it) {
+            if (it.value() > 0) {
+                m_overrides.insert(it.key(), it.value());
+            }
+        }
+
+        bool changed = false;
+        for (Source& source : m_sources) {
+            int resolved = m_overrides.value(source.name, source.requestedMs);
+            if (source.intervalMs != resolved) {
+                source.intervalMs = resolved;
+                source.deadline = 0;
+                changed = true;
+            }
+        }
+        if (changed) {
+            rearm();
+        }
+    });
+}
+
+void TickScheduler::noteActivity()
+{
+    m_lastActivity = now();
+    if (m_idle) {
+        m_idle = false;
+        realign();
+    }
+}
+
+void TickScheduler::setOnBattery(bool onBattery)
+{
+    if (m_onBattery == onBattery) {
+        return;
+    }
+    m_onBattery = onBattery;
+    if (!onBattery) {
+        realign();
+    }
+}
+
+void TickScheduler::setSessionLocked(bool locked)
+{
+    if (m_locked == locked) {
+        return;
+    }
+    m_locked = locked;
+    // Paused sources kept their old deadlines and catch up right away
+    rearm();
+}
+
+void TickScheduler::post(std::function<void()> fn)
+{
+    if (QThread::currentThread() == thread()) {
+        fn();
+    } else {
+        QMetaObject::invokeMethod(this, fn, Qt::QueuedConnection);
+    }
+}
+
+void TickScheduler::fire()
+{
+    qint64 current = now();
+    ++m_wakeups;
+
+    // The wall clock went backwards; old deadlines would stall every source
+    if (current < m_lastWake) {
+        for (Source& source : m_sources) {
+            source.deadline = 0;
+        }
+    }
+    m_lastWake = current;
+
+    if (updateIdle(current)) {
+        realign();
+    }
+
+    QVector<int> due;
+    for (auto it = m_sources.constBegin(); it != m_sources.constEnd(); ++it) {
+        const Source& source = it.value();
+        if (source.active && !isPaused(source) && source.deadline && source.deadline <= current) {
+            due.append(it.key());
+        }
+    }
+
+    // Callbacks may add or remove sources, so look each one up again
+    for (int id : due) {
+        auto it = m_sources.find(id);
+        if (it == m_sources.end()) {
+            continue;
+        }
+        if (!it->context) {
+            m_sources.erase(it);
+            continue;
+        }
+
+        ++it->runs;
+        if (due.size() > 1) {
+            ++it->coalesced;
+        }
+        it->deadline = alignedDeadline(current, effectiveInterval(*it));
+        QMetaObject::invokeMethod(it->context.data(), it->callback);
+    }
+
+    rearm();
+}
+
+void TickScheduler::rearm()
+{
+    qint64 current = now();
+    qint64 wake = 0;
+
+    for (Source& source : m_sources) {
+        if (!source.active || isPaused(source)) {
+            continue;
+        }
+
+        int interval = effectiveInterval(source);
+        if (!source.deadline) {
+            source.deadline = alignedDeadline(current, interval);
+        }
+
+        // The latest moment this source can still run covers every
+        // deadline before it
+        qint64 latest = source.deadline + slack(source, interval);
+        if (!wake || latest < wake) {
+            wake = latest;
+        }
+    }
+
+    if (!wake) {
+        m_timer.stop();
+        return;
+    }
+
+    m_timer.start(int(qBound<qint64>(0, wake - current, std::numeric_limits<int>::max())));
+}
+
+void TickScheduler::realign()
+{
+    qint64 current = now();
+    for (Source& source : m_sources) {
+        if (source.deadline) {
+            source.deadline = qMin(source.deadline,
+                                   alignedDeadline(current, effectiveInterval(source)));
+        }
+    }
+    rearm();
+}
+
+bool TickScheduler::updateIdle(qint64 current)
+{
+#ifdef Q_OS_WIN
+    // Input anywhere on the desktop, not just over the bar
+    LASTINPUTINFO info = { sizeof(LASTINPUTINFO) };
+    if (GetLastInputInfo(&info)) {
+        qint64 since = qint64(DWORD(GetTickCount() - info.dwTime));
+        m_lastActivity = qMax(m_lastActivity, current - since);
+    }
+#endif
+
+    bool idle = current - m_lastActivity > kIdleThresholdMs;
+    bool resumed = m_idle && !idle;
+    m_idle = idle;
+    return resumed;
+}
+
+int TickScheduler::effectiveInterval(const Source& source) const
+{
+    int interval = source.intervalMs;
+    if (m_idle && source.throttle.testFlag(ThrottleIdle)) {
+        interval *= kIdleFactor;
+    }
+    if (m_onBattery && source.throttle.testFlag(ThrottleBattery)) {
+        interval *= kBatteryFactor;
+    }
+    return interval;
+}
+
+bool TickScheduler::isPaused(const Source& source) const
+{
+    return m_locked && source.throttle.testFlag(PauseWhenLocked);
+}
+
+qint64 TickScheduler::alignedDeadline(qint64 now, int intervalMs)
+{
+    // Multiples of the interval on the wall clock, so 1s sources tick on the
+    // second and a 10s source always lands on a 1s tick
+    return (now / intervalMs + 1) * intervalMs;
+}
+
+qint64 TickScheduler::slack(const Source& source, int intervalMs)
+{
+    if (source.throttle.testFlag(NoSlack)) {
+        return 0;
+    }
+    return qMin<qint64>(intervalMs / 8, kMaxSlackMs);
+}
+
+QVariantMap TickScheduler::wakeupReport() const
+{
+    QVariantMap report;
+
+    qint64 elapsedMs = qMax<qint64>(1, now() - m_started);
+    QVariantMap scheduler;
+    scheduler["wakeups"] = m_wakeups;
+    scheduler["perMinute"] = double(m_wakeups) * 60000.0 / double(elapsedMs);
+    report.insert("scheduler", scheduler);
+
+    for (const Source& source : m_sources) {
+        QVariantMap entry;
+        entry["runs"] = source.runs;
+        entry["coalesced"] = source.coalesced;
+        entry["intervalMs"] = effectiveInterval(source);
+        report.insert(source.name, entry);
+    }
+
+    return report;
+}
+
+TickTimer::TickTimer(QObject* parent)
+    : QObject(parent)
+    , m_interval(1000)
+    , m_running(true)
+    , m_throttle(TickScheduler::ThrottleAll)
+    , m_triggeredOnStart(false)
+    , m_complete(false)
+    , m_id(0)
+{
+}
+
+TickTimer::~TickTimer()
+{
+    if (m_scheduler && m_id) {
+        m_scheduler->remove(m_id);
+    }
+}
+
+void TickTimer::setScheduler(TickScheduler* scheduler)
+{
+    if (m_scheduler == scheduler) {
+        return;
+    }
+    if (m_scheduler && m_id) {
+        m_scheduler->remove(m_id);
+        m_id = 0;
+    }
+    m_scheduler = scheduler;
+    emit schedulerChanged();
+    update();
+}
+
+void TickTimer::setName(const QString& name)
+{
+    if (m_name != name) {
+        m_name = name;
+        emit nameChanged();
+        update();
+    }
+}
+
+void TickTimer::setInterval(int interval)
+{
+    if (m_interval != interval) {
+        m_interval = interval;
+        emit intervalChanged();
+        update();
+    }
+}
+
+void TickTimer::setRunning(bool running)
+{
+    if (m_running != running) {
+        m_running = running;
+        emit runningChanged();
+        update();
+    }
+}
+
+void TickTimer::setThrottle(int throttle)
+{
+    if (m_throttle != throttle) {
+        m_throttle = throttle;
+        emit throttleChanged();
+        update();
+    }
+}
+
+void TickTimer::setTriggeredOnStart(bool triggeredOnStart)
+{
+    if (m_triggeredOnStart != triggeredOnStart) {
+        m_triggeredOnStart = triggeredOnStart;
+        emit triggeredOnStartChanged();
+    }
+}
+
+void TickTimer::classBegin()
+{
+}
+
+void TickTimer::componentComplete()
+{
+    m_complete = true;
+    update();
+}
+
+void TickTimer::update()
+{
+    // Property bindings settle before componentComplete
+    if (!m_complete) {
+        return;
+    }
+
+    if (m_scheduler && m_id) {
+        m_scheduler->remove(m_id);
+        m_id = 0;
+    }
+
+    if (!m_scheduler || !m_running || m_interval <= 0) {
+        return;
+    }
+
+    m_id = m_scheduler->add(m_name.isEmpty() ? QStringLiteral("qml") : m_name, m_interval, this,
+                            [this]() { emit triggered(); },
+                            TickScheduler::Throttles(QFlag(m_throttle)));
+    if (m_triggeredOnStart) {
+        emit triggered();
+    }
+}
@@ -0,0 +1,163 @@
+// include/tickscheduler.hpp
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QQmlParserStatus>
+#include <QtQml/qqmlregistration.h>
+#include <QString>
+#include <QTimer>
+#include <QVariant>
+#include <atomic>
+#include <functional>
+
+// One timer for all periodic work. Deadlines are aligned to multiples of
+// each source's interval so sources with related intervals share a wakeup,
+// and every source due within its slack runs on the same tick. Intervals
+// stretch while the user is idle or on battery, and sources can pause while
+// the session is locked. Lives on the GUI thread; add/remove/setActive and
+// setInterval may be called from any thread.
+class TickScheduler : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Use topbarController.tickScheduler")
+
+public:
+    enum Throttle {
+        ThrottleNone = 0,
+        ThrottleIdle = 1,    // 4x interval after a minute without input
+        ThrottleBattery = 2, // 2x interval while discharging
+        PauseWhenLocked = 4, // Not run while the session is locked
+        ThrottleAll = ThrottleIdle | ThrottleBattery | PauseWhenLocked,
+        NoSlack = 8          // Runs exactly on its deadline, never late
+    };
+    Q_ENUM(Throttle)
+    Q_DECLARE_FLAGS(Throttles, Throttle)
+
+    using Callback = std::function<void()>;
+
+    explicit TickScheduler(QObject* parent = nullptr);
+
+    // callback runs on context's thread; the source goes away with context.
+    // Returns an id for the calls below.
+    int add(const QString& name, int intervalMs, QObject* context, Callback callback,
+            Throttles throttle = ThrottleAll);
+    void remove(int id);
+    void setActive(int id, bool active);
+    void setInterval(int id, int intervalMs);
+    // Intervals by source name that replace what owners ask for, e.g. from
+    // the config file. Sources missing from overrides get their own back.
+    void setIntervalOverrides(const QHash<QString, int>& overrides);
+
+    // "scheduler" -> { wakeups, perMinute }, name -> { runs, coalesced,
+    // intervalMs }, for QML or logging
+    Q_INVOKABLE QVariantMap wakeupReport() const;
+
+public slots:
+    // User input seen by the bar itself, e.g. a focus change
+    void noteActivity();
+    void setOnBattery(bool onBattery);
+    void setSessionLocked(bool locked);
+
+private:
+    struct Source {
+        QString name;
+        int requestedMs = 0; // As asked by the owner
+        int intervalMs = 0;  // requestedMs or its override
+        Throttles throttle;
+        QPointer<QObject> context;
+        QMetaObject::Connection ownerGone; // context's destroyed -> remove()
+        Callback callback;
+        bool active = true;
+        qint64 deadline = 0; // Wall-clock ms; 0 until scheduled
+        quint64 runs = 0;
+        quint64 coalesced = 0; // Runs that shared a wakeup with another source
+    };
+
+    // Runs fn on the scheduler thread
+    void post(std::function<void()> fn);
+    void fire();
+    void rearm();
+    // Pulls deadlines in after a throttling condition was lifted
+    void realign();
+    bool updateIdle(qint64 now);
+
+    int effectiveInterval(const Source& source) const;
+    bool isPaused(const Source& source) const;
+    static qint64 alignedDeadline(qint64 now, int intervalMs);
+    static qint64 slack(const Source& source, int intervalMs);
+
+private:
+    QTimer m_timer;
+    QHash<int, Source> m_sources; // Scheduler thread only
+    QHash<QString, int> m_overrides; // Scheduler thread only
+    std::atomic<int> m_nextId;
+    qint64 m_started;
+    qint64 m_lastWake;
+    qint64 m_lastActivity;
+    quint64 m_wakeups;
+    bool m_idle;
+    bool m_onBattery;
+    bool m_locked;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(TickScheduler::Throttles)
+
+// QML front end for the scheduler, a drop-in for Timer:
+//   TickTimer { scheduler: tickScheduler; name: "clock"; interval: 1000
+//               onTriggered: ... }
+class TickTimer : public QObject, public QQmlParserStatus {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_INTERFACES(QQmlParserStatus)
+    Q_PROPERTY(TickScheduler* scheduler READ scheduler WRITE setScheduler NOTIFY schedulerChanged)
+    Q_PROPERTY(QString name READ name WRITE setName NOTIFY nameChanged)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+    Q_PROPERTY(bool running READ running WRITE setRunning NOTIFY runningChanged)
+    Q_PROPERTY(int throttle READ throttle WRITE setThrottle NOTIFY throttleChanged)
+    Q_PROPERTY(bool triggeredOnStart READ triggeredOnStart WRITE setTriggeredOnStart NOTIFY triggeredOnStartChanged)
+
+public:
+    explicit TickTimer(QObject* parent = nullptr);
+    ~TickTimer();
+
+    TickScheduler* scheduler() const { return m_scheduler; }
+    void setScheduler(TickScheduler* scheduler);
+    QString name() const { return m_name; }
+    void setName(const QString& name);
+    int interval() const { return m_interval; }
+    void setInterval(int interval);
+    bool running() const { return m_running; }
+    void setRunning(bool running);
+    int throttle() const { return m_throttle; }
+    void setThrottle(int throttle);
+    bool triggeredOnStart() const { return m_triggeredOnStart; }
+    void setTriggeredOnStart(bool triggeredOnStart);
+
+    void classBegin() override;
+    void componentComplete() override;
+
+signals:
+    void triggered();
+    void schedulerChanged();
+    void nameChanged();
+    void intervalChanged();
+    void runningChanged();
+    void throttleChanged();
+    void triggeredOnStartChanged();
+
+private:
+    // Re-registers with the current settings
+    void update();
+
+private:
+    QPointer<TickScheduler> m_scheduler;
+    QString m_name;
+    int m_interval;
+    bool m_running;
+    int m_throttle;
+    bool m_triggeredOnStart;
+    bool m_complete;
+    int m_id;
+};
@@ -1,187 +1,300 @@
 // src/topbarcontroller.cpp
 #include "topbarcontroller.hpp"
+#include "metrics.hpp"
 #include "windowsstructures.hpp"
 #include "windowsapi.hpp"
 #include <QDebug>
 #include <QProcess>
 #include <QCoreApplication>
+#include <QCursor>
+#include <QGuiApplication>
+#include <QFileInfo>
+#include <QQuickWindow>
+#include <QScreen>
+#include <memory>
 
 #ifdef Q_OS_WIN
 #include <dwmapi.h>
 #include <shellapi.h>
+#include <wtsapi32.h>
 #pragma comment(lib, "dwmapi.lib")
 #pragma comment(lib, "shell32.lib")
+#pragma comment(lib, "wtsapi32.lib")
 #endif
 
+namespace {
+const int kMetricsExportMs = 60000;
+// Per-evaluation budgets on the probe thread; interface and WLAN queries
+// take longer than reading a few sysfs or power status values
+const int kNetworkBudgetMs = 250;
+const int kPowerBudgetMs = 50;
+#ifdef Q_OS_WIN
+const int kPaletteHotkeyId = 1;
+#endif
+}
+
 TopbarController::TopbarController(QObject* parent)
     : QObject(parent)
     , m_menuController(new MenuController(this))
-    , m_window(nullptr)
-    , m_networkTimer(new QTimer(this))
-    , m_batteryTimer(new QTimer(this))
+    , m_scheduler(new TickScheduler(this))
+    , m_clock(new ClockProvider(m_scheduler, this))
+    , m_probe(new SystemProbe(this))
+    , m_settings(new Settings(this))
+    , m_widgets(new WidgetRegistry(this))
+    , m_networkMonitor(nullptr)
+    , m_networkRunning(false)
     , m_isEthernet(false)
     , m_wifiStrength(4)
     , m_isOnBattery(true)
     , m_batteryLevel(100)
     , m_windowVisible(true)
-#ifdef Q_OS_WIN
-    , m_wbemLocator(nullptr)
-    , m_wbemServices(nullptr)
-#endif
+    , m_frames(0)
+    , m_reloadStartNs(-1)
+    , m_reloadPendingWindows(0)
 {
     m_blurSupported = QOperatingSystemVersion::current() >= QOperatingSystemVersion::Windows10;
 
-    m_networkTimer->setInterval(2000);
-    connect(m_networkTimer, &QTimer::timeout, this, &TopbarController::checkNetworkStatus);
-
-    m_batteryTimer->setInterval(5000);
-    connect(m_batteryTimer, &QTimer::timeout, this, &TopbarController::checkBatteryStatus);
+    qRegisterMetaType<NetworkState>();
+    qRegisterMetaType<PowerState>();
+
+    // Focus changes count as user activity; outside Windows they are the
+    // scheduler's only idle signal
+    connect(m_menuController, &MenuController::menuChanged,
+            m_scheduler, &TickScheduler::noteActivity);
+
+    // Both monitors evaluate system state on the probe thread. The network
+    // one is started by updateSources() once a widget shows it; power always
+    // runs since the scheduler's battery policy depends on it.
+    m_networkMonitor = NetworkMonitor::create();
+    m_networkMonitor->setScheduler(m_scheduler);
+    connect(m_networkMonitor, &NetworkMonitor::stateChanged,
+            this, &TopbarController::onNetworkStateChanged);
+    m_probe->adopt(m_networkMonitor, QStringLiteral("network"), Metrics::NetworkEvaluate, kNetworkBudgetMs);
+
+    PowerMonitor* powerMonitor = PowerMonitor::create();
+    powerMonitor->setScheduler(m_scheduler);
+    connect(powerMonitor, &PowerMonitor::stateChanged,
+            this, &TopbarController::onPowerStateChanged);
+    m_probe->adopt(powerMonitor, QStringLiteral("power"), Metrics::PowerEvaluate, kPowerBudgetMs);
+    QMetaObject::invokeMethod(powerMonitor, [powerMonitor]() {
+        if (!powerMonitor->start()) {
+            qDebug() << "Power change notifications unavailable";
+        }
+    }, Qt::QueuedConnection);
+
+    // Edits to velobar.yaml are applied in place; QML binds to the colours
+    // and border, the rest is handled here
+    m_settings->load(Settings::defaultFilePath());
+    m_scheduler->setIntervalOverrides(m_settings->samplerIntervals());
+    connect(m_settings, &Settings::samplerIntervalsChanged, this, [this]() {
+        m_scheduler->setIntervalOverrides(m_settings->samplerIntervals());
+    });
+    connect(m_settings, &Settings::barHeightChanged, this, [this]() {
+        for (QWindow* window : std::as_const(m_windows)) {
+            setupAppbar(window);
+        }
+    });
+    connect(m_settings, &Settings::blurEnabledChanged, this, [this]() {
+        for (QWindow* window : std::as_const(m_windows)) {
+            setBlur(window, m_settings->blurEnabled());
+        }
+    });
+    connect(m_settings, &Settings::reloaded, this, &TopbarController::onSettingsReloaded);
 
-    if (initializeWMI()) {
-        m_networkTimer->start();
-        m_batteryTimer->start();
+    // Theme widgets from files next to the config
+    auto registerPlugins = [this]() {
+        m_widgets->setPlugins(m_settings->widgetPlugins(), QFileInfo(m_settings->filePath()).absolutePath());
+    };
+    registerPlugins();
+    connect(m_settings, &Settings::widgetPluginsChanged, this, registerPlugins);
+
+    connect(m_widgets, &WidgetRegistry::sourceWanted, this, &TopbarController::updateSources);
+    connect(this, &TopbarController::windowVisibilityChanged, this, &TopbarController::updateSources);
+    updateSources();
+
+    // Set VELOBAR_METRICS=<file> to have the hot-path metrics dumped there
+    const QString metricsPath = Metrics::exportPath();
+    if (!metricsPath.isEmpty()) {
+        m_scheduler->add("metrics", kMetricsExportMs, this, [metricsPath]() {
+            Metrics::write(metricsPath);
+        });
     }
 }
 
 TopbarController::~TopbarController()
 {
-    cleanupWMI();
+    // Stop the probe thread first; its monitors unregister from the scheduler
+    delete m_probe;
+    m_probe = nullptr;
+    m_networkMonitor = nullptr;
 }
 
-bool TopbarController::initializeWMI()
+void TopbarController::attachWindow(QWindow* window)
 {
-#ifdef Q_OS_WIN
-    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-    if (FAILED(hr)) {
-        qDebug() << "Failed to initialize COM";
-        return false;
+    if (!window || m_windows.contains(window)) {
+        return;
+    }
+    m_windows.append(window);
+    connect(window, &QObject::destroyed, this, [this, window]() {
+        m_windows.removeAll(window);
+        m_awaitingReload.remove(window);
+    });
+
+    setupAppbar(window);
+
+    // Keep the reservation in step with the screen's size and scaling
+    if (QScreen* screen = window->screen()) {
+        auto refresh = [this, window]() {
+            if (m_windows.contains(window)) {
+                setupAppbar(window);
+            }
+        };
+        connect(screen, &QScreen::geometryChanged, window, refresh);
+        connect(screen, &QScreen::logicalDotsPerInchChanged, window, refresh);
     }
 
-    hr = CoInitializeSecurity(
-        nullptr,
-        -1,
-        nullptr,
-        nullptr,
-        RPC_C_AUTHN_LEVEL_DEFAULT,
-        RPC_C_IMP_LEVEL_IMPERSONATE,
-        nullptr,
-        EOAC_NONE,
-        nullptr
-        );
-
-    if (FAILED(hr)) {
-        qDebug() << "Failed to initialize security";
-        CoUninitialize();
-        return false;
+    if (QQuickWindow* quickWindow = qobject_cast<QQuickWindow*>(window)) {
+        if (!m_frameClock.isValid()) {
+            m_frameClock.start();
+        }
+        // Each window renders on its own thread with the threaded loop
+        auto renderStartNs = std::make_shared<std::atomic<qint64>>(-1);
+        connect(quickWindow, &QQuickWindow::beforeRendering, this, [this, renderStartNs]() {
+            *renderStartNs = m_frameClock.nsecsElapsed();
+        }, Qt::DirectConnection);
+        // Set for each window when a config edit lands, so its first frame
+        // after the edit is the one counted
+        auto awaitingReload = std::make_shared<std::atomic<bool>>(false);
+        m_awaitingReload.insert(window, awaitingReload);
+        connect(quickWindow, &QQuickWindow::frameSwapped, this, [this, renderStartNs, awaitingReload]() {
+            ++m_frames;
+            Metrics::increment(Metrics::Frames);
+            qint64 nowNs = m_frameClock.nsecsElapsed();
+            qint64 startNs = renderStartNs->exchange(-1);
+            if (startNs >= 0) {
+                Metrics::record(Metrics::FrameRender, (nowNs - startNs) / 1000);
+            }
+
+            // The last bar to show a config edit closes its measurement
+            if (awaitingReload->exchange(false) && m_reloadPendingWindows.fetch_sub(1) == 1) {
+                qint64 reloadStartNs = m_reloadStartNs.exchange(-1);
+                if (reloadStartNs >= 0) {
+                    Metrics::record(Metrics::ConfigToFrame, (nowNs - reloadStartNs) / 1000);
+                }
+            }
+        }, Qt::DirectConnection);
     }
 
-    hr = CoCreateInstance(
-        CLSID_WbemLocator,
-        nullptr,
-        CLSCTX_INPROC_SERVER,
-        IID_IWbemLocator,
-        reinterpret_cast<void**>(&m_wbemLocator)
-        );
-
-    if (FAILED(hr)) {
-        qDebug() << "Failed to create WbemLocator";
-        CoUninitialize();
-        return false;
+#ifdef Q_OS_WIN
+    // One filter for every bar, whatever the registrations below give
+    if (m_windows.size() == 1) {
+        QCoreApplication::instance()->installNativeEventFilter(this);
     }
 
-    hr = m_wbemLocator->ConnectServer(
-        _bstr_t(L"ROOT\\CIMV2"),
-        nullptr,
-        nullptr,
-        nullptr,
-        0,
-        nullptr,
-        nullptr,
-        &m_wbemServices
-        );
-
-    if (FAILED(hr)) {
-        qDebug() << "Failed to connect to WMI";
-        m_wbemLocator->Release();
-        m_wbemLocator = nullptr;
-        CoUninitialize();
-        return false;
+    // Every bar gets the notifications; the scheduler ignores repeats
+    HWND hwnd = reinterpret_cast<HWND>(window->winId());
+    if (!WTSRegisterSessionNotification(hwnd, NOTIFY_FOR_THIS_SESSION)) {
+        qDebug() << "Failed to register for session notifications";
     }
 
-    return true;
-#else
-    return false;
+    // A thread hotkey, so it outlives any one bar; WM_HOTKEY is posted
+    // without a window and only reaches the dispatcher's filter
+    if (m_windows.size() == 1
+        && !RegisterHotKey(nullptr, kPaletteHotkeyId, MOD_CONTROL | MOD_ALT | MOD_NOREPEAT, VK_SPACE)) {
+        qDebug() << "Failed to register the command palette hotkey";
+    }
 #endif
+
+    if (m_blurSupported && m_settings->blurEnabled()) {
+        setBlur(window, true);
+    }
 }
 
-void TopbarController::cleanupWMI()
+void TopbarController::detachWindow(QWindow* window)
 {
-#ifdef Q_OS_WIN
-    if (m_wbemServices) {
-        m_wbemServices->Release();
-        m_wbemServices = nullptr;
+    if (!m_windows.removeAll(window)) {
+        return;
     }
-    if (m_wbemLocator) {
-        m_wbemLocator->Release();
-        m_wbemLocator = nullptr;
+
+    // The frame and screen connections go with the window itself
+    disconnect(window, nullptr, this, nullptr);
+    removeAppbar(window);
+
+    // A bar that goes before showing a config edit no longer holds it up
+    std::shared_ptr<std::atomic<bool>> awaitingReload = m_awaitingReload.take(window);
+    if (awaitingReload && awaitingReload->exchange(false) && m_reloadPendingWindows.fetch_sub(1) == 1) {
+        m_reloadStartNs = -1;
+    }
+
+#ifdef Q_OS_WIN
+    WTSUnRegisterSessionNotification(reinterpret_cast<HWND>(window->winId()));
+    if (m_windows.isEmpty()) {
+        UnregisterHotKey(nullptr, kPaletteHotkeyId);
+        QCoreApplication::instance()->removeNativeEventFilter(this);
     }
-    CoUninitialize();
 #endif
 }
 
-void TopbarController::initialize(QWindow* window)
+void TopbarController::cleanup()
 {
-    m_window = window;
-    setupAppbar();
-
-    if (m_blurSupported) {
-        enableBlur();
+    const QString metricsPath = Metrics::exportPath();
+    if (!metricsPath.isEmpty()) {
+        Metrics::write(metricsPath);
     }
 
-    checkNetworkStatus();
-    checkBatteryStatus();
+    const QList<QWindow*> windows = m_windows;
+    for (QWindow* window : windows) {
+        detachWindow(window);
+    }
 }
 
-void TopbarController::cleanup()
+void TopbarController::showCommandPalette()
 {
-#ifdef Q_OS_WIN
-    if (m_window) {
-        APPBARDATA abd = { sizeof(APPBARDATA) };
-        abd.hWnd = reinterpret_cast<HWND>(m_window->winId());
-        SHAppBarMessage(ABM_REMOVE, &abd);
+    if (m_windows.isEmpty()) {
+        return;
     }
-#endif
+
+    QWindow* target = m_windows.first();
+    QScreen* screen = QGuiApplication::screenAt(QCursor::pos());
+    for (QWindow* window : std::as_const(m_windows)) {
+        if (window->screen() == screen) {
+            target = window;
+            break;
+        }
+    }
+    emit commandPaletteRequested(target);
 }
 
-void TopbarController::setupAppbar()
+void TopbarController::setupAppbar(QWindow* window)
 {
-#ifdef Q_OS_WIN
-    if (!m_window) {
+    QScreen* screen = window->screen();
+    if (!screen) {
         return;
     }
 
+    // Off Windows there is nothing to reserve; just sit on top of the screen
+    const QRect screenGeometry = screen->geometry();
+    const int height = m_settings->barHeight();
+    QRect bar(screenGeometry.topLeft(), QSize(screenGeometry.width(), height));
+
+#ifdef Q_OS_WIN
     if (m_blurSupported) {
-        m_window->setProperty("_q_stylebackground", true);
+        window->setProperty("_q_stylebackground", true);
     }
 
-    HWND hwnd = reinterpret_cast<HWND>(m_window->winId());
+    HWND hwnd = reinterpret_cast<HWND>(window->winId());
     MONITORINFO monitorInfo = { sizeof(MONITORINFO) };
-    HMONITOR monitor = MonitorFromWindow(hwnd, MONITOR_DEFAULTTOPRIMARY);
+    HMONITOR monitor = MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST);
 
     if (!GetMonitorInfo(monitor, &monitorInfo)) {
         qDebug() << "Failed to get monitor info";
         return;
     }
 
+    // Appbar rectangles are in physical pixels of this monitor
+    const qreal scale = screen->devicePixelRatio();
     const RECT& workArea = monitorInfo.rcWork;
-    int width = workArea.right - workArea.left;
-
-    m_window->setX(workArea.left);
-    m_window->setY(workArea.top);
-    m_window->setWidth(width);
-    m_window->setHeight(m_topbarHeight);
-
-    emit windowPosChanged(workArea.left, workArea.top, width, m_topbarHeight);
+    const RECT& monitorArea = monitorInfo.rcMonitor;
 
     APPBARDATA abd = { sizeof(APPBARDATA) };
     abd.hWnd = hwnd;
@@ -193,22 +306,42 @@ void TopbarController::setupAppbar()
         workArea.bottom
     };
 
+    // ABM_NEW fails harmlessly for a window that is already registered
     SHAppBarMessage(ABM_NEW, &abd);
     SHAppBarMessage(ABM_QUERYPOS, &abd);
 
-    abd.rc.bottom = abd.rc.top + m_topbarHeight;
+    abd.rc.bottom = abd.rc.top + qRound(height * scale);
     SHAppBarMessage(ABM_SETPOS, &abd);
+
+    bar = QRect(screenGeometry.left() + qRound((abd.rc.left - monitorArea.left) / scale),
+                screenGeometry.top() + qRound((abd.rc.top - monitorArea.top) / scale),
+                qRound((abd.rc.right - abd.rc.left) / scale),
+                height);
 #endif
+
+    window->setGeometry(bar);
+    emit windowPosChanged(window, bar.x(), bar.y(), bar.width(), bar.height());
 }
 
-void TopbarController::enableBlur()
+void TopbarController::removeAppbar(QWindow* window)
 {
 #ifdef Q_OS_WIN
-    if (!m_window || !m_blurSupported) {
+    APPBARDATA abd = { sizeof(APPBARDATA) };
+    abd.hWnd = reinterpret_cast<HWND>(window->winId());
+    SHAppBarMessage(ABM_REMOVE, &abd);
+#else
+    Q_UNUSED(window);
+#endif
+}
+
+void TopbarController::setBlur(QWindow* window, bool enabled)
+{
+#ifdef Q_OS_WIN
+    if (!m_blurSupported) {
         return;
     }
 
-    HWND hwnd = reinterpret_cast<HWND>(m_window->winId());
+    HWND hwnd = reinterpret_cast<HWND>(window->winId());
 
     HMODULE hUser32 = GetModuleHandle(L"user32.dll");
     if (hUser32) {
@@ -217,7 +350,9 @@ void TopbarController::enableBlur()
             );
 
         if (setWindowCompositionAttribute) {
-            ACCENTPOLICY accent = { CustomAccent::ACCENT_ENABLE_BLURBEHIND, 0, 0, 0 };
+            ACCENTPOLICY accent = {
+                enabled ? CustomAccent::ACCENT_ENABLE_BLURBEHIND : CustomAccent::ACCENT_DISABLED, 0, 0, 0
+            };
             WINCOMPATTRDATA data = {
                 CustomAccent::WCA_ACCENT_POLICY,
                 &accent,
@@ -227,134 +362,111 @@ void TopbarController::enableBlur()
             setWindowCompositionAttribute(hwnd, &data);
         }
     }
+#else
+    Q_UNUSED(window);
+    Q_UNUSED(enabled);
 #endif
 }
 
-void TopbarController::checkNetworkStatus()
+QVariantMap TopbarController::frameReport() const
+{
+    QVariantMap report;
+    quint64 frames = m_frames;
+    qint64 elapsedMs = m_frameClock.isValid() ? qMax<qint64>(1, m_frameClock.elapsed()) : 1;
+    report["frames"] = frames;
+    report["perMinute"] = double(frames) * 60000.0 / double(elapsedMs);
+    return report;
+}
+
+bool TopbarController::nativeEventFilter(const QByteArray& eventType, void* message, qintptr* result)
 {
+    Q_UNUSED(result);
 #ifdef Q_OS_WIN
-    try {
-        if (!m_wbemServices) {
-            return;
+    MSG* msg = static_cast<MSG*>(message);
+
+    // Thread messages come only through the dispatcher; window messages
+    // come through both, so each is handled on one path
+    if (eventType == "windows_dispatcher_MSG") {
+        if (msg->message == WM_HOTKEY && !msg->hwnd && msg->wParam == WPARAM(kPaletteHotkeyId)) {
+            showCommandPalette();
+            return true;
         }
+        return false;
+    }
+    if (eventType != "windows_generic_MSG") {
+        return false;
+    }
 
-        bool ethernetConnected = false;
-        bool wifiConnected = false;
-        int wifiStrength = 0;
-
-        // Check ethernet connections first
-        IEnumWbemClassObject* pEnumerator = nullptr;
-        HRESULT hr = m_wbemServices->ExecQuery(
-            bstr_t("WQL"),
-            bstr_t("SELECT * FROM Win32_NetworkAdapter WHERE NetConnectionStatus = 2 AND PhysicalAdapter = TRUE AND AdapterType = 'Ethernet 802.3'"),
-            WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY,
-            nullptr,
-            &pEnumerator
-        );
-
-        if (SUCCEEDED(hr) && pEnumerator) {
-            IWbemClassObject* pclsObj = nullptr;
-            ULONG uReturn = 0;
-
-            hr = pEnumerator->Next(WBEM_INFINITE, 1, &pclsObj, &uReturn);
-            if (SUCCEEDED(hr) && uReturn > 0) {
-                ethernetConnected = true;
-                pclsObj->Release();
-            }
-            pEnumerator->Release();
+    if (msg->message == WM_WTSSESSION_CHANGE) {
+        if (msg->wParam == WTS_SESSION_LOCK) {
+            m_scheduler->setSessionLocked(true);
+        } else if (msg->wParam == WTS_SESSION_UNLOCK) {
+            m_scheduler->setSessionLocked(false);
         }
+    }
+#else
+    Q_UNUSED(eventType);
+    Q_UNUSED(message);
+#endif
+    return false;
+}
 
-        // Check WiFi if no ethernet
-        if (!ethernetConnected) {
-            pEnumerator = nullptr;
-            hr = m_wbemServices->ExecQuery(
-                bstr_t("WQL"),
-                bstr_t("SELECT * FROM Win32_NetworkAdapter WHERE NetConnectionStatus = 2 AND PhysicalAdapter = TRUE AND NetConnectionID LIKE '%Wi%Fi%'"),
-                WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY,
-                nullptr,
-                &pEnumerator
-            );
+void TopbarController::onNetworkStateChanged(const NetworkState& state)
+{
+    if (m_isEthernet != state.ethernet || m_wifiStrength != state.wifiStrength) {
+        m_isEthernet = state.ethernet;
+        m_wifiStrength = state.wifiStrength;
+        emit networkChanged();
+    }
+}
 
-            if (SUCCEEDED(hr) && pEnumerator) {
-                IWbemClassObject* pclsObj = nullptr;
-                ULONG uReturn = 0;
-
-                if (SUCCEEDED(pEnumerator->Next(WBEM_INFINITE, 1, &pclsObj, &uReturn)) && uReturn > 0) {
-                    wifiConnected = true;
-                    
-                    // Get signal strength using GetObject
-                    VARIANT vtProp;
-                    if (SUCCEEDED(pclsObj->Get(L"Name", 0, &vtProp, 0, 0))) {
-                        IWbemClassObject* pSignalObj = nullptr;
-                        std::wstring query = L"SELECT * FROM MSNdis_80211_ReceivedSignalStrength WHERE InstanceName = '";
-                        query += vtProp.bstrVal;
-                        query += L"'";
-                        VariantClear(&vtProp);
-
-                        IEnumWbemClassObject* pSignalEnum = nullptr;
-                        hr = m_wbemServices->ExecQuery(
-                            bstr_t("WQL"),
-                            bstr_t(query.c_str()),
-                            WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY,
-                            nullptr,
-                            &pSignalEnum
-                        );
-
-                        if (SUCCEEDED(hr) && pSignalEnum) {
-                            ULONG sigReturn = 0;
-                            if (SUCCEEDED(pSignalEnum->Next(WBEM_INFINITE, 1, &pSignalObj, &sigReturn)) && sigReturn > 0) {
-                                VARIANT vtSignal;
-                                if (SUCCEEDED(pSignalObj->Get(L"Ndis80211ReceivedSignalStrength", 0, &vtSignal, 0, 0))) {
-                                    int signal = abs(vtSignal.intVal);
-                                    if (signal <= 50) wifiStrength = 4;
-                                    else if (signal <= 60) wifiStrength = 3;
-                                    else if (signal <= 70) wifiStrength = 2;
-                                    else wifiStrength = 1;
-                                    VariantClear(&vtSignal);
-                                }
-                                pSignalObj->Release();
-                            }
-                            pSignalEnum->Release();
-                        }
-                    }
-                    pclsObj->Release();
-                }
-                pEnumerator->Release();
-            }
-        }
+void TopbarController::onSettingsReloaded(qint64 elapsedUs, int changed)
+{
+    // Nothing to show, or the first read before any bar exists
+    if (changed == 0 || m_awaitingReload.isEmpty() || !m_frameClock.isValid()) {
+        return;
+    }
 
-        if (m_isEthernet != ethernetConnected || m_wifiStrength != (wifiConnected ? wifiStrength : 0)) {
-            m_isEthernet = ethernetConnected;
-            m_wifiStrength = wifiConnected ? wifiStrength : 0;
-            emit networkChanged();
+    // Timed from when the file was read. Every bar is asked for a frame so
+    // edits that change nothing visible still close the measurement.
+    m_reloadStartNs = m_frameClock.nsecsElapsed() - elapsedUs * 1000;
+    m_reloadPendingWindows = int(m_awaitingReload.size());
+    for (auto it = m_awaitingReload.constBegin(); it != m_awaitingReload.constEnd(); ++it) {
+        it.value()->store(true);
+        if (QQuickWindow* quickWindow = qobject_cast<QQuickWindow*>(it.key())) {
+            quickWindow->update();
         }
     }
-    catch (const _com_error& e) {
-        qDebug() << "WMI error:" << QString::fromWCharArray(e.ErrorMessage());
-    }
-#endif
 }
 
-void TopbarController::checkBatteryStatus()
+void TopbarController::updateSources()
 {
-#ifdef Q_OS_WIN
-    try {
-        SYSTEM_POWER_STATUS powerStatus;
-        if (GetSystemPowerStatus(&powerStatus)) {
-            bool newIsOnBattery = (powerStatus.ACLineStatus == 0);
-            int newBatteryLevel = (powerStatus.BatteryLifePercent == 255) ? 100 : powerStatus.BatteryLifePercent;
-
-            if (m_isOnBattery != newIsOnBattery || m_batteryLevel != newBatteryLevel) {
-                m_isOnBattery = newIsOnBattery;
-                m_batteryLevel = newBatteryLevel;
-                emit batteryChanged();
-            }
-        }
+    m_clock->setActive(m_windowVisible && m_widgets->isWanted("clock"));
+
+    bool network = m_windowVisible && m_widgets->isWanted("network");
+    if (network == m_networkRunning || !m_networkMonitor) {
+        return;
     }
-    catch (const std::exception& e) {
-        qDebug() << "Error checking battery status:" << e.what();
+    m_networkRunning = network;
+
+    NetworkMonitor* monitor = m_networkMonitor;
+    QMetaObject::invokeMethod(monitor, [monitor, network]() {
+        if (!network) {
+            monitor->stop();
+        } else if (!monitor->start()) {
+            qDebug() << "Network change notifications unavailable";
+        }
+    }, Qt::QueuedConnection);
+}
+
+void TopbarController::onPowerStateChanged(const PowerState& state)
+{
+    if (m_isOnBattery != state.onBattery || m_batteryLevel != state.level) {
+        m_isOnBattery = state.onBattery;
+        m_batteryLevel = state.level;
+        emit batteryChanged();
     }
-#endif
+    m_scheduler->setOnBattery(state.onBattery);
 }
 
 void TopbarController::openSettings()
@@ -1,21 +1,30 @@
 // include/topbarcontroller.hpp
 #pragma once
 
+#include <QAbstractNativeEventFilter>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QWindow>
-#include <QTimer>
 #include <QOperatingSystemVersion>
+#include "clockprovider.hpp"
 #include "menucontroller.hpp"
+#include "networkmonitor.hpp"
+#include "powermonitor.hpp"
+#include "settings.hpp"
+#include "systemprobe.hpp"
+#include "tickscheduler.hpp"
+#include "widgetregistry.hpp"
+#include <atomic>
+#include <memory>
 
-#ifdef Q_OS_WIN
-#include <wbemidl.h>
-#include <comdef.h>
-#pragma comment(lib, "wbemuuid.lib")
-#endif
-
-class TopbarController : public QObject {
+class TopbarController : public QObject, public QAbstractNativeEventFilter {
     Q_OBJECT
     Q_PROPERTY(MenuController* menuController READ menuController CONSTANT)
+    Q_PROPERTY(TickScheduler* tickScheduler READ tickScheduler CONSTANT)
+    Q_PROPERTY(ClockProvider* clock READ clock CONSTANT)
+    Q_PROPERTY(SystemProbe* systemProbe READ systemProbe CONSTANT)
+    Q_PROPERTY(Settings* settings READ settings CONSTANT)
+    Q_PROPERTY(WidgetRegistry* widgets READ widgets CONSTANT)
     Q_PROPERTY(bool isEthernet READ isEthernet NOTIFY networkChanged)
     Q_PROPERTY(int wifiStrength READ wifiStrength NOTIFY networkChanged)
     Q_PROPERTY(bool isOnBattery READ isOnBattery NOTIFY batteryChanged)
@@ -28,6 +37,11 @@ public:
     ~TopbarController();
 
     MenuController* menuController() const { return m_menuController; }
+    TickScheduler* tickScheduler() const { return m_scheduler; }
+    ClockProvider* clock() const { return m_clock; }
+    SystemProbe* systemProbe() const { return m_probe; }
+    Settings* settings() const { return m_settings; }
+    WidgetRegistry* widgets() const { return m_widgets; }
     bool isEthernet() const { return m_isEthernet; }
     int wifiStrength() const { return m_wifiStrength; }
     bool isOnBattery() const { return m_isOnBattery; }
@@ -36,38 +50,55 @@ public:
     bool windowVisible() const { return m_windowVisible; }
     void setWindowVisible(bool visible);
 
+    // { frames, perMinute } swapped by all bar windows since the first attached
+    Q_INVOKABLE QVariantMap frameReport() const;
+
+    // Session lock/unlock notifications for the scheduler
+    bool nativeEventFilter(const QByteArray& eventType, void* message, qintptr* result) override;
+
 public slots:
-    void initialize(QWindow* window);
+    // Reserves screen space for a bar window and hooks it up; one call per
+    // screen's bar. All windows share this controller's data.
+    void attachWindow(QWindow* window);
+    void detachWindow(QWindow* window);
+    // Detaches every window
     void cleanup();
+    // Opens the command palette on the bar of the screen under the cursor.
+    // Ctrl+Alt+Space does the same from anywhere on Windows.
+    void showCommandPalette();
     void openSettings();
     void openTaskManager();
     void exitApp();
 
 signals:
-    void windowPosChanged(int x, int y, int width, int height);
+    void windowPosChanged(QWindow* window, int x, int y, int width, int height);
+    void commandPaletteRequested(QWindow* window);
     void networkChanged();
     void batteryChanged();
     void windowVisibilityChanged();
 
 private slots:
-    void checkNetworkStatus();
-    void checkBatteryStatus();
+    void onNetworkStateChanged(const NetworkState& state);
+    void onPowerStateChanged(const PowerState& state);
+    void onSettingsReloaded(qint64 elapsedUs, int changed);
+    // Runs the clock and network sampling only while a shown widget reads them
+    void updateSources();
 
 private:
-    void setupAppbar();
-    void enableBlur();
-    bool initializeWMI();
-    void cleanupWMI();
-    bool checkEthernetStatus();
-    bool checkWiFiStatus(int& strength);
-    bool getBatteryInfo(bool& onBattery, int& level);
+    void setupAppbar(QWindow* window);
+    void removeAppbar(QWindow* window);
+    void setBlur(QWindow* window, bool enabled);
 
 private:
     MenuController* m_menuController;
-    QWindow* m_window;
-    QTimer* m_networkTimer;
-    QTimer* m_batteryTimer;
-    const int m_topbarHeight = 30;
+    QList<QWindow*> m_windows; // Attached bars, one per screen
+    TickScheduler* m_scheduler;
+    ClockProvider* m_clock;
+    SystemProbe* m_probe;
+    Settings* m_settings;
+    WidgetRegistry* m_widgets;
+    NetworkMonitor* m_networkMonitor; // Lives on the probe thread
+    bool m_networkRunning;
 
     bool m_isEthernet;
     int m_wifiStrength;
@@ -76,8 +107,11 @@ private:
     bool m_blurSupported;
     bool m_windowVisible = true;
 
-#ifdef Q_OS_WIN
-    IWbemLocator* m_wbemLocator;
-    IWbemServices* m_wbemServices;
-#endif
+    std::atomic<quint64> m_frames; // Bumped on the render threads, all windows
+    QElapsedTimer m_frameClock;
+
+    // Config edit waiting for every bar to show it; -1 when none is
+    std::atomic<qint64> m_reloadStartNs;
+    std::atomic<int> m_reloadPendingWindows;
+    QHash<QWindow*, std::shared_ptr<std::atomic<bool>>> m_awaitingReload;
 };
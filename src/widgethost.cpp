@@ -0,0 +1,277 @@
+// src/widgethost.cpp
+#include "widgethost.hpp"
+#include "widgetregistry.hpp"
+#include <QDebug>
+#include <QQmlContext>
+#include <QQmlEngine>
+
+WidgetHost::Incubator::Incubator(WidgetHost* host, Slot* slot)
+    : QQmlIncubator(QQmlIncubator::Asynchronous)
+    , m_host(host)
+    , m_slot(slot)
+{
+}
+
+void WidgetHost::Incubator::setInitialState(QObject* object)
+{
+    // Parented before bindings are evaluated so Layout attached properties
+    // and sizes resolve against the bar
+    if (QQuickItem* item = qobject_cast<QQuickItem*>(object)) {
+        item->setParentItem(m_host->m_container);
+        item->setParent(m_host->m_container);
+    }
+}
+
+void WidgetHost::Incubator::statusChanged(Status status)
+{
+    m_host->onIncubated(m_slot, status);
+}
+
+WidgetHost::WidgetHost(QObject* parent)
+    : QObject(parent)
+    , m_complete(false)
+{
+}
+
+WidgetHost::~WidgetHost()
+{
+    for (Slot* slot : std::as_const(m_slots)) {
+        destroySlot(slot);
+    }
+    m_slots.clear();
+}
+
+void WidgetHost::setContainer(QQuickItem* container)
+{
+    if (m_container == container) {
+        return;
+    }
+    // Instances belong to the old container; start over in the new one
+    for (Slot* slot : std::as_const(m_slots)) {
+        destroySlot(slot);
+    }
+    m_slots.clear();
+    m_container = container;
+    emit containerChanged();
+    rebuild();
+}
+
+void WidgetHost::setRegistry(WidgetRegistry* registry)
+{
+    if (m_registry == registry) {
+        return;
+    }
+    if (m_registry) {
+        disconnect(m_registry, nullptr, this, nullptr);
+    }
+    m_registry = registry;
+    if (m_registry) {
+        connect(m_registry, &WidgetRegistry::widgetsChanged, this, &WidgetHost::rebuild);
+    }
+    emit registryChanged();
+    rebuild();
+}
+
+void WidgetHost::setWidgets(const QStringList& names)
+{
+    if (m_names == names) {
+        return;
+    }
+    m_names = names;
+    emit widgetsChanged();
+    rebuild();
+}
+
+int WidgetHost::pending() const
+{
+    int count = 0;
+    for (const Slot* slot : m_slots) {
+        if (slot->incubator && slot->incubator->isLoading()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void WidgetHost::componentComplete()
+{
+    m_complete = true;
+    rebuild();
+}
+
+void WidgetHost::rebuild()
+{
+    if (!m_complete || !m_container || !m_registry || !qmlEngine(this)) {
+        return;
+    }
+
+    // Reuse instances by name and source, in order of appearance
+    QList<Slot*> previous = m_slots;
+    QList<Slot*> next;
+    for (const QString& name : std::as_const(m_names)) {
+        if (!m_registry->contains(name)) {
+            qDebug() << "Unknown widget" << name;
+            continue;
+        }
+        const WidgetRegistry::Widget widget = m_registry->widget(name);
+
+        Slot* reused = nullptr;
+        for (int i = 0; i < previous.size(); ++i) {
+            if (previous.at(i)->name == name && previous.at(i)->source == widget.source) {
+                reused = previous.takeAt(i);
+                break;
+            }
+        }
+        if (reused) {
+            next.append(reused);
+            continue;
+        }
+
+        Slot* slot = new Slot;
+        slot->name = name;
+        slot->source = widget.source;
+        slot->sources = widget.sources;
+        next.append(slot);
+    }
+
+    for (Slot* slot : std::as_const(previous)) {
+        destroySlot(slot);
+    }
+    m_slots = next;
+
+    for (Slot* slot : std::as_const(m_slots)) {
+        if (!slot->incubator && !slot->item) {
+            incubate(slot);
+        }
+    }
+    restack();
+    emit pendingChanged();
+}
+
+QQmlComponent* WidgetHost::component(const QUrl& source)
+{
+    QQmlComponent* component = m_components.value(source);
+    if (!component) {
+        // Built-ins are compiled in; theme files load off the GUI thread
+        component = new QQmlComponent(qmlEngine(this), source, QQmlComponent::Asynchronous, this);
+        m_components.insert(source, component);
+        connect(component, &QQmlComponent::statusChanged, this, [this, component]() {
+            onComponentStatus(component);
+        });
+    }
+    return component;
+}
+
+void WidgetHost::incubate(Slot* slot)
+{
+    if (!slot->requested.isValid()) {
+        slot->requested.start();
+    }
+
+    QQmlComponent* component = this->component(slot->source);
+    if (component->isLoading()) {
+        return; // Picked up by onComponentStatus()
+    }
+    if (component->isError()) {
+        qDebug() << "Widget" << slot->name << "failed to load:" << component->errorString();
+        return;
+    }
+
+    slot->incubator = new Incubator(this, slot);
+    component->create(*slot->incubator, qmlContext(this));
+}
+
+void WidgetHost::onComponentStatus(QQmlComponent* component)
+{
+    if (component->isLoading()) {
+        return;
+    }
+    for (Slot* slot : std::as_const(m_slots)) {
+        if (!slot->incubator && !slot->item && m_components.value(slot->source) == component) {
+            incubate(slot);
+        }
+    }
+    emit pendingChanged();
+}
+
+void WidgetHost::onIncubated(Slot* slot, QQmlIncubator::Status status)
+{
+    if (status == QQmlIncubator::Error) {
+        qDebug() << "Widget" << slot->name << "failed:" << slot->incubator->errors();
+        emit pendingChanged();
+        return;
+    }
+    if (status != QQmlIncubator::Ready) {
+        return;
+    }
+
+    QQuickItem* item = qobject_cast<QQuickItem*>(slot->incubator->object());
+    if (!item) {
+        qDebug() << "Widget" << slot->name << "is not an Item";
+        delete slot->incubator->object();
+        emit pendingChanged();
+        return;
+    }
+    QQmlEngine::setObjectOwnership(item, QQmlEngine::CppOwnership);
+    slot->item = item;
+
+    if (m_registry) {
+        m_registry->recordCreation(slot->name, slot->requested.nsecsElapsed() / 1000);
+    }
+
+    connect(item, &QQuickItem::visibleChanged, this, [this, slot]() {
+        updateDemand(slot);
+    });
+    updateDemand(slot);
+    restack();
+    emit pendingChanged();
+}
+
+void WidgetHost::updateDemand(Slot* slot)
+{
+    bool wanted = slot->item && slot->item->isVisible();
+    if (wanted == slot->holdsSources || !m_registry) {
+        return;
+    }
+    slot->holdsSources = wanted;
+    if (wanted) {
+        m_registry->acquire(slot->sources);
+    } else {
+        m_registry->release(slot->sources);
+    }
+}
+
+void WidgetHost::destroySlot(Slot* slot)
+{
+    if (slot->holdsSources && m_registry) {
+        m_registry->release(slot->sources);
+    }
+    slot->holdsSources = false;
+
+    if (slot->item) {
+        disconnect(slot->item, nullptr, this, nullptr);
+        slot->item->setParentItem(nullptr);
+        slot->item->deleteLater();
+    }
+    if (slot->incubator) {
+        // Drops an instance still being built
+        slot->incubator->clear();
+        delete slot->incubator;
+    }
+    delete slot;
+}
+
+void WidgetHost::restack()
+{
+    // Layouts place children in stacking order
+    QQuickItem* previous = nullptr;
+    for (const Slot* slot : std::as_const(m_slots)) {
+        if (!slot->item) {
+            continue;
+        }
+        if (previous) {
+            slot->item->stackAfter(previous);
+        }
+        previous = slot->item;
+    }
+}
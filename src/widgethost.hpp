@@ -0,0 +1,99 @@
+// include/widgethost.hpp
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QQmlComponent>
+#include <QQmlIncubator>
+#include <QQmlParserStatus>
+#include <QQuickItem>
+#include <QStringList>
+#include <QtQml/qqmlregistration.h>
+
+class WidgetRegistry;
+
+// Fills a layout item with the named widgets, in order. Instances are
+// incubated asynchronously between frames, so the bar shows its first frame
+// without waiting for any of them; each is placed in its slot as it
+// completes. Changing the list keeps instances whose name and source stayed
+// and only creates or destroys the difference.
+//
+//   RowLayout { id: row }
+//   WidgetHost { container: row; registry: topbarController.widgets
+//                widgets: topbarController.settings.widgets }
+class WidgetHost : public QObject, public QQmlParserStatus {
+    Q_OBJECT
+    Q_INTERFACES(QQmlParserStatus)
+    QML_ELEMENT
+    Q_PROPERTY(QQuickItem* container READ container WRITE setContainer NOTIFY containerChanged)
+    Q_PROPERTY(WidgetRegistry* registry READ registry WRITE setRegistry NOTIFY registryChanged)
+    Q_PROPERTY(QStringList widgets READ widgets WRITE setWidgets NOTIFY widgetsChanged)
+    Q_PROPERTY(int pending READ pending NOTIFY pendingChanged)
+
+public:
+    explicit WidgetHost(QObject* parent = nullptr);
+    ~WidgetHost();
+
+    QQuickItem* container() const { return m_container; }
+    void setContainer(QQuickItem* container);
+    WidgetRegistry* registry() const { return m_registry; }
+    void setRegistry(WidgetRegistry* registry);
+    QStringList widgets() const { return m_names; }
+    void setWidgets(const QStringList& names);
+    // Widgets still being created
+    int pending() const;
+
+    void classBegin() override {}
+    void componentComplete() override;
+
+signals:
+    void containerChanged();
+    void registryChanged();
+    void widgetsChanged();
+    void pendingChanged();
+
+private:
+    struct Slot;
+
+    class Incubator : public QQmlIncubator {
+    public:
+        Incubator(WidgetHost* host, Slot* slot);
+
+    protected:
+        void setInitialState(QObject* object) override;
+        void statusChanged(Status status) override;
+
+    private:
+        WidgetHost* m_host;
+        Slot* m_slot;
+    };
+
+    struct Slot {
+        QString name;
+        QUrl source;
+        QStringList sources;
+        Incubator* incubator = nullptr;
+        QPointer<QQuickItem> item;
+        bool holdsSources = false;
+        QElapsedTimer requested;
+    };
+
+    void rebuild();
+    QQmlComponent* component(const QUrl& source);
+    void incubate(Slot* slot);
+    void onIncubated(Slot* slot, QQmlIncubator::Status status);
+    void onComponentStatus(QQmlComponent* component);
+    void updateDemand(Slot* slot);
+    void destroySlot(Slot* slot);
+    void restack();
+
+private:
+    QPointer<QQuickItem> m_container;
+    QPointer<WidgetRegistry> m_registry;
+    QStringList m_names;
+    QList<Slot*> m_slots; // In layout order
+    QHash<QUrl, QQmlComponent*> m_components;
+    bool m_complete;
+};
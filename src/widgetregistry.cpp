@@ -0,0 +1,106 @@
+// src/widgetregistry.cpp
+#include "widgetregistry.hpp"
+#include "metrics.hpp"
+#include <QDebug>
+#include <QDir>
+
+namespace {
+const char kBuiltinPrefix[] = "qrc:/qt/qml/Velobar/widgets/";
+}
+
+WidgetRegistry::WidgetRegistry(QObject* parent)
+    : QObject(parent)
+{
+    // Power is not listed: the monitor runs regardless for the scheduler's
+    // battery policy
+    const QString prefix = QString::fromLatin1(kBuiltinPrefix);
+    registerWidget("logo", QUrl(prefix + "Logo.qml"));
+    registerWidget("app-name", QUrl(prefix + "AppName.qml"));
+    registerWidget("menu", QUrl(prefix + "AppMenu.qml"));
+    registerWidget("separator", QUrl(prefix + "Separator.qml"));
+    registerWidget("battery", QUrl(prefix + "Battery.qml"));
+    registerWidget("network", QUrl(prefix + "Network.qml"), { "network" });
+    registerWidget("date", QUrl(prefix + "DateLabel.qml"), { "clock" });
+    registerWidget("clock", QUrl(prefix + "Clock.qml"), { "clock" });
+}
+
+QStringList WidgetRegistry::defaultLayout()
+{
+    return { "logo", "app-name", "separator", "menu",
+             "battery", "network", "separator", "date", "separator", "clock" };
+}
+
+void WidgetRegistry::registerWidget(const QString& name, const QUrl& source, const QStringList& sources)
+{
+    m_widgets.insert(name, { source, sources });
+    emit widgetsChanged();
+}
+
+void WidgetRegistry::setPlugins(const QVariantMap& plugins, const QString& baseDirectory)
+{
+    for (const QString& name : std::as_const(m_pluginNames)) {
+        m_widgets.remove(name);
+    }
+    m_pluginNames.clear();
+
+    const QDir base(baseDirectory);
+    for (auto it = plugins.constBegin(); it != plugins.constEnd(); ++it) {
+        if (m_widgets.contains(it.key())) {
+            qDebug() << "Widget plugin" << it.key() << "shadows a built-in widget; ignored";
+            continue;
+        }
+        const QString path = it.value().toString();
+        QUrl source = path.startsWith("qrc:") ? QUrl(path) : QUrl::fromLocalFile(base.absoluteFilePath(path));
+        m_widgets.insert(it.key(), { source, QStringList() });
+        m_pluginNames.append(it.key());
+    }
+    emit widgetsChanged();
+}
+
+void WidgetRegistry::acquire(const QStringList& sources)
+{
+    for (const QString& source : sources) {
+        if (++m_demand[source] == 1) {
+            emit sourceWanted(source, true);
+        }
+    }
+}
+
+void WidgetRegistry::release(const QStringList& sources)
+{
+    for (const QString& source : sources) {
+        auto it = m_demand.find(source);
+        if (it == m_demand.end()) {
+            continue;
+        }
+        if (--*it == 0) {
+            m_demand.erase(it);
+            emit sourceWanted(source, false);
+        }
+    }
+}
+
+void WidgetRegistry::recordCreation(const QString& name, qint64 elapsedUs)
+{
+    CreationStats& stats = m_creation[name];
+    ++stats.count;
+    stats.lastUs = elapsedUs;
+    stats.maxUs = qMax(stats.maxUs, elapsedUs);
+    stats.totalUs += elapsedUs;
+    Metrics::record(Metrics::WidgetCreate, elapsedUs);
+}
+
+QVariantMap WidgetRegistry::creationReport() const
+{
+    QVariantMap report;
+    for (auto it = m_creation.constBegin(); it != m_creation.constEnd(); ++it) {
+        const CreationStats& stats = it.value();
+        QVariantMap entry;
+        entry["count"] = stats.count;
+        entry["lastUs"] = stats.lastUs;
+        entry["maxUs"] = stats.maxUs;
+        entry["avgUs"] = stats.count ? stats.totalUs / qint64(stats.count) : 0;
+        report[it.key()] = entry;
+    }
+    return report;
+}
@@ -0,0 +1,71 @@
+// include/widgetregistry.hpp
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QUrl>
+#include <QVariantMap>
+#include <QtQml/qqmlregistration.h>
+
+// The bar segments a theme can place, by name. Built-in widgets live in the
+// Velobar module; a theme adds its own by pointing a name at a QML file.
+// Widgets bind to the shared controllers (topbarController, menuController)
+// and own no timers of their own.
+//
+// Each widget names the data sources it reads ("clock", "network"). Hosts
+// acquire them while an instance is visible and release them when it hides
+// or goes; a source nobody holds is switched off, so a widget that is not
+// placed or not shown costs no sampling.
+class WidgetRegistry : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Use topbarController.widgets")
+    Q_PROPERTY(QStringList names READ names NOTIFY widgetsChanged)
+
+public:
+    struct Widget {
+        QUrl source;
+        QStringList sources; // Data sources the widget reads
+    };
+
+    struct CreationStats {
+        quint64 count = 0;
+        qint64 lastUs = 0;
+        qint64 maxUs = 0;
+        qint64 totalUs = 0;
+    };
+
+    explicit WidgetRegistry(QObject* parent = nullptr);
+
+    // The layout used when the theme does not set one
+    static QStringList defaultLayout();
+
+    void registerWidget(const QString& name, const QUrl& source, const QStringList& sources = QStringList());
+    // Replaces the theme's widgets with plugins (name -> QML file); paths
+    // are resolved against baseDirectory. Built-in names cannot be taken.
+    void setPlugins(const QVariantMap& plugins, const QString& baseDirectory);
+
+    QStringList names() const { return m_widgets.keys(); }
+    bool contains(const QString& name) const { return m_widgets.contains(name); }
+    Widget widget(const QString& name) const { return m_widgets.value(name); }
+
+    void acquire(const QStringList& sources);
+    void release(const QStringList& sources);
+    bool isWanted(const QString& source) const { return m_demand.value(source) > 0; }
+
+    // Time from requesting an instance until it was complete
+    void recordCreation(const QString& name, qint64 elapsedUs);
+    // name -> { count, lastUs, maxUs, avgUs }, for QML or logging
+    Q_INVOKABLE QVariantMap creationReport() const;
+
+signals:
+    void widgetsChanged();
+    void sourceWanted(const QString& source, bool wanted);
+
+private:
+    QHash<QString, Widget> m_widgets;
+    QStringList m_pluginNames; // Names added by setPlugins()
+    QHash<QString, int> m_demand; // Source -> visible instances reading it
+    QHash<QString, CreationStats> m_creation;
+};
@@ -7,6 +7,7 @@
 
 namespace CustomAccent {
 // Accent constants
+static const DWORD ACCENT_DISABLED = 0;
 static const DWORD ACCENT_ENABLE_BLURBEHIND = 3;
 static const DWORD WCA_ACCENT_POLICY = 19;
 }
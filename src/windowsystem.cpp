@@ -0,0 +1,830 @@
+// src/windowsystem.cpp
+#include "windowsystem.hpp"
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#include <memory>
+#include <string>
+#include <vector>
+#endif
+
+#ifdef VELOBAR_DBUSMENU
+#include <QDateTime>
+#include "dbusmenuclient.hpp"
+#include "x11connection.hpp"
+
+namespace {
+// dbusmenu properties as the MFS_* bits the rest of the menu code expects
+const quint32 kStateDisabled = 0x3;
+const quint32 kStateChecked = 0x8;
+
+quint32 stateFromProperties(const QVariantMap& properties)
+{
+    quint32 state = 0;
+    if (!properties.value(QStringLiteral("enabled"), true).toBool()) {
+        state |= kStateDisabled;
+    }
+    if (properties.value(QStringLiteral("toggle-state")).toInt() == 1) {
+        state |= kStateChecked;
+    }
+    return state;
+}
+}
+#endif
+
+WindowSystem* WindowSystem::create()
+{
+#if defined(Q_OS_WIN)
+    return new Win32WindowSystem;
+#elif defined(VELOBAR_DBUSMENU)
+    return new DBusMenuWindowSystem;
+#else
+    return new FakeWindowSystem;
+#endif
+}
+
+FakeWindowSystem::FakeWindowSystem()
+    : m_activeWindow(0)
+    , m_nextHandle(0x1000)
+    , m_nextCommand(100)
+{
+}
+
+quintptr FakeWindowSystem::addWindow(const QString& title, const QString& processName, quint64 menuBar)
+{
+    QMutexLocker locker(&m_mutex);
+
+    Window window;
+    window.title = title;
+    window.processName = processName;
+    window.menuBar = menuBar;
+
+    auto pid = m_processIds.constFind(processName);
+    window.processId = pid != m_processIds.constEnd() ? pid.value() : quint32(m_processIds.size() + 1000);
+    m_processIds.insert(processName, window.processId);
+
+    quintptr handle = quintptr(m_nextHandle++);
+    m_windows.insert(handle, window);
+    return handle;
+}
+
+void FakeWindowSystem::removeWindow(quintptr window)
+{
+    QMutexLocker locker(&m_mutex);
+    m_windows.remove(window);
+}
+
+void FakeWindowSystem::setWindowTitle(quintptr window, const QString& title)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_windows.find(window);
+    if (it != m_windows.end()) {
+        it->title = title;
+    }
+}
+
+void FakeWindowSystem::setMenuBar(quintptr window, quint64 menu)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_windows.find(window);
+    if (it != m_windows.end()) {
+        it->menuBar = menu;
+    }
+}
+
+quint64 FakeWindowSystem::addMenu()
+{
+    QMutexLocker locker(&m_mutex);
+    return addMenuLocked();
+}
+
+quint64 FakeWindowSystem::addMenuLocked()
+{
+    quint64 handle = m_nextHandle++;
+    m_menus.insert(handle, QVector<Item>());
+    return handle;
+}
+
+void FakeWindowSystem::addItem(quint64 menu, const QString& label, quint32 commandId,
+                               quint32 state, quint64 submenu)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_menus.find(menu);
+    if (it == m_menus.end()) {
+        return;
+    }
+
+    Item item;
+    item.label = label;
+    item.commandId = commandId;
+    item.state = state;
+    item.submenu = submenu;
+    it->append(item);
+}
+
+void FakeWindowSystem::addSeparator(quint64 menu)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_menus.find(menu);
+    if (it == m_menus.end()) {
+        return;
+    }
+
+    Item item;
+    item.separator = true;
+    it->append(item);
+}
+
+quint64 FakeWindowSystem::generateMenu(int width, int depth, int labelLength, quint32 seed)
+{
+    QMutexLocker locker(&m_mutex);
+    return generateLevel(qMax(1, width), qMax(1, depth), qMax(1, labelLength), seed);
+}
+
+quint64 FakeWindowSystem::generateLevel(int width, int depth, int labelLength, quint32& seed)
+{
+    quint64 menu = addMenuLocked();
+    QVector<Item> items;
+    items.reserve(width);
+
+    for (int i = 0; i < width; ++i) {
+        Item item;
+        if (i % 8 == 7) {
+            item.separator = true;
+            items.append(item);
+            continue;
+        }
+
+        // Lowercase letters from an LCG, unique enough to avoid repeats
+        item.label.reserve(labelLength);
+        for (int c = 0; c < labelLength; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            item.label.append(QLatin1Char(char('a' + (seed >> 24) % 26)));
+        }
+        item.commandId = m_nextCommand++;
+        if (depth > 1) {
+            item.submenu = generateLevel(width, depth - 1, labelLength, seed);
+        }
+        items.append(item);
+    }
+
+    m_menus[menu] = items;
+    return menu;
+}
+
+QVector<QPair<quintptr, quint32>> FakeWindowSystem::takePostedCommands()
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<QPair<quintptr, quint32>> posted;
+    posted.swap(m_posted);
+    return posted;
+}
+
+quintptr FakeWindowSystem::activeWindow() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_activeWindow;
+}
+
+bool FakeWindowSystem::isWindow(quintptr window) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_windows.contains(window);
+}
+
+QString FakeWindowSystem::windowTitle(quintptr window) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_windows.value(window).title;
+}
+
+quint32 FakeWindowSystem::processId(quintptr window) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_windows.value(window).processId;
+}
+
+bool FakeWindowSystem::processImage(quintptr window, QString& path, qint64& modified) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_windows.constFind(window);
+    if (it == m_windows.constEnd()) {
+        return false;
+    }
+    path = QStringLiteral("/fake/%1.exe").arg(it->processName);
+    modified = 0;
+    return true;
+}
+
+QString FakeWindowSystem::describeExecutable(const QString& path) const
+{
+    return QFileInfo(path).completeBaseName();
+}
+
+quint64 FakeWindowSystem::menuBar(quintptr window) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_windows.value(window).menuBar;
+}
+
+int FakeWindowSystem::menuItemCount(quint64 menu) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_menus.constFind(menu);
+    return it != m_menus.constEnd() ? it->size() : -1;
+}
+
+bool FakeWindowSystem::readMenuItem(quint64 menu, int position, MenuItemRecord& record, QString& text) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_menus.constFind(menu);
+    if (it == m_menus.constEnd() || position < 0 || position >= it->size()) {
+        return false;
+    }
+
+    const Item& item = it->at(position);
+    record.commandId = item.commandId;
+    record.state = item.state;
+    record.flags = 0;
+    record.submenu = 0;
+
+    if (item.separator) {
+        record.flags |= MenuItemRecord::Separator;
+        text.clear();
+        return true;
+    }
+    if (item.label.isEmpty()) {
+        return false;
+    }
+
+    // Same mnemonic stripping as the Win32 path
+    text = item.label;
+    text.remove(QLatin1Char('&'));
+
+    if (item.submenu) {
+        record.flags |= MenuItemRecord::HasSubmenu;
+        record.submenu = item.submenu;
+    }
+    return true;
+}
+
+bool FakeWindowSystem::readMenuItemState(quint64 menu, int position, quint32& commandId, quint32& state) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_menus.constFind(menu);
+    if (it == m_menus.constEnd() || position < 0 || position >= it->size()) {
+        return false;
+    }
+
+    const Item& item = it->at(position);
+    if (!item.separator && item.label.isEmpty()) {
+        return false;
+    }
+    commandId = item.commandId;
+    state = item.state;
+    return true;
+}
+
+bool FakeWindowSystem::hasCommand(quint64 menu, quint32 commandId) const
+{
+    QMutexLocker locker(&m_mutex);
+    return hasCommandLocked(menu, commandId);
+}
+
+bool FakeWindowSystem::hasCommandLocked(quint64 menu, quint32 commandId) const
+{
+    return findCommandLocked(menu, commandId) != nullptr;
+}
+
+const FakeWindowSystem::Item* FakeWindowSystem::findCommandLocked(quint64 menu, quint32 commandId) const
+{
+    auto it = m_menus.constFind(menu);
+    if (it == m_menus.constEnd()) {
+        return nullptr;
+    }
+    for (const Item& item : *it) {
+        if (item.commandId == commandId && !item.separator) {
+            return &item;
+        }
+        if (item.submenu) {
+            if (const Item* found = findCommandLocked(item.submenu, commandId)) {
+                return found;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool FakeWindowSystem::readCommandState(quint64 menu, quint32 commandId, quint32& state) const
+{
+    QMutexLocker locker(&m_mutex);
+    const Item* item = findCommandLocked(menu, commandId);
+    if (!item) {
+        return false;
+    }
+    state = item->state;
+    return true;
+}
+
+void FakeWindowSystem::postCommand(quintptr window, quint32 commandId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_posted.append(qMakePair(window, commandId));
+}
+
+void FakeWindowSystem::activate(quintptr window)
+{
+    QMutexLocker locker(&m_mutex);
+    m_activeWindow = window;
+}
+
+#ifdef Q_OS_WIN
+bool Win32WindowSystem::isWindow(quintptr window) const
+{
+    return IsWindow(reinterpret_cast<HWND>(window));
+}
+
+QString Win32WindowSystem::windowTitle(quintptr window) const
+{
+    wchar_t windowTitle[256];
+    int length = GetWindowTextW(reinterpret_cast<HWND>(window), windowTitle, 256);
+    return QString::fromWCharArray(windowTitle, qMax(0, length));
+}
+
+quint32 Win32WindowSystem::processId(quintptr window) const
+{
+    DWORD processId = 0;
+    GetWindowThreadProcessId(reinterpret_cast<HWND>(window), &processId);
+    return processId;
+}
+
+bool Win32WindowSystem::processImage(quintptr window, QString& path, qint64& modified) const
+{
+    HANDLE processHandle = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE,
+                                       processId(window));
+    if (!processHandle) {
+        return false;
+    }
+
+    std::unique_ptr<void, decltype(&CloseHandle)> handleGuard(processHandle, CloseHandle);
+
+    wchar_t filePath[MAX_PATH];
+    if (!GetModuleFileNameEx(processHandle, nullptr, filePath, MAX_PATH)) {
+        return false;
+    }
+    path = QString::fromWCharArray(filePath);
+
+    // A rebuilt or updated binary gets a new modification time
+    modified = 0;
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (GetFileAttributesExW(filePath, GetFileExInfoStandard, &attributes)) {
+        modified = (qint64(attributes.ftLastWriteTime.dwHighDateTime) << 32)
+            | attributes.ftLastWriteTime.dwLowDateTime;
+    }
+    return true;
+}
+
+QString Win32WindowSystem::describeExecutable(const QString& path) const
+{
+    const std::wstring filePath = path.toStdWString();
+
+    // First try to get version info description
+    DWORD dummy;
+    DWORD fileInfoSize = GetFileVersionInfoSize(filePath.c_str(), &dummy);
+    if (fileInfoSize > 0) {
+        std::vector<BYTE> fileInfoBuffer(fileInfoSize);
+        if (GetFileVersionInfo(filePath.c_str(), 0, fileInfoSize, fileInfoBuffer.data())) {
+            struct LANGANDCODEPAGE {
+                WORD language;
+                WORD codePage;
+            } *translations;
+            UINT translationsLen = 0;
+
+            // Get list of languages
+            if (VerQueryValue(fileInfoBuffer.data(), L"\\VarFileInfo\\Translation",
+                (LPVOID*)&translations, &translationsLen)) {
+
+                // Try different version info strings in order of preference
+                const wchar_t* queries[] = {
+                    L"FileDescription",
+                    L"ProductName",
+                    L"OriginalFilename"
+                };
+
+                for (const auto& query : queries) {
+                    for (UINT i = 0; i < translationsLen / sizeof(LANGANDCODEPAGE); i++) {
+                        wchar_t subBlock[128];
+                        _snwprintf_s(subBlock, _countof(subBlock), _TRUNCATE,
+                            L"\\StringFileInfo\\%04x%04x\\%s",
+                            translations[i].language,
+                            translations[i].codePage,
+                            query);
+
+                        LPWSTR value = nullptr;
+                        UINT len = 0;
+                        if (VerQueryValue(fileInfoBuffer.data(), subBlock, (LPVOID*)&value, &len) && value && len > 0) {
+                            QString friendly = QString::fromWCharArray(value).trimmed();
+                            if (!friendly.isEmpty()) {
+                                return friendly;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return QString();
+}
+
+quint64 Win32WindowSystem::menuBar(quintptr window) const
+{
+    return reinterpret_cast<quint64>(GetMenu(reinterpret_cast<HWND>(window)));
+}
+
+int Win32WindowSystem::menuItemCount(quint64 menu) const
+{
+    return GetMenuItemCount(reinterpret_cast<HMENU>(menu));
+}
+
+bool Win32WindowSystem::readMenuItem(quint64 menu, int position, MenuItemRecord& record, QString& text) const
+{
+    try {
+        HMENU hmenu = reinterpret_cast<HMENU>(menu);
+        MENUITEMINFO mii = { sizeof(MENUITEMINFO) };
+        mii.fMask = MIIM_FTYPE | MIIM_STATE | MIIM_ID | MIIM_SUBMENU;
+
+        if (!GetMenuItemInfo(hmenu, position, TRUE, &mii)) {
+            return false;
+        }
+
+        record.commandId = mii.wID;
+        record.state = mii.fState;
+        record.flags = 0;
+        record.submenu = 0;
+
+        // Check if separator
+        if (mii.fType & MFT_SEPARATOR) {
+            record.flags |= MenuItemRecord::Separator;
+            text.clear();
+            return true;
+        }
+
+        // Most labels fit on the stack; only long ones need the heap
+        wchar_t stackBuffer[128];
+        int length = GetMenuStringW(hmenu, position, stackBuffer, _countof(stackBuffer), MF_BYPOSITION);
+        if (length == 0) {
+            return false;
+        }
+
+        if (length >= int(_countof(stackBuffer)) - 1) {
+            length = GetMenuStringW(hmenu, position, nullptr, 0, MF_BYPOSITION);
+            std::wstring buffer(length + 1, 0);
+            length = GetMenuStringW(hmenu, position, &buffer[0], length + 1, MF_BYPOSITION);
+            text = QString::fromWCharArray(buffer.c_str(), length);
+        } else {
+            text = QString::fromWCharArray(stackBuffer, length);
+        }
+
+        // Remove & from text
+        text.remove(QLatin1Char('&'));
+
+        if (mii.hSubMenu) {
+            record.flags |= MenuItemRecord::HasSubmenu;
+            record.submenu = reinterpret_cast<quint64>(mii.hSubMenu);
+        }
+
+        return true;
+    }
+    catch (const std::exception& e) {
+        qDebug() << "Error reading menu item:" << e.what();
+        return false;
+    }
+}
+
+bool Win32WindowSystem::readMenuItemState(quint64 menu, int position, quint32& commandId, quint32& state) const
+{
+    // One call: with no buffer, MIIM_STRING only reports the label length,
+    // which is all it takes to skip the items readMenuItem() skips
+    MENUITEMINFO mii = { sizeof(MENUITEMINFO) };
+    mii.fMask = MIIM_FTYPE | MIIM_STATE | MIIM_ID | MIIM_STRING;
+    mii.dwTypeData = nullptr;
+
+    if (!GetMenuItemInfo(reinterpret_cast<HMENU>(menu), position, TRUE, &mii)) {
+        return false;
+    }
+    if (!(mii.fType & MFT_SEPARATOR) && mii.cch == 0) {
+        return false;
+    }
+
+    commandId = mii.wID;
+    state = mii.fState;
+    return true;
+}
+
+bool Win32WindowSystem::hasCommand(quint64 menu, quint32 commandId) const
+{
+    // MF_BYCOMMAND searches submenus too
+    return GetMenuState(reinterpret_cast<HMENU>(menu), commandId, MF_BYCOMMAND) != UINT(-1);
+}
+
+bool Win32WindowSystem::readCommandState(quint64 menu, quint32 commandId, quint32& state) const
+{
+    MENUITEMINFO mii = { sizeof(MENUITEMINFO) };
+    mii.fMask = MIIM_STATE;
+    if (!GetMenuItemInfo(reinterpret_cast<HMENU>(menu), commandId, FALSE, &mii)) {
+        return false;
+    }
+    state = mii.fState;
+    return true;
+}
+
+void Win32WindowSystem::postCommand(quintptr window, quint32 commandId)
+{
+    PostMessage(reinterpret_cast<HWND>(window), WM_COMMAND, commandId, 0);
+}
+
+void Win32WindowSystem::activate(quintptr window)
+{
+    SetForegroundWindow(reinterpret_cast<HWND>(window));
+}
+#endif
+
+#ifdef VELOBAR_DBUSMENU
+DBusMenuWindowSystem::DBusMenuWindowSystem(const QDBusConnection& bus)
+    : m_bus(bus)
+    , m_x11(new X11Connection)
+    , m_context(new QObject)
+    , m_registrar(new AppMenuRegistrar(bus, m_context.get()))
+{
+    QObject::connect(m_registrar, &AppMenuRegistrar::windowChanged, m_context.get(), [this](quint32 window) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_windowClients.remove(window);
+        }
+        notifyMenuChanged(window);
+    });
+}
+
+DBusMenuWindowSystem::~DBusMenuWindowSystem()
+{
+    // Clients are created off the GUI thread, so they have no parent
+    qDeleteAll(m_clients);
+    m_clients.clear();
+}
+
+DBusMenuClient* DBusMenuWindowSystem::clientForWindow(quintptr window, quint32* number) const
+{
+    DBusMenuClient* client = nullptr;
+    quint32 clientNumber = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_windowClients.constFind(window);
+        if (it != m_windowClients.constEnd()) {
+            clientNumber = it.value();
+            client = m_clients.at(clientNumber - 1);
+        }
+    }
+
+    if (!client) {
+        QString service;
+        QString path;
+        if (!m_registrar->menuForWindow(quint32(window), service, path)) {
+            return nullptr;
+        }
+
+        QMutexLocker locker(&m_mutex);
+        const QString clientKey = service + path;
+        clientNumber = m_clientNumbers.value(clientKey);
+        if (!clientNumber) {
+            client = new DBusMenuClient(m_bus, service, path);
+            client->moveToThread(m_context->thread());
+            m_clients.append(client);
+            clientNumber = quint32(m_clients.size());
+            m_clientNumbers.insert(clientKey, clientNumber);
+
+            QObject::connect(client, &DBusMenuClient::propertiesChanged, m_context.get(),
+                             [this, clientNumber](const QVector<int>& ids, bool stateOnly) {
+                                 if (stateOnly) {
+                                     onMenuStateChanged(clientNumber, ids);
+                                 } else {
+                                     onMenuChanged(clientNumber);
+                                 }
+                             });
+            QObject::connect(client, &DBusMenuClient::layoutChanged, m_context.get(), [this, clientNumber]() {
+                onMenuChanged(clientNumber);
+            });
+        }
+        client = m_clients.at(clientNumber - 1);
+        m_windowClients.insert(window, clientNumber);
+    }
+
+    // The whole layout, once per exporter; changes arrive as signals
+    if (!client->isLoaded() && !client->load()) {
+        return nullptr;
+    }
+    if (number) {
+        *number = clientNumber;
+    }
+    return client;
+}
+
+DBusMenuClient* DBusMenuWindowSystem::clientForMenu(quint64 menu) const
+{
+    quint32 number = quint32(menu >> 32);
+    QMutexLocker locker(&m_mutex);
+    return number && number <= quint32(m_clients.size()) ? m_clients.at(number - 1) : nullptr;
+}
+
+QVector<quintptr> DBusMenuWindowSystem::windowsOf(quint32 number) const
+{
+    QVector<quintptr> windows;
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_windowClients.constBegin(); it != m_windowClients.constEnd(); ++it) {
+        if (it.value() == number) {
+            windows.append(it.key());
+        }
+    }
+    return windows;
+}
+
+void DBusMenuWindowSystem::onMenuChanged(quint32 number) const
+{
+    const QVector<quintptr> windows = windowsOf(number);
+    for (quintptr window : windows) {
+        notifyMenuChanged(window);
+    }
+}
+
+void DBusMenuWindowSystem::onMenuStateChanged(quint32 number, const QVector<int>& ids) const
+{
+    // dbusmenu item ids are the command ids readMenuItem() hands out
+    QVector<quint32> commandIds;
+    commandIds.reserve(ids.size());
+    for (int id : ids) {
+        commandIds.append(quint32(id));
+    }
+
+    const QVector<quintptr> windows = windowsOf(number);
+    for (quintptr window : windows) {
+        notifyMenuStateChanged(window, commandIds);
+    }
+}
+
+bool DBusMenuWindowSystem::isWindow(quintptr window) const
+{
+    return m_x11->windowExists(quint32(window));
+}
+
+QString DBusMenuWindowSystem::windowTitle(quintptr window) const
+{
+    return m_x11->windowTitle(quint32(window));
+}
+
+quint32 DBusMenuWindowSystem::processId(quintptr window) const
+{
+    return m_x11->cardinal(quint32(window), m_x11->atom("_NET_WM_PID"));
+}
+
+bool DBusMenuWindowSystem::processImage(quintptr window, QString& path, qint64& modified) const
+{
+    quint32 pid = processId(window);
+    if (!pid) {
+        return false;
+    }
+
+    path = QFileInfo(QStringLiteral("/proc/%1/exe").arg(pid)).symLinkTarget();
+    if (path.isEmpty()) {
+        return false;
+    }
+    modified = QFileInfo(path).lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+QString DBusMenuWindowSystem::describeExecutable(const QString&) const
+{
+    // ELF binaries carry no friendly name; the file name is used instead
+    return QString();
+}
+
+quint64 DBusMenuWindowSystem::menuBar(quintptr window) const
+{
+    quint32 number = 0;
+    return clientForWindow(window, &number) ? quint64(number) << 32 : 0;
+}
+
+int DBusMenuWindowSystem::menuItemCount(quint64 menu) const
+{
+    DBusMenuClient* client = clientForMenu(menu);
+    if (!client) {
+        return -1;
+    }
+
+    // Exporters may fill a submenu only when it is about to open
+    int id = int(quint32(menu));
+    if (id != 0) {
+        client->aboutToShow(id);
+    }
+    return client->childCount(id);
+}
+
+bool DBusMenuWindowSystem::readMenuItem(quint64 menu, int position, MenuItemRecord& record, QString& text) const
+{
+    DBusMenuClient* client = clientForMenu(menu);
+    int id = 0;
+    QVariantMap properties;
+    if (!client || !client->child(int(quint32(menu)), position, id, properties)) {
+        return false;
+    }
+    if (!properties.value(QStringLiteral("visible"), true).toBool()) {
+        return false;
+    }
+
+    record.commandId = quint32(id);
+    record.state = 0;
+    record.flags = 0;
+    record.submenu = 0;
+
+    if (properties.value(QStringLiteral("type")).toString() == QLatin1String("separator")) {
+        record.flags |= MenuItemRecord::Separator;
+        text.clear();
+        return true;
+    }
+
+    text = DBusMenuClient::plainLabel(properties.value(QStringLiteral("label")).toString());
+    if (text.isEmpty()) {
+        return false;
+    }
+    // Same "label<tab>accelerator" form as Win32 menu strings
+    QString shortcut = DBusMenuClient::shortcutText(properties.value(QStringLiteral("shortcut")));
+    if (!shortcut.isEmpty()) {
+        text += QLatin1Char('\t') + shortcut;
+    }
+
+    record.state = stateFromProperties(properties);
+    if (properties.value(QStringLiteral("children-display")).toString() == QLatin1String("submenu")
+        || client->childCount(id) > 0) {
+        record.flags |= MenuItemRecord::HasSubmenu;
+        record.submenu = (menu & Q_UINT64_C(0xffffffff00000000)) | quint32(id);
+    }
+    return true;
+}
+
+bool DBusMenuWindowSystem::readMenuItemState(quint64 menu, int position, quint32& commandId, quint32& state) const
+{
+    DBusMenuClient* client = clientForMenu(menu);
+    int id = 0;
+    QVariantMap properties;
+    if (!client || !client->child(int(quint32(menu)), position, id, properties)) {
+        return false;
+    }
+    if (!properties.value(QStringLiteral("visible"), true).toBool()) {
+        return false;
+    }
+
+    commandId = quint32(id);
+    state = 0;
+    if (properties.value(QStringLiteral("type")).toString() == QLatin1String("separator")) {
+        return true;
+    }
+    if (DBusMenuClient::plainLabel(properties.value(QStringLiteral("label")).toString()).isEmpty()) {
+        return false;
+    }
+
+    state = stateFromProperties(properties);
+    return true;
+}
+
+bool DBusMenuWindowSystem::hasCommand(quint64 menu, quint32 commandId) const
+{
+    DBusMenuClient* client = clientForMenu(menu);
+    return client && client->contains(int(commandId));
+}
+
+bool DBusMenuWindowSystem::readCommandState(quint64 menu, quint32 commandId, quint32& state) const
+{
+    DBusMenuClient* client = clientForMenu(menu);
+    QVariantMap properties;
+    if (!client || !client->properties(int(commandId), properties)) {
+        return false;
+    }
+    state = stateFromProperties(properties);
+    return true;
+}
+
+void DBusMenuWindowSystem::postCommand(quintptr window, quint32 commandId)
+{
+    if (DBusMenuClient* client = clientForWindow(window)) {
+        client->sendEvent(int(commandId), QStringLiteral("clicked"));
+    }
+}
+
+void DBusMenuWindowSystem::activate(quintptr window)
+{
+    m_x11->activateWindow(quint32(window));
+}
+#endif // VELOBAR_DBUSMENU
@@ -0,0 +1,235 @@
+// include/windowsystem.hpp
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include "menutree.hpp"
+
+#ifdef VELOBAR_DBUSMENU
+#include <QDBusConnection>
+#include <QObject>
+
+class AppMenuRegistrar;
+class DBusMenuClient;
+class X11Connection;
+#endif
+
+// The window, menu and process queries the menu code makes. Windows and
+// menus are opaque handles: HWND and HMENU values on Windows, small ids in
+// the fake. Implementations must be callable from the snapshot thread and
+// the GUI thread at once.
+class WindowSystem {
+public:
+    virtual ~WindowSystem() = default;
+
+    virtual bool isWindow(quintptr window) const = 0;
+    virtual QString windowTitle(quintptr window) const = 0;
+    virtual quint32 processId(quintptr window) const = 0;
+    // Executable of the window's process and its modification time
+    virtual bool processImage(quintptr window, QString& path, qint64& modified) const = 0;
+    // Name from the executable's version resource, empty when it has none
+    virtual QString describeExecutable(const QString& path) const = 0;
+
+    // 0 when the window has no menu bar
+    virtual quint64 menuBar(quintptr window) const = 0;
+    // -1 when menu is not a valid menu
+    virtual int menuItemCount(quint64 menu) const = 0;
+    // Fills record and text for one item; false for items without a label.
+    // Leaves parent links and level to the caller.
+    virtual bool readMenuItem(quint64 menu, int position, MenuItemRecord& record, QString& text) const = 0;
+    // Command id and MFS_* state of one item, without copying its label.
+    // False for the same items readMenuItem() skips, so positions line up
+    // with an enumeration of the same menu.
+    virtual bool readMenuItemState(quint64 menu, int position, quint32& commandId, quint32& state) const = 0;
+    // Whether commandId is still somewhere in menu or its submenus
+    virtual bool hasCommand(quint64 menu, quint32 commandId) const = 0;
+    // MFS_* state of commandId in menu or its submenus; false when absent
+    virtual bool readCommandState(quint64 menu, quint32 commandId, quint32& state) const = 0;
+
+    virtual void postCommand(quintptr window, quint32 commandId) = 0;
+    virtual void activate(quintptr window) = 0;
+
+    // Called on the GUI thread with a window whose menu changed while it
+    // kept focus. Only backends told about menu edits call it.
+    using MenuChangedHandler = std::function<void(quintptr window)>;
+    void setMenuChangedHandler(MenuChangedHandler handler) { m_menuChangedHandler = std::move(handler); }
+    // Same, when only the state of the given commands changed: labels and
+    // structure are as they were, so re-reading the states is enough
+    using MenuStateChangedHandler = std::function<void(quintptr window, const QVector<quint32>& commandIds)>;
+    void setMenuStateChangedHandler(MenuStateChangedHandler handler)
+    {
+        m_menuStateChangedHandler = std::move(handler);
+    }
+
+    // Creates the implementation for the running platform
+    static WindowSystem* create();
+
+protected:
+    void notifyMenuChanged(quintptr window) const
+    {
+        if (m_menuChangedHandler) {
+            m_menuChangedHandler(window);
+        }
+    }
+    void notifyMenuStateChanged(quintptr window, const QVector<quint32>& commandIds) const
+    {
+        if (m_menuStateChangedHandler) {
+            m_menuStateChangedHandler(window, commandIds);
+        }
+    }
+
+private:
+    MenuChangedHandler m_menuChangedHandler;
+    MenuStateChangedHandler m_menuStateChangedHandler;
+};
+
+// In-memory window system for running the menu code without Win32, e.g.
+// benchmarks and replays. Menus can be built item by item or generated.
+class FakeWindowSystem : public WindowSystem {
+public:
+    FakeWindowSystem();
+
+    quintptr addWindow(const QString& title, const QString& processName, quint64 menuBar = 0);
+    void removeWindow(quintptr window);
+    void setWindowTitle(quintptr window, const QString& title);
+    void setMenuBar(quintptr window, quint64 menu);
+
+    quint64 addMenu();
+    void addItem(quint64 menu, const QString& label, quint32 commandId,
+                 quint32 state = 0, quint64 submenu = 0);
+    void addSeparator(quint64 menu);
+    // A menu with width items per level, depth levels deep, and labels of
+    // labelLength characters. Every eighth item is a separator. Same seed,
+    // same tree.
+    quint64 generateMenu(int width, int depth, int labelLength, quint32 seed = 1);
+
+    // Commands posted since the last call, oldest first
+    QVector<QPair<quintptr, quint32>> takePostedCommands();
+    quintptr activeWindow() const;
+
+    bool isWindow(quintptr window) const override;
+    QString windowTitle(quintptr window) const override;
+    quint32 processId(quintptr window) const override;
+    bool processImage(quintptr window, QString& path, qint64& modified) const override;
+    QString describeExecutable(const QString& path) const override;
+
+    quint64 menuBar(quintptr window) const override;
+    int menuItemCount(quint64 menu) const override;
+    bool readMenuItem(quint64 menu, int position, MenuItemRecord& record, QString& text) const override;
+    bool readMenuItemState(quint64 menu, int position, quint32& commandId, quint32& state) const override;
+    bool hasCommand(quint64 menu, quint32 commandId) const override;
+    bool readCommandState(quint64 menu, quint32 commandId, quint32& state) const override;
+
+    void postCommand(quintptr window, quint32 commandId) override;
+    void activate(quintptr window) override;
+
+private:
+    struct Item {
+        QString label;
+        quint32 commandId = 0;
+        quint32 state = 0;
+        bool separator = false;
+        quint64 submenu = 0;
+    };
+
+    struct Window {
+        QString title;
+        QString processName;
+        quint32 processId = 0;
+        quint64 menuBar = 0;
+    };
+
+    // Callers hold m_mutex
+    quint64 addMenuLocked();
+    quint64 generateLevel(int width, int depth, int labelLength, quint32& seed);
+    bool hasCommandLocked(quint64 menu, quint32 commandId) const;
+    const Item* findCommandLocked(quint64 menu, quint32 commandId) const;
+
+private:
+    mutable QMutex m_mutex;
+    QHash<quintptr, Window> m_windows;
+    QHash<quint64, QVector<Item>> m_menus;
+    QHash<QString, quint32> m_processIds; // Process name -> pid
+    QVector<QPair<quintptr, quint32>> m_posted;
+    quintptr m_activeWindow;
+    quint64 m_nextHandle;
+    quint32 m_nextCommand;
+};
+
+#ifdef Q_OS_WIN
+// User32 menus, process image paths and version resources
+class Win32WindowSystem : public WindowSystem {
+public:
+    bool isWindow(quintptr window) const override;
+    QString windowTitle(quintptr window) const override;
+    quint32 processId(quintptr window) const override;
+    bool processImage(quintptr window, QString& path, qint64& modified) const override;
+    QString describeExecutable(const QString& path) const override;
+
+    quint64 menuBar(quintptr window) const override;
+    int menuItemCount(quint64 menu) const override;
+    bool readMenuItem(quint64 menu, int position, MenuItemRecord& record, QString& text) const override;
+    bool readMenuItemState(quint64 menu, int position, quint32& commandId, quint32& state) const override;
+    bool hasCommand(quint64 menu, quint32 commandId) const override;
+    bool readCommandState(quint64 menu, quint32 commandId, quint32& state) const override;
+
+    void postCommand(quintptr window, quint32 commandId) override;
+    void activate(quintptr window) override;
+};
+#endif
+
+#ifdef VELOBAR_DBUSMENU
+// X11 windows whose menus are exported over com.canonical.dbusmenu and
+// looked up through com.canonical.AppMenu.Registrar. A menu handle is the
+// exporter's client number in the high half and a dbusmenu item id in the
+// low half; a command id is an item id. Each exporter's layout is fetched
+// once and then kept current from its change signals (DBusMenuClient).
+//
+// Create on the GUI thread: the exporters' signals are handled there.
+class DBusMenuWindowSystem : public WindowSystem {
+public:
+    explicit DBusMenuWindowSystem(const QDBusConnection& bus = QDBusConnection::sessionBus());
+    ~DBusMenuWindowSystem();
+
+    bool isWindow(quintptr window) const override;
+    QString windowTitle(quintptr window) const override;
+    quint32 processId(quintptr window) const override;
+    bool processImage(quintptr window, QString& path, qint64& modified) const override;
+    QString describeExecutable(const QString& path) const override;
+
+    quint64 menuBar(quintptr window) const override;
+    int menuItemCount(quint64 menu) const override;
+    bool readMenuItem(quint64 menu, int position, MenuItemRecord& record, QString& text) const override;
+    bool readMenuItemState(quint64 menu, int position, quint32& commandId, quint32& state) const override;
+    bool hasCommand(quint64 menu, quint32 commandId) const override;
+    bool readCommandState(quint64 menu, quint32 commandId, quint32& state) const override;
+
+    void postCommand(quintptr window, quint32 commandId) override;
+    void activate(quintptr window) override;
+
+private:
+    // Client exporting window's menu, created and loaded on first use;
+    // number is its handle half
+    DBusMenuClient* clientForWindow(quintptr window, quint32* number = nullptr) const;
+    DBusMenuClient* clientForMenu(quint64 menu) const;
+    void onMenuChanged(quint32 number) const;
+    void onMenuStateChanged(quint32 number, const QVector<int>& ids) const;
+    QVector<quintptr> windowsOf(quint32 number) const;
+
+private:
+    QDBusConnection m_bus;
+    std::unique_ptr<X11Connection> m_x11;
+    std::unique_ptr<QObject> m_context; // GUI thread object the clients live with
+    AppMenuRegistrar* m_registrar;
+
+    mutable QMutex m_mutex;
+    mutable QVector<DBusMenuClient*> m_clients;          // Client number - 1
+    mutable QHash<QString, quint32> m_clientNumbers;     // Service and path -> number
+    mutable QHash<quintptr, quint32> m_windowClients;    // Window -> number
+};
+#endif
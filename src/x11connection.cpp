@@ -0,0 +1,168 @@
+// src/x11connection.cpp
+#include "x11connection.hpp"
+#include <QDebug>
+#include <QMutexLocker>
+#include <xcb/xcb.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+// Titles and PIDs are short; longer values are cut off here
+const quint32 kMaxPropertyWords = 1024;
+// _NET_ACTIVE_WINDOW source indication: a pager, which window managers
+// honour without focus-stealing checks
+const quint32 kSourcePager = 2;
+}
+
+X11Connection::X11Connection()
+    : m_connection(nullptr)
+    , m_root(0)
+{
+    int screenNumber = 0;
+    xcb_connection_t* connection = xcb_connect(nullptr, &screenNumber);
+    if (xcb_connection_has_error(connection)) {
+        qDebug() << "No X display";
+        xcb_disconnect(connection);
+        return;
+    }
+
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator(xcb_get_setup(connection));
+    for (int i = 0; i < screenNumber && screens.rem > 0; ++i) {
+        xcb_screen_next(&screens);
+    }
+    if (!screens.data) {
+        xcb_disconnect(connection);
+        return;
+    }
+    m_root = screens.data->root;
+    m_connection = connection;
+}
+
+X11Connection::~X11Connection()
+{
+    if (m_connection) {
+        xcb_disconnect(m_connection);
+    }
+}
+
+int X11Connection::fileDescriptor() const
+{
+    return m_connection ? xcb_get_file_descriptor(m_connection) : -1;
+}
+
+quint32 X11Connection::atom(const char* name)
+{
+    if (!m_connection) {
+        return 0;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_atoms.constFind(QByteArray::fromRawData(name, int(std::strlen(name))));
+    if (it != m_atoms.constEnd()) {
+        return it.value();
+    }
+
+    xcb_intern_atom_cookie_t cookie = xcb_intern_atom(m_connection, 0, quint16(std::strlen(name)), name);
+    xcb_generic_error_t* error = nullptr;
+    xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(m_connection, cookie, &error);
+    quint32 value = reply ? reply->atom : 0;
+    std::free(reply);
+    std::free(error);
+
+    m_atoms.insert(QByteArray(name), value);
+    return value;
+}
+
+bool X11Connection::windowExists(quint32 window) const
+{
+    if (!m_connection || !window) {
+        return false;
+    }
+    // BadWindow for a window that has gone; taken here so it is not queued
+    // as an event nobody reads
+    xcb_generic_error_t* error = nullptr;
+    xcb_get_window_attributes_reply_t* reply = xcb_get_window_attributes_reply(
+        m_connection, xcb_get_window_attributes(m_connection, window), &error);
+    bool exists = reply != nullptr;
+    std::free(reply);
+    std::free(error);
+    return exists;
+}
+
+QByteArray X11Connection::property(quint32 window, quint32 property, quint32 type) const
+{
+    QByteArray value;
+    if (!m_connection || !window || !property) {
+        return value;
+    }
+
+    xcb_get_property_cookie_t cookie = xcb_get_property(
+        m_connection, 0, window, property, type ? type : quint32(XCB_GET_PROPERTY_TYPE_ANY),
+        0, kMaxPropertyWords);
+    xcb_generic_error_t* error = nullptr;
+    xcb_get_property_reply_t* reply = xcb_get_property_reply(m_connection, cookie, &error);
+    if (reply) {
+        int length = xcb_get_property_value_length(reply);
+        if (length > 0) {
+            value = QByteArray(static_cast<const char*>(xcb_get_property_value(reply)), length);
+        }
+        std::free(reply);
+    }
+    std::free(error);
+    return value;
+}
+
+quint32 X11Connection::cardinal(quint32 window, quint32 property) const
+{
+    QByteArray value = this->property(window, property);
+    if (value.size() < int(sizeof(quint32))) {
+        return 0;
+    }
+    quint32 result = 0;
+    std::memcpy(&result, value.constData(), sizeof(result));
+    return result;
+}
+
+QString X11Connection::windowTitle(quint32 window)
+{
+    QByteArray title = property(window, atom("_NET_WM_NAME"), atom("UTF8_STRING"));
+    if (!title.isEmpty()) {
+        return QString::fromUtf8(title);
+    }
+    return QString::fromLatin1(property(window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING));
+}
+
+void X11Connection::selectPropertyChanges(quint32 window)
+{
+    if (!m_connection) {
+        return;
+    }
+    const quint32 mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+    // Checked and discarded: the window may be gone, and the error would
+    // otherwise sit in the event queue
+    xcb_void_cookie_t cookie = xcb_change_window_attributes_checked(m_connection, window, XCB_CW_EVENT_MASK, &mask);
+    xcb_discard_reply(m_connection, cookie.sequence);
+    xcb_flush(m_connection);
+}
+
+void X11Connection::activateWindow(quint32 window)
+{
+    if (!m_connection) {
+        return;
+    }
+
+    xcb_client_message_event_t event;
+    std::memset(&event, 0, sizeof(event));
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = window;
+    event.type = atom("_NET_ACTIVE_WINDOW");
+    event.data.data32[0] = kSourcePager;
+    event.data.data32[1] = XCB_CURRENT_TIME;
+
+    xcb_void_cookie_t cookie = xcb_send_event_checked(
+        m_connection, 0, m_root, XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY,
+        reinterpret_cast<const char*>(&event));
+    xcb_discard_reply(m_connection, cookie.sequence);
+    xcb_flush(m_connection);
+}
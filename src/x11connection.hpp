@@ -0,0 +1,48 @@
+// include/x11connection.hpp
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+struct xcb_connection_t;
+
+// A private connection to the X server for window properties, with an atom
+// cache. xcb requests are thread-safe, so one connection serves the
+// snapshot thread and the GUI thread at once. Event masks are per
+// connection, so selecting events here leaves Qt's own connection alone.
+// Request errors are taken with the reply rather than queued as events, so
+// a connection nobody polls does not accumulate them.
+class X11Connection {
+public:
+    X11Connection();
+    ~X11Connection();
+
+    // False without an X display, e.g. on Wayland without XWayland
+    bool isOpen() const { return m_connection != nullptr; }
+    xcb_connection_t* connection() const { return m_connection; }
+    quint32 rootWindow() const { return m_root; }
+    int fileDescriptor() const;
+
+    quint32 atom(const char* name);
+
+    bool windowExists(quint32 window) const;
+    // Raw property value, empty when unset; type 0 accepts any type
+    QByteArray property(quint32 window, quint32 property, quint32 type = 0) const;
+    // First 32-bit value of a CARDINAL or WINDOW property, 0 when unset
+    quint32 cardinal(quint32 window, quint32 property) const;
+    // _NET_WM_NAME, falling back to WM_NAME
+    QString windowTitle(quint32 window);
+
+    // Adds PropertyChange to the events this connection gets for window
+    void selectPropertyChanges(quint32 window);
+    // Asks the window manager to raise and focus window
+    void activateWindow(quint32 window);
+
+private:
+    xcb_connection_t* m_connection;
+    quint32 m_root;
+    QMutex m_mutex;
+    QHash<QByteArray, quint32> m_atoms;
+};
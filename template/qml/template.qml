@@ -1 +1,17 @@
-// wait...
\ No newline at end of file
+// template/qml/template.qml
+// Example widget plugin. Declare it in velobar.yaml under theme.plugins and
+// place its name in theme.widgets. A widget is an Item laid out in the bar's
+// RowLayout; it binds to topbarController and menuController rather than
+// running timers of its own.
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+
+Label {
+    color: "white"
+    font.pixelSize: 12
+    font.family: fontManager.family("Regular")
+    Layout.alignment: Qt.AlignVCenter
+    text: topbarController.isOnBattery ? topbarController.batteryLevel + "%" : ""
+    visible: text.length > 0
+}
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# tools/subset_fonts.py
+#
+# Builds the external font bundle (fonts.rcc) loaded by FontManager.
+# Each font is cut down to the configured code point ranges with fontTools
+# when it is installed (pip install fonttools), otherwise copied as is, and
+# the result is packed into a compressed binary resource with rcc.
+#
+#   subset_fonts.py --unicodes U+0020-007E,U+00A0-00FF --rcc rcc \
+#                   --output fonts.rcc res/fonts/*.ttf
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+
+def subset(source, target, unicodes):
+    try:
+        from fontTools import subset as ftsubset
+    except ImportError:
+        return False
+
+    options = ftsubset.Options()
+    options.layout_features = ["*"]
+    options.name_IDs = ["*"]
+    options.notdef_outline = True
+
+    font = ftsubset.load_font(source, options)
+    subsetter = ftsubset.Subsetter(options)
+    subsetter.populate(unicodes=ftsubset.parse_unicodes(unicodes))
+    subsetter.subset(font)
+    ftsubset.save_font(font, target, options)
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Subset and bundle fonts")
+    parser.add_argument("--unicodes", required=True, help="Code points to keep, pyftsubset syntax")
+    parser.add_argument("--rcc", default="rcc", help="Path to Qt's rcc")
+    parser.add_argument("--output", required=True, help="Binary resource to write")
+    parser.add_argument("fonts", nargs="+")
+    args = parser.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix="velobar-fonts-")
+    try:
+        entries = []
+        warned = False
+        before = after = 0
+        for source in args.fonts:
+            name = os.path.basename(source)
+            target = os.path.join(workdir, name)
+            if not subset(source, target, args.unicodes):
+                if not warned:
+                    print("subset_fonts: fontTools not found, bundling full fonts", file=sys.stderr)
+                    warned = True
+                shutil.copyfile(source, target)
+            before += os.path.getsize(source)
+            after += os.path.getsize(target)
+            entries.append('        <file alias="%s">%s</file>' % (name, name))
+
+        qrc = os.path.join(workdir, "fonts.qrc")
+        with open(qrc, "w", encoding="utf-8") as out:
+            out.write("<RCC>\n    <qresource prefix=\"/\">\n")
+            out.write("\n".join(entries))
+            out.write("\n    </qresource>\n</RCC>\n")
+
+        # Fonts compress to about half; zlib for every file regardless of gain
+        subprocess.check_call([args.rcc, "--binary", "--compress", "9", "--threshold", "0",
+                               "--output", os.path.abspath(args.output), qrc], cwd=workdir)
+
+        print("subset_fonts: %d fonts, %d -> %d bytes, bundle %d bytes"
+              % (len(entries), before, after, os.path.getsize(args.output)))
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())